@@ -16,6 +16,7 @@ fine.
 
 # Package Imports
 from hrl import HRL
+from hrl.graphics import timing
 
 # Qualified Imports
 import numpy as np
@@ -179,6 +180,13 @@ def main():
 
     gauss = normalize(makeGaussian(texsize[0], fwhm=80, center=(128, 128)))
 
+    # On VPixx devices, also time frames on the device clock. Onset
+    # timestamps only: a vsync log would pause while they are enabled.
+    onDevice = inlab_siemens or inlab_viewpixx
+    if onDevice:
+        period = timing.RasterModel.from_device().period
+        onsets = hrl.graphics.enable_onset_timestamps()
+
     # timing and drawing 1000 frames
     nDroppedFrames = 0
     firsttimeon = True
@@ -225,6 +233,16 @@ def main():
 
     print("")
     print("total number of dropped frames %d" % nDroppedFrames)
+
+    if onDevice:
+        hrl.graphics.disable_onset_timestamps()
+        print("")
+        print("Device clock")
+        print("refresh rate %f Hz" % (1.0 / period))
+        print(
+            "total number of dropped frames %d"
+            % timing.dropped_frames(onsets.onsets(), period)
+        )
     print("")
     print("Interpretation:")
     print(
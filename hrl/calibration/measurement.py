@@ -57,6 +57,124 @@ def draw_uniform_square(ihrl, intensity, patch_size=0.5):
     patch.draw(patch_position, (patch_width, patch_height))
 
 
+def intensity_to_uint16(ihrl, intensity):
+    """Convert a (gamma corrected) intensity to a 16-bit video DAC value
+
+    Uses the same gamma correction and discretization as the M16 texture
+    path, so that a CLUT entry produces the same luminance as a texture
+    drawn with ``newTexture``.
+
+    Parameters
+    ----------
+    ihrl : HRL
+        the HRL instance whose gamma correction to apply
+    intensity : float
+        intensity (0.0 to 1.0)
+
+    Returns
+    -------
+    int
+        16-bit value (0 to 65535)
+    """
+    value = ihrl.graphics.gamma_correct(np.array([[intensity]]))
+    return int(np.asarray(value * (2**16 - 1), dtype=np.uint32).squeeze())
+
+
+class ClutSquare:
+    """Uniform square patch whose intensity is set through the L48 video CLUT
+
+    A drop-in replacement for `draw_uniform_square` as `stim_draw_func` in
+    `measure_lut`, for VPixx devices. The device is switched to L48 mode,
+    where the red channel of each pixel indexes a 256-entry, 16-bit colour
+    lookup table (CLUT). A single 1x1 texture with CLUT index `index` is
+    created once; each measurement step only rewrites the CLUT, so no new
+    textures are created during the sweep.
+
+    All other CLUT entries hold the background intensity, so the background
+    stays as it was in M16 mode. Call `close()` after measuring to restore
+    the previous video mode and delete the texture.
+
+    Parameters
+    ----------
+    ihrl : HRL
+        the HRL instance to use; its graphics device must be a VPixx device
+    patch_size : float, optional
+        size of the patch as a fraction of the screen, by default 0.5
+    index : int, optional
+        CLUT index of the patch, by default 255
+    """
+
+    def __init__(self, ihrl, patch_size=0.5, index=255):
+        from hrl.graphics.texture import Texture
+
+        self.ihrl = ihrl
+        self.patch_size = patch_size
+
+        # Background: in L48 mode, its M16 high byte becomes its CLUT index
+        background = ihrl.graphics.background
+        if np.ndim(background) == 0:
+            background = np.array([[background]])
+        background_value = intensity_to_uint16(ihrl, background)
+        background_index = background_value // 2**8
+        if index == background_index:
+            index = 254 if index == 255 else index + 1
+        self.index = index
+
+        self.clut = np.full((3, 256), background_value, dtype=np.uint16)
+
+        # Index patch: red channel holds the CLUT index
+        self.texture = Texture(bytes([index, 0, 0, 255]), 1, 1, "square")
+
+        self.device = ihrl.graphics.device
+        self.previous_mode = self.device.getVideoMode()
+        print(f"Setting video mode to L48 (was {self.previous_mode})...")
+        self.device.setVideoMode("L48")
+        self.device.updateRegisterCache()
+
+    def set_intensity(self, intensity):
+        """Write the patch intensity into the device CLUT
+
+        Takes effect at the next vertical blanking interval.
+
+        Parameters
+        ----------
+        intensity : float
+            intensity of the patch (0.0 to 1.0)
+        """
+        from pypixxlib import _libdpx
+
+        self.clut[:, self.index] = intensity_to_uint16(self.ihrl, intensity)
+        _libdpx.DPxSetVidClut(self.clut.tolist())
+        _libdpx.DPxUpdateRegCache()
+
+    def __call__(self, ihrl, intensity):
+        """Draw the index patch, and set its intensity
+
+        Parameters
+        ----------
+        ihrl : HRL
+            the HRL instance to use for drawing the patch
+        intensity : float
+            intensity of the patch (0.0 to 1.0)
+        """
+        screen_width, screen_height = ihrl.graphics.width, ihrl.graphics.height
+        patch_width = screen_width * self.patch_size
+        patch_height = screen_height * self.patch_size
+        patch_position = (
+            (screen_width - patch_width) / 2,
+            (screen_height - patch_height) / 2,
+        )
+        self.texture.draw(patch_position, (patch_width, patch_height))
+        self.set_intensity(intensity)
+
+    def close(self):
+        """Restore the previous video mode, and delete the index texture"""
+        print(f"Restoring video mode {self.previous_mode}...")
+        self.device.setVideoMode(self.previous_mode)
+        self.device.updateRegisterCache()
+        self.texture.delete()
+
+
 def measure_lut(
     ihrl,
     intensities=setup_intensities(0.0, 1.0, 2**16),
@@ -1,10 +1,10 @@
 """HRL Graphics module - display device interfaces."""
 
-from .datapixx import DATAPixx
+from .datapixx import DATAPixx, DATAPixx_L48, DATAPixx_L48D, DATAPixx_M16D
 from .gpu import GPU_RGB, GPU_grey
 from .graphics import Graphics, Graphics_grey, Graphics_RGB
 from .texture import Texture
-from .viewpixx import VIEWPixx_grey, VIEWPixx_RGB
+from .viewpixx import VIEWPixx_C36D, VIEWPixx_C48, VIEWPixx_grey, VIEWPixx_M16D, VIEWPixx_RGB
 
 __all__ = [
     "Graphics",
@@ -13,7 +13,13 @@ __all__ = [
     "GPU_grey",
     "GPU_RGB",
     "DATAPixx",
+    "DATAPixx_L48",
+    "DATAPixx_M16D",
+    "DATAPixx_L48D",
     "VIEWPixx_grey",
+    "VIEWPixx_M16D",
     "VIEWPixx_RGB",
+    "VIEWPixx_C48",
+    "VIEWPixx_C36D",
     "Texture",
 ]
@@ -0,0 +1,195 @@
+"""Texture atlas: many small stimuli packed into a few large textures.
+
+Trials with many small patches (rating scales, triads, text glyphs) would
+otherwise create one GL texture per patch, and bind a different texture for
+every draw. A TextureAtlas packs the encoded patches into large page
+textures with a shelf packer, and returns an AtlasTexture per patch: a
+handle to its sub-rectangle, which draws with the usual
+``draw(pos, sz, rot, rotc)``. Drawn through a Batch, consecutive draws of
+patches on one page are rendered with a single draw call.
+
+Each patch is padded by replicating its edge pixels, so that linear
+filtering at its border does not bleed in neighbouring patches.
+"""
+
+import numpy as np
+import OpenGL.GL as opengl
+
+from hrl.graphics.texture import Texture, loadTexture
+
+
+class ShelfPacker:
+    """Shelf packing of rectangles into a square page.
+
+    Rectangles are placed left to right on horizontal shelves. A rectangle
+    goes onto the shelf that fits it with the least wasted height; if none
+    fits, a new shelf is opened below the last one.
+
+    Parameters
+    ----------
+    size : int
+        width and height of the page in pixels
+    """
+
+    def __init__(self, size):
+        self.size = size
+        self.shelves = []  # [y, height, x of free space]
+        self.bottom = 0
+
+    def insert(self, wdth, hght):
+        """Find space for a rectangle.
+
+        Parameters
+        ----------
+        wdth : int
+            width of the rectangle in pixels
+        hght : int
+            height of the rectangle in pixels
+
+        Returns
+        -------
+        (int, int) or None
+            (x, y) of the upper left corner, or None if the page is full
+        """
+        if wdth > self.size or hght > self.size:
+            return None
+
+        best = None
+        for shelf in self.shelves:
+            y, height, x = shelf
+            if hght <= height and x + wdth <= self.size:
+                if best is None or height < best[1]:
+                    best = shelf
+
+        if best is None:
+            if self.bottom + hght > self.size:
+                return None
+            best = [self.bottom, hght, 0]
+            self.shelves.append(best)
+            self.bottom += hght
+
+        position = (best[2], best[0])
+        best[2] += wdth
+        return position
+
+
+class AtlasTexture(Texture):
+    """A sub-rectangle of a TextureAtlas page, drawn like a Texture.
+
+    Deleting an AtlasTexture only deletes its display list; its space in the
+    atlas is freed with TextureAtlas.delete().
+    """
+
+    def __init__(self, txid, wdth, hght, region):
+        self.shape = "square"
+        self._slot = None
+        self._txid = txid
+        self._dlid = None
+        self.wdth = wdth
+        self.hght = hght
+        self.region = region
+
+    def delete(self):
+        """Remove the display list of this texture (not its atlas page)"""
+        if self._dlid != None:
+            opengl.glDeleteLists(self._dlid, 1)
+            self._dlid = None
+        self._txid = None
+
+
+class TextureAtlas:
+    """Packs small encoded stimuli into a few large page textures.
+
+    Create with Graphics.newAtlas().
+
+    Parameters
+    ----------
+    encode : callable
+        encodes an image array into uint8 RGBA pixels of shape (H, W, 4),
+        e.g., Graphics.encode_image
+    size : int, optional
+        width and height of each page texture in pixels, by default 2048
+    padding : int, optional
+        pixels of replicated edge around each patch, by default 1
+
+    Attributes
+    ----------
+    pages : list of (int, ShelfPacker)
+        GL texture id and packer of each page
+    """
+
+    def __init__(self, encode, size=2048, padding=1):
+        self.encode = encode
+        self.size = size
+        self.padding = padding
+        self.pages = []
+
+    def add(self, arr):
+        """Encode an image array and pack it into the atlas.
+
+        Parameters
+        ----------
+        arr : ndarray
+            input image array with values in [0.0, 1.0], as for newTexture
+
+        Returns
+        -------
+        AtlasTexture
+            handle with draw(pos, sz, rot, rotc), as a Texture. Always drawn
+            as a square: circular apertures need a texture of their own.
+
+        Raises
+        ------
+        ValueError
+            if the padded image does not fit on a page
+        """
+        pixels = self.encode(arr)
+        hght, wdth = pixels.shape[:2]
+        pad = self.padding
+        if pad:
+            pixels = np.pad(pixels, ((pad, pad), (pad, pad), (0, 0)), mode="edge")
+
+        txid, x, y = self._place(pixels.shape[1], pixels.shape[0])
+        opengl.glBindTexture(opengl.GL_TEXTURE_2D, txid)
+        opengl.glTexSubImage2D(
+            opengl.GL_TEXTURE_2D,
+            0,
+            x,
+            y,
+            pixels.shape[1],
+            pixels.shape[0],
+            opengl.GL_RGBA,
+            opengl.GL_UNSIGNED_BYTE,
+            np.ascontiguousarray(pixels).tobytes(),
+        )
+
+        region = (
+            (x + pad) / self.size,
+            (y + pad) / self.size,
+            wdth / self.size,
+            hght / self.size,
+        )
+        return AtlasTexture(txid, wdth, hght, region)
+
+    def _place(self, wdth, hght):
+        for txid, packer in self.pages:
+            position = packer.insert(wdth, hght)
+            if position is not None:
+                return (txid, *position)
+
+        packer = ShelfPacker(self.size)
+        position = packer.insert(wdth, hght)
+        if position is None:
+            raise ValueError(
+                f"Image of {wdth}x{hght} pixels (padded) does not fit into atlas pages of "
+                f"{self.size}x{self.size}"
+            )
+        txid, _, _ = loadTexture(None, self.size, self.size)
+        self.pages.append((txid, packer))
+        return (txid, *position)
+
+    def delete(self):
+        """Delete all page textures. Their AtlasTextures cannot be drawn anymore."""
+        for txid, _ in self.pages:
+            opengl.glDeleteTextures(1, [txid])
+        self.pages = []
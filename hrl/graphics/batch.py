@@ -0,0 +1,251 @@
+"""Batched, instanced rendering of many textures.
+
+Texture.draw() renders through a display list per texture, and sets up the
+modelview matrix with glTranslate/glRotate/glScalef for every call. For
+displays with many elements (search arrays, matching tasks with dozens of
+patches) a Batch is faster: it collects the draws of a frame, and renders
+all instances of a texture with one instanced draw call. The square and
+circle geometry is shared by all textures, in one vertex buffer, and the
+transform of each instance is computed in a vertex shader.
+
+A Batch draws exactly what the same sequence of Texture.draw() calls would,
+with positions, sizes and rotations as in Texture.draw(), in the same
+order, so overlapping instances stack as they would. Consecutive draws of
+the same texture and shape share one draw call; to batch well, add the
+draws of each texture together where they do not overlap.
+
+Textures packed into a TextureAtlas share one GL texture, so consecutive
+draws of any of them are rendered with a single draw call.
+
+Requires OpenGL 3.3 (instanced arrays).
+
+Example
+-------
+    batch = ihrl.graphics.newBatch()
+    for pos in positions:
+        batch.add(patch, pos)
+    batch.draw()
+    ihrl.graphics.flip()
+"""
+
+import ctypes
+
+import numpy as np
+import OpenGL.GL as opengl
+from OpenGL.GL import shaders
+
+from hrl.graphics.texture import UNIT_CIRCLE
+
+VERTEX_SHADER = """
+#version 330
+layout(location = 0) in vec2 vertex;    // unit geometry
+layout(location = 1) in vec2 texcoord;
+layout(location = 2) in vec4 rect;      // per instance: position, size
+layout(location = 3) in vec3 rotation;  // per instance: angle (deg), centre
+layout(location = 4) in vec4 region;    // per instance: texture sub-rectangle
+uniform vec2 screen;
+out vec2 uv;
+
+void main() {
+    // As glTranslate(pos) glTranslate(rotc) glRotate(rot, 0, 0, -1)
+    // glTranslate(-rotc) glScalef(size) in Texture.draw()
+    float angle = radians(rotation.x);
+    vec2 p = vertex * rect.zw - rotation.yz;
+    p = vec2(p.x * cos(angle) + p.y * sin(angle), -p.x * sin(angle) + p.y * cos(angle));
+    p += rect.xy + rotation.yz;
+
+    // As glOrtho(0, width, height, 0, -1, 1)
+    gl_Position = vec4(2.0 * p.x / screen.x - 1.0, 1.0 - 2.0 * p.y / screen.y, 0.0, 1.0);
+    uv = region.xy + texcoord * region.zw;
+}
+"""
+
+FRAGMENT_SHADER = """
+#version 330
+uniform sampler2D image;
+in vec2 uv;
+out vec4 colour;
+
+void main() {
+    colour = texture(image, uv);
+}
+"""
+
+# Shared geometry, (x, y, u, v) per vertex: square as in createSquareDL,
+# followed by circle as in createCircleDL
+SQUARE = np.array([[0, 0, 0, 0], [0, 1, 0, 1], [1, 1, 1, 1], [1, 0, 1, 0]], dtype=np.float32)
+CIRCLE = np.hstack([UNIT_CIRCLE, UNIT_CIRCLE]).astype(np.float32)
+GEOMETRY = {"square": (0, len(SQUARE)), "circle": (len(SQUARE), len(CIRCLE))}
+
+# Per instance: position (2), size (2), rotation angle and centre (3),
+# texture sub-rectangle (4)
+INSTANCE_FLOATS = 11
+
+
+class Renderer:
+    """Shared shader program and vertex buffers for Batches.
+
+    One Renderer is created per Graphics, on the first Graphics.newBatch().
+
+    Parameters
+    ----------
+    width : int
+        window width in pixels
+    height : int
+        window height in pixels
+    """
+
+    def __init__(self, width, height):
+        self.width = width
+        self.height = height
+
+        self._vao = opengl.glGenVertexArrays(1)
+        opengl.glBindVertexArray(self._vao)
+
+        self.program = shaders.compileProgram(
+            shaders.compileShader(VERTEX_SHADER, opengl.GL_VERTEX_SHADER),
+            shaders.compileShader(FRAGMENT_SHADER, opengl.GL_FRAGMENT_SHADER),
+        )
+        self._screen = opengl.glGetUniformLocation(self.program, "screen")
+        self._image = opengl.glGetUniformLocation(self.program, "image")
+
+        # Shared unit geometry
+        geometry = np.vstack([SQUARE, CIRCLE])
+        self._geometry = opengl.glGenBuffers(1)
+        opengl.glBindBuffer(opengl.GL_ARRAY_BUFFER, self._geometry)
+        opengl.glBufferData(opengl.GL_ARRAY_BUFFER, geometry.nbytes, geometry, opengl.GL_STATIC_DRAW)
+        stride = 4 * 4
+        for location, offset in ((0, 0), (1, 8)):
+            opengl.glEnableVertexAttribArray(location)
+            opengl.glVertexAttribPointer(
+                location, 2, opengl.GL_FLOAT, opengl.GL_FALSE, stride, ctypes.c_void_p(offset)
+            )
+
+        # Per instance transforms, refilled on every draw
+        self._instances = opengl.glGenBuffers(1)
+        for location in (2, 3, 4):
+            opengl.glEnableVertexAttribArray(location)
+            opengl.glVertexAttribDivisor(location, 1)
+
+        opengl.glBindVertexArray(0)
+        opengl.glBindBuffer(opengl.GL_ARRAY_BUFFER, 0)
+
+    def _point_instances(self, first):
+        """Point per-instance attributes at the instance first in the buffer"""
+        stride = INSTANCE_FLOATS * 4
+        base = first * stride
+        for location, size, offset in ((2, 4, 0), (3, 3, 16), (4, 4, 28)):
+            opengl.glVertexAttribPointer(
+                location, size, opengl.GL_FLOAT, opengl.GL_FALSE, stride, ctypes.c_void_p(base + offset)
+            )
+
+    def render(self, groups, instances):
+        """Draw instances, one instanced draw call per group.
+
+        Parameters
+        ----------
+        groups : list of (txid, shape, first, count)
+            texture and shape of consecutive runs of instances
+        instances : ndarray
+            float32 array (N, 11) of per-instance attributes
+        """
+        opengl.glUseProgram(self.program)
+        opengl.glUniform2f(self._screen, self.width, self.height)
+        opengl.glUniform1i(self._image, 0)
+        opengl.glActiveTexture(opengl.GL_TEXTURE0)
+
+        opengl.glBindVertexArray(self._vao)
+        opengl.glBindBuffer(opengl.GL_ARRAY_BUFFER, self._instances)
+        opengl.glBufferData(opengl.GL_ARRAY_BUFFER, instances.nbytes, instances, opengl.GL_STREAM_DRAW)
+
+        for txid, shape, first, count in groups:
+            opengl.glBindTexture(opengl.GL_TEXTURE_2D, txid)
+            self._point_instances(first)
+            start, n_vertices = GEOMETRY[shape]
+            opengl.glDrawArraysInstanced(opengl.GL_TRIANGLE_FAN, start, n_vertices, count)
+
+        # Leave fixed-function state for Texture.draw()
+        opengl.glBindVertexArray(0)
+        opengl.glBindBuffer(opengl.GL_ARRAY_BUFFER, 0)
+        opengl.glUseProgram(0)
+
+    def delete(self):
+        """Delete shader program and buffers."""
+        opengl.glDeleteProgram(self.program)
+        opengl.glDeleteBuffers(2, [self._geometry, self._instances])
+        opengl.glDeleteVertexArrays(1, [self._vao])
+
+
+class Batch:
+    """Collects texture draws, and renders them with instanced draw calls.
+
+    Create with Graphics.newBatch(). Add draws with add(), render them to
+    the back buffer with draw(). Added draws are kept until clear(), so a
+    static display can be drawn again every frame.
+
+    Parameters
+    ----------
+    renderer : Renderer
+        shared shader program and geometry
+    """
+
+    def __init__(self, renderer):
+        self.renderer = renderer
+        self._textures = []
+        self._instances = []
+
+    def __len__(self):
+        return len(self._instances)
+
+    def add(self, texture, pos, sz=None, rot=0, rotc=None):
+        """Add a draw of a texture, with arguments as Texture.draw().
+
+        Parameters
+        ----------
+        texture : Texture
+            texture to draw
+        pos : (float, float)
+            position in pixels of the upper left corner of the texture
+        sz : (float, float), optional
+            (width, height) in pixels, by default None: natural size
+        rot : float, optional
+            rotation (degrees, clockwise), by default 0
+        rotc : (float, float), optional
+            centre of rotation, relative to pos, by default None:
+            centre of the texture at its natural size
+        """
+        if sz is None:
+            sz = (texture.wdth, texture.hght)
+        if rotc is None:
+            rotc = (texture.wdth / 2, texture.hght / 2)
+        self._textures.append(texture)
+        self._instances.append((pos[0], pos[1], sz[0], sz[1], rot, rotc[0], rotc[1], *texture.region))
+
+    def clear(self):
+        """Remove all added draws."""
+        self._textures = []
+        self._instances = []
+
+    def draw(self):
+        """Render all added draws to the back buffer."""
+        if not self._instances:
+            return
+
+        # One draw call per run of consecutive instances of the same texture
+        # and shape, keeping the order of all draws. Deleted textures are
+        # skipped, as Texture.draw() draws nothing for them.
+        instances = []
+        groups = []
+        for texture, instance in zip(self._textures, self._instances):
+            if texture._txid is None:
+                continue
+            key = (texture._txid, texture.shape)
+            if groups and tuple(groups[-1][:2]) == key:
+                groups[-1][3] += 1
+            else:
+                groups.append([*key, len(instances), 1])
+            instances.append(instance)
+
+        if not instances:
+            return
+        self.renderer.render(groups, np.array(instances, dtype=np.float32))
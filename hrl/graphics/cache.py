@@ -0,0 +1,167 @@
+"""Content-addressed cache of OpenGL textures.
+
+Experiments often create textures from the same arrays over and over:
+backgrounds, masks, stimuli repeated across trials. A TextureCache maps a
+hash of the input array (plus LUT and shape mask) to an already uploaded
+Texture, so that repeated `Graphics.newTexture` calls skip gamma correction,
+encoding and upload.
+
+The cache owns its textures: it deletes the least recently used ones when
+its GPU memory budget is exceeded, and all of them on `clear()`. Textures
+obtained from a cache should therefore not be deleted by hand, and should
+not be drawn after they may have been evicted.
+"""
+
+import hashlib
+from collections import OrderedDict
+
+import numpy as np
+
+
+def array_digest(arr):
+    """Fast content hash of an array, including its shape and dtype.
+
+    Parameters
+    ----------
+    arr : ndarray
+        array to hash
+
+    Returns
+    -------
+    bytes
+        16-byte BLAKE2b digest
+    """
+    arr = np.ascontiguousarray(arr)
+    digest = hashlib.blake2b(digest_size=16)
+    digest.update(str((arr.shape, arr.dtype.str)).encode())
+    digest.update(memoryview(arr).cast("B"))
+    return digest.digest()
+
+
+class TextureCache:
+    """LRU cache of textures with a GPU memory budget.
+
+    Parameters
+    ----------
+    budget : int, optional
+        maximum total size (bytes) of cached textures, by default 256 MiB.
+        A single texture larger than the budget is returned, but not cached.
+
+    Attributes
+    ----------
+    hits : int
+        number of lookups that returned a cached texture
+    misses : int
+        number of lookups that created a new texture
+    evictions : int
+        number of textures deleted to stay within budget
+    nbytes : int
+        current total size (bytes) of cached textures
+    """
+
+    def __init__(self, budget=256 * 2**20):
+        self.budget = budget
+        self._textures = OrderedDict()
+        self.hits = 0
+        self.misses = 0
+        self.evictions = 0
+        self.nbytes = 0
+
+    def __len__(self):
+        return len(self._textures)
+
+    @staticmethod
+    def key(arr, shape="square", lut=None):
+        """Cache key for an input array, shape mask and LUT.
+
+        Parameters
+        ----------
+        arr : ndarray
+            input image array
+        shape : str, optional
+            shape mask, by default 'square'
+        lut : ndarray or bytes, optional
+            LUT array, or precomputed digest of it, by default None
+
+        Returns
+        -------
+        tuple
+            hashable cache key
+        """
+        if lut is not None and not isinstance(lut, bytes):
+            lut = array_digest(lut)
+        return (array_digest(arr), shape, lut)
+
+    def get(self, key, create):
+        """Return the cached texture for key, or create and cache it.
+
+        Parameters
+        ----------
+        key : tuple
+            cache key, see `TextureCache.key`
+        create : callable
+            called without arguments on a miss, returns a new Texture
+
+        Returns
+        -------
+        Texture
+        """
+        texture = self._textures.get(key)
+        if texture is not None:
+            if texture._txid is not None:
+                self.hits += 1
+                self._textures.move_to_end(key)
+                return texture
+            # Deleted by hand: forget it
+            self._remove(key)
+
+        self.misses += 1
+        texture = create()
+        size = texture_nbytes(texture)
+        if size <= self.budget:
+            self._textures[key] = texture
+            self.nbytes += size
+            self._evict()
+
+        return texture
+
+    def _remove(self, key):
+        texture = self._textures.pop(key)
+        self.nbytes -= texture_nbytes(texture)
+        return texture
+
+    def _evict(self):
+        while self.nbytes > self.budget:
+            key = next(iter(self._textures))
+            self._remove(key).delete()
+            self.evictions += 1
+
+    def clear(self):
+        """Delete all cached textures."""
+        while self._textures:
+            self._remove(next(iter(self._textures))).delete()
+
+    def stats(self):
+        """Cache statistics.
+
+        Returns
+        -------
+        dict
+            with hits, misses, evictions, hit rate, number of textures,
+            size and budget (bytes)
+        """
+        lookups = self.hits + self.misses
+        return {
+            "hits": self.hits,
+            "misses": self.misses,
+            "evictions": self.evictions,
+            "hit_rate": self.hits / lookups if lookups else 0.0,
+            "textures": len(self._textures),
+            "nbytes": self.nbytes,
+            "budget": self.budget,
+        }
+
+
+def texture_nbytes(texture):
+    """GPU memory (bytes) of an RGBA8 texture."""
+    return texture.wdth * texture.hght * 4
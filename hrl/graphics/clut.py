@@ -0,0 +1,131 @@
+"""Hardware colour lookup tables (CLUTs) for the two VGA outputs.
+
+In the L48 video mode, VPixx devices use RED[7:0] of each framebuffer pixel
+as an index into a table of 256 16-bit RGB entries, applied in hardware at
+scan-out. The DATAPixx holds two such tables, one per VGA output, loaded
+together with DPxSetVidCluts(): 512 entries, VGA 1 first, passed as one list
+per colour channel, like the 256 entries of DPxSetVidClut(). Each monitor can
+thus be linearised by its own calibration, without a gamma correction pass
+on the CPU for every texture.
+
+A DualCLUT compiles an HRL (C)LUT per output into its 256-entry table, and
+uploads both tables in one message, only when either of them changed.
+"""
+
+import os
+
+import numpy as np
+
+from hrl.graphics.cache import array_digest
+from hrl.graphics.timing import DPX_LOCK
+from hrl.luts import gamma_correct_grey, gamma_correct_RGB
+
+# Entries of the CLUT of each output
+CLUT_ENTRIES = 256
+
+# Number of VGA outputs with a CLUT of their own
+CLUT_OUTPUTS = 2
+
+
+def clut_from_lut(lut=None):
+    """Compile a LUT or CLUT into a 256-entry 16-bit RGB hardware CLUT.
+
+    Entry i holds the gamma corrected output for the input intensity
+    i / 255, discretized by truncation as in the HRL encoders.
+
+    Parameters
+    ----------
+    lut : str or os.PathLike or Array[float], optional
+        path to a LUT/CLUT file, or a LUT with at least shape (N, 2) or a
+        CLUT with at least shape (N, 4), see `hrl.luts`; by default None
+        (identity)
+
+    Returns
+    -------
+    ndarray
+        uint16 array of shape (256, 3): R, G, B of each entry
+    """
+    levels = np.linspace(0.0, 1.0, CLUT_ENTRIES)
+    if lut is None:
+        rgb = np.repeat(levels[:, None], 3, axis=1)
+    else:
+        if isinstance(lut, (str, os.PathLike)):
+            lut = np.genfromtxt(lut, skip_header=1, delimiter=",")
+        lut = np.asarray(lut, dtype=float)
+        if lut.shape[1] >= 4:
+            rgb = gamma_correct_RGB(np.repeat(levels[:, None], 3, axis=1)[None], lut)[0]
+        else:
+            rgb = np.repeat(gamma_correct_grey(levels, lut)[:, None], 3, axis=1)
+
+    return (np.clip(rgb, 0.0, 1.0) * (2**16 - 1)).astype(np.uint16)
+
+
+class DualCLUT:
+    """CLUTs of the two VGA outputs, uploaded together when changed.
+
+    Parameters
+    ----------
+    luts : sequence of (str or os.PathLike or Array[float] or None), optional
+        LUT or CLUT of VGA 1 and VGA 2, see clut_from_lut(); by default
+        identity for both
+    dpx : module, optional
+        libdpx bindings, by default pypixxlib._libdpx
+
+    Attributes
+    ----------
+    tables : ndarray
+        uint16 array of shape (2, 256, 3), the CLUT of each output
+    uploads : int
+        number of times the tables were sent to the device
+    """
+
+    def __init__(self, luts=(None, None), dpx=None):
+        if dpx is None:
+            from pypixxlib import _libdpx as dpx
+
+        if len(luts) != CLUT_OUTPUTS:
+            raise ValueError(f"Need a LUT for each of {CLUT_OUTPUTS} outputs, got {len(luts)}")
+
+        self.dpx = dpx
+        self.tables = np.stack([clut_from_lut(lut) for lut in luts])
+        self.uploads = 0
+        self._device_digest = None
+
+    def load(self, output, lut=None):
+        """Load the calibration of one output; sent by the next apply().
+
+        Parameters
+        ----------
+        output : int
+            0 for VGA 1, 1 for VGA 2
+        lut : str or os.PathLike or Array[float], optional
+            LUT or CLUT, see clut_from_lut(); by default None (identity)
+        """
+        self.tables[output] = clut_from_lut(lut)
+
+    def pending(self):
+        """Whether the tables differ from the ones on the device."""
+        return array_digest(self.tables) != self._device_digest
+
+    def apply(self):
+        """Send both tables in one message, if either changed.
+
+        The device switches to the new tables at the next vertical
+        blanking interval.
+
+        Returns
+        -------
+        bool
+            True if the tables were sent
+        """
+        digest = array_digest(self.tables)
+        if digest == self._device_digest:
+            return False
+
+        # [[R...], [G...], [B...]] of 512 entries each, VGA 1 first
+        data = self.tables.reshape(CLUT_OUTPUTS * CLUT_ENTRIES, 3).T.tolist()
+        with DPX_LOCK:
+            self.dpx.DPxSetVidCluts(data)
+        self._device_digest = digest
+        self.uploads += 1
+        return True
@@ -1,5 +1,7 @@
 import numpy as np
 
+from .clut import DualCLUT
+from .encoding import encode_dithered, encode_m16
 from .graphics import Graphics_grey
 
 
@@ -27,6 +29,8 @@ class DATAPixx(Graphics_grey):
     """
 
     bitdepth = 8  # bit depth per physical channel
+    output_levels = 2**16  # 16-bit greyscale
+    video_mode = "M16"
     device = None
 
     def __init__(self, *args, **kwargs):
@@ -36,15 +40,8 @@ class DATAPixx(Graphics_grey):
         self.device = device()
 
         # Set video mode to M16: concatente R & G channels for 16-bit greyscale
-        mode = self.device.getVideoMode()
-        print(f"Current video mode: {mode}")
-
-        if mode != "M16":
-            print("Setting video mode to M16...")
-            self.device.setVideoMode("M16")
-            self.device.updateRegisterCache()
-            mode = self.device.getVideoMode()
-            print(f"Video mode now: {mode}")
+        # (or a dithered variant of a subclass)
+        self._set_video_mode()
 
         # Call parent initializer
         super().__init__(*args, **kwargs)
@@ -92,3 +89,260 @@ class DATAPixx(Graphics_grey):
         )
 
         return channels
+
+    def bytestring_from_img(self, img):
+        """Gamma correct and encode greyscale image in one fused M16 pass.
+
+        Gives the same bytes as `channels_from_img` followed by
+        `bytestring_from_channels`, without the uint32 temporaries.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+
+        Returns
+        -------
+        bytes
+            packed 32-bit RGBA bytestring for OpenGL texture data
+        """
+        return encode_m16(np.atleast_2d(img), gamma_correct=self.gamma_correct).tobytes()
+
+    def encode_into(self, img, out):
+        """Gamma correct and M16 encode greyscale image into a uint8 buffer.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+        out : ndarray
+            uint8 array of (H * W * 4) bytes to write into
+        """
+        img = np.atleast_2d(img)
+        encode_m16(img, gamma_correct=self.gamma_correct, out=out.reshape(*img.shape, 4))
+
+
+class DATAPixx_L48(Graphics_grey):
+    """VPixx DataPixx in L48 mode, with gamma correction in hardware.
+
+    Uses L48 video mode, in which the R channel indexes a 256-entry 16-bit
+    CLUT on the device. Each VGA output has a CLUT of its own, compiled
+    from its own calibration (see `DualCLUT`), so two monitors are
+    linearised independently, and textures are encoded without a gamma
+    correction pass on the CPU. Resolution is 256 levels per output.
+
+    Attributes
+    ----------
+    bitdepth : int
+        bit depth per physical channel (8)
+    device : DATAPixx
+        pypixxlib device instance for hardware communication
+    cluts : DualCLUT
+        CLUTs of VGA 1 and VGA 2; changes are sent on the next flip()
+
+    See Also
+    --------
+    DATAPixx : 16-bit greyscale, gamma corrected on the CPU
+    """
+
+    bitdepth = 8  # bit depth per physical channel
+    output_levels = 2**8  # 8-bit CLUT index
+    video_mode = "L48"
+    device = None
+
+    def __init__(self, *args, lut=None, **kwargs):
+        """Initialize DataPixx in L48 mode.
+
+        Parameters
+        ----------
+        lut : str or os.PathLike or Array[float] or tuple of these, optional
+            LUT (or CLUT) of both outputs, or a (VGA 1, VGA 2) tuple of
+            them, by default None (identity). Applied by the device CLUTs,
+            not on the CPU.
+
+        Other parameters as for `Graphics_grey`.
+        """
+        # Open hardware connection
+        from pypixxlib.datapixx import DATAPixx as device
+
+        self.device = device()
+
+        # Set video mode to L48: R channel indexes the device CLUT
+        # (or L48D of a subclass)
+        self._set_video_mode()
+
+        # One calibration per output, loaded into the device CLUTs
+        if not (isinstance(lut, tuple) and len(lut) == 2):
+            lut = (lut, lut)
+        self.cluts = DualCLUT(lut)
+
+        # Call parent initializer, without CPU gamma correction
+        super().__init__(*args, lut=None, **kwargs)
+
+    def close(self):
+        """Close connection to DataPixx hardware device."""
+        self.device.close()
+
+    def flip(self, clr=True):
+        """Swap display buffers, sending changed CLUTs first.
+
+        See `Graphics.flip`.
+        """
+        self.cluts.apply()
+        return super().flip(clr)
+
+    def channels_from_img(self, img):
+        """Convert greyscale image to an 8-bit CLUT index in the R channel.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+
+        Returns
+        -------
+        tuple of (ndarray, ndarray, ndarray, int)
+            4-channel representation as (R, G, B, Alpha) where:
+            - R = CLUT index
+            - G = 0 (unused)
+            - B = 0 (non-zero B selects the CLUT overlay)
+            - Alpha = 255
+        """
+        arr = np.asarray(np.clip(img, 0.0, 1.0) * (2**self.bitdepth - 1), dtype=np.uint32)
+
+        channels = (
+            arr,  # R channel (CLUT index)
+            np.zeros_like(arr),  # G channel (not used)
+            np.zeros_like(arr),  # B channel (no overlay)
+            2**self.bitdepth - 1,  # Alpha channel (max intensity)
+        )
+
+        return channels
+
+
+class DATAPixx_M16D(DATAPixx):
+    """VPixx DataPixx in M16D mode: 16-bit greyscale, robust to dithering.
+
+    Like `DATAPixx`, but in the M16D video mode, which concatenates
+    R[7:3], G[7:3] and B[7:2] into the 16-bit value. The low bits of each
+    channel are ignored by the device, so the display is unaffected by
+    GPUs or drivers that dither the framebuffer.
+
+    See Also
+    --------
+    DATAPixx : M16 mode, all 8 bits of R and G carry data
+    """
+
+    video_mode = "M16D"
+
+    def channels_from_img(self, img):
+        """Convert greyscale image to the M16D R-G-B bit fields.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+
+        Returns
+        -------
+        tuple of (ndarray, ndarray, ndarray, int)
+            4-channel representation as (R, G, B, Alpha) where:
+            - R = bits 15-11, in R[7:3]
+            - G = bits 10-6, in G[7:3]
+            - B = bits 5-0, in B[7:2]
+            - Alpha = 255
+        """
+        pixels = encode_dithered(np.atleast_2d(img), "M16D").astype(np.uint32)
+        return (pixels[..., 0], pixels[..., 1], pixels[..., 2], 2**self.bitdepth - 1)
+
+    def bytestring_from_img(self, img):
+        """Gamma correct and encode greyscale image in one fused M16D pass.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+
+        Returns
+        -------
+        bytes
+            packed 32-bit RGBA bytestring for OpenGL texture data
+        """
+        return encode_dithered(np.atleast_2d(img), "M16D", gamma_correct=self.gamma_correct).tobytes()
+
+    def encode_into(self, img, out):
+        """Gamma correct and M16D encode greyscale image into a uint8 buffer.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+        out : ndarray
+            uint8 array of (H * W * 4) bytes to write into
+        """
+        img = np.atleast_2d(img)
+        encode_dithered(img, "M16D", gamma_correct=self.gamma_correct, out=out.reshape(*img.shape, 4))
+
+
+class DATAPixx_L48D(DATAPixx_L48):
+    """VPixx DataPixx in L48D mode: hardware CLUTs, robust to dithering.
+
+    Like `DATAPixx_L48`, but in the L48D video mode, in which R[7:4] and
+    G[7:4] concatenate into the 8-bit CLUT index. The low bits of each
+    channel are ignored by the device, so the display is unaffected by
+    GPUs or drivers that dither the framebuffer.
+
+    See Also
+    --------
+    DATAPixx_L48 : L48 mode, the index in R[7:0]
+    """
+
+    video_mode = "L48D"
+
+    def channels_from_img(self, img):
+        """Convert greyscale image to the L48D CLUT index bit fields.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+
+        Returns
+        -------
+        tuple of (ndarray, ndarray, ndarray, int)
+            4-channel representation as (R, G, B, Alpha) where:
+            - R = index bits 7-4, in R[7:4]
+            - G = index bits 3-0, in G[7:4]
+            - B = 0 (non-zero B selects the CLUT overlay)
+            - Alpha = 255
+        """
+        pixels = encode_dithered(np.atleast_2d(img), "L48D").astype(np.uint32)
+        return (pixels[..., 0], pixels[..., 1], pixels[..., 2], 2**self.bitdepth - 1)
+
+    def bytestring_from_img(self, img):
+        """Encode greyscale image in one fused L48D pass.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+
+        Returns
+        -------
+        bytes
+            packed 32-bit RGBA bytestring for OpenGL texture data
+        """
+        return encode_dithered(np.atleast_2d(img), "L48D").tobytes()
+
+    def encode_into(self, img, out):
+        """L48D encode greyscale image into a uint8 buffer.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+        out : ndarray
+            uint8 array of (H * W * 4) bytes to write into
+        """
+        img = np.atleast_2d(img)
+        encode_dithered(img, "L48D", out=out.reshape(*img.shape, 4))
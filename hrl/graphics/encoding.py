@@ -0,0 +1,349 @@
+"""Pixel encoders for VPixx high bit-depth video modes.
+
+In the M16 video mode, VPixx devices concatenate RED[7:0] (high byte) and
+GREEN[7:0] (low byte) of each pixel into one 16-bit value, sent to all three
+RGB components.
+
+In the dithered M16D and L48D video modes, only the high bits of each
+framebuffer byte carry data, so that GPU or driver dithering of the low bits
+does not change what is displayed:
+
+- M16D: RED[7:3], GREEN[7:3] and BLUE[7:2] concatenate into one 16-bit
+  value, sent to all three RGB components.
+- L48D: RED[7:4] and GREEN[7:4] concatenate into an 8-bit index into the
+  device CLUT.
+
+In the C48 and C36D video modes, VPixx devices combine each even/odd pair of
+horizontally adjacent framebuffer pixels into a single displayed pixel, at
+half the horizontal resolution:
+
+- C48: even pixel RED/GREEN/BLUE[7:0] hold the high byte and odd pixel
+  RED/GREEN/BLUE[7:0] the low byte of a 16-bit value per colour component.
+- C36D: even pixel RED/GREEN/BLUE[7:2] hold the high 6 bits and odd pixel
+  RED/GREEN/BLUE[7:2] the low 6 bits of a 12-bit value per colour component.
+  Bits [1:0] are ignored by the device, which makes the mode robust against
+  GPU dithering.
+
+The encoders here write the packed RGBA layout directly into a preallocated
+uint8 array, rather than building separate uint32 channel arrays and summing
+them into 32-bit integers. Large images are split into bands of rows, which
+are encoded in parallel threads (numpy releases the GIL in its kernels).
+"""
+
+import os
+import threading
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+
+# Images with at least this many pixels are encoded in parallel bands
+PARALLEL_MIN_PIXELS = 2**18
+
+_executor = None
+_executor_lock = threading.Lock()
+
+
+def _get_executor():
+    """Shared pool of one thread per CPU, created on first use.
+
+    The pool is never replaced, so that encoders called from several
+    threads at once (e.g. a StimulusPipeline) can all submit to it.
+    """
+    global _executor
+
+    with _executor_lock:
+        if _executor is None:
+            _executor = ThreadPoolExecutor(max_workers=os.cpu_count() or 1, thread_name_prefix="hrl-encode")
+        return _executor
+
+
+def _map_bands(func, n_rows, n_pixels, threads=None):
+    """Call func(start, stop) for bands of rows, in parallel for large images"""
+    if threads is None:
+        threads = os.cpu_count() or 1
+    threads = min(threads, n_rows)
+
+    if threads <= 1 or n_pixels < PARALLEL_MIN_PIXELS:
+        func(0, n_rows)
+        return
+
+    bounds = np.linspace(0, n_rows, threads + 1).astype(int)
+    executor = _get_executor()
+    futures = [executor.submit(func, start, stop) for start, stop in zip(bounds[:-1], bounds[1:])]
+    for future in futures:
+        future.result()
+
+
+def encode_m16(img, gamma_correct=None, out=None, threads=None):
+    """Encode greyscale image into M16 RGBA pixels.
+
+    Gamma correction, discretization and byte packing are done per band of
+    rows, so that intermediate arrays stay small. Values are discretized by
+    truncation, as in `DATAPixx.channels_from_img`:
+    ``int(value * (2**16 - 1))``. Values outside [0.0, 1.0] are clipped.
+
+    Parameters
+    ----------
+    img : ndarray
+        greyscale image with values in [0.0, 1.0] and shape (H, W)
+    gamma_correct : callable, optional
+        gamma correction applied to each band before discretization,
+        by default None (no gamma correction)
+    out : ndarray, optional
+        uint8 array of shape (H, W, 4) to write into, by default None
+        (allocates a new array)
+    threads : int, optional
+        maximum number of threads, by default None (number of CPUs)
+
+    Returns
+    -------
+    ndarray
+        uint8 array of shape (H, W, 4): R = high byte, G = low byte, B = 0,
+        Alpha = 255
+
+    Raises
+    ------
+    ValueError
+        if the shape of img or out is invalid
+    """
+    img = np.asarray(img)
+    if img.ndim != 2:
+        raise ValueError(f"Greyscale input must be 2D, got shape {img.shape}")
+    height, width = img.shape
+
+    if out is None:
+        out = np.empty((height, width, 4), dtype=np.uint8)
+    elif out.shape != (height, width, 4) or out.dtype != np.uint8:
+        raise ValueError(
+            f"Output must be uint8 array of shape {(height, width, 4)}, "
+            f"got {out.dtype} array of shape {out.shape}"
+        )
+
+    def encode_band(start, stop):
+        band = img[start:stop]
+        if gamma_correct is not None:
+            band = gamma_correct(band)
+
+        # Discretize to 16-bit integers
+        value = np.clip(band, 0.0, 1.0)
+        if not np.issubdtype(value.dtype, np.floating):
+            value = value.astype(float)
+        value *= 2**16 - 1
+        value = value.astype(np.uint16)
+
+        # R-G concatenated format, B unused, max alpha
+        np.right_shift(value, 8, out=out[start:stop, :, 0], casting="unsafe")
+        np.bitwise_and(value, 0xFF, out=out[start:stop, :, 1], casting="unsafe")
+        out[start:stop, :, 2] = 0
+        out[start:stop, :, 3] = 255
+
+    _map_bands(encode_band, height, img.size, threads)
+
+    return out
+
+
+# Bits of R, G and B that carry data in the dithered modes, left-aligned in
+# each byte: R holds the most significant bits of the value
+DITHERED_LAYOUTS = {
+    "M16D": (5, 5, 6),  # R[7:3], G[7:3], B[7:2]: 16-bit value
+    "L48D": (4, 4, 0),  # R[7:4], G[7:4]: 8-bit CLUT index
+}
+
+
+def encode_dithered(img, mode="M16D", gamma_correct=None, out=None, threads=None):
+    """Encode greyscale image into M16D or L48D RGBA pixels.
+
+    Values are discretized by truncation, as in the other HRL encoders:
+    ``int(value * (2**bits - 1))``, with 16 bits for M16D and 8 for L48D.
+    Values outside [0.0, 1.0] are clipped. Bits that do not carry data are
+    zero.
+
+    Parameters
+    ----------
+    img : ndarray
+        greyscale image with values in [0.0, 1.0] and shape (H, W)
+    mode : {'M16D', 'L48D'}, optional
+        video mode, by default 'M16D'
+    gamma_correct : callable, optional
+        gamma correction applied to each band before discretization,
+        by default None (no gamma correction)
+    out : ndarray, optional
+        uint8 array of shape (H, W, 4) to write into, by default None
+        (allocates a new array)
+    threads : int, optional
+        maximum number of threads, by default None (number of CPUs)
+
+    Returns
+    -------
+    ndarray
+        uint8 array of shape (H, W, 4): RGBA framebuffer pixels, with alpha
+        at maximum
+
+    Raises
+    ------
+    ValueError
+        if the mode is unknown, or the shape of img or out is invalid
+    """
+    if mode not in DITHERED_LAYOUTS:
+        raise ValueError(f"mode must be one of {tuple(DITHERED_LAYOUTS)}, got {mode}")
+    widths = DITHERED_LAYOUTS[mode]
+    bits = sum(widths)
+
+    img = np.asarray(img)
+    if img.ndim != 2:
+        raise ValueError(f"Greyscale input must be 2D, got shape {img.shape}")
+    height, width = img.shape
+
+    if out is None:
+        out = np.empty((height, width, 4), dtype=np.uint8)
+    elif out.shape != (height, width, 4) or out.dtype != np.uint8:
+        raise ValueError(
+            f"Output must be uint8 array of shape {(height, width, 4)}, "
+            f"got {out.dtype} array of shape {out.shape}"
+        )
+
+    def encode_band(start, stop):
+        band = img[start:stop]
+        if gamma_correct is not None:
+            band = gamma_correct(band)
+
+        # Discretize to integers
+        value = np.clip(band, 0.0, 1.0)
+        if not np.issubdtype(value.dtype, np.floating):
+            value = value.astype(float)
+        value *= 2**bits - 1
+        value = value.astype(np.uint16)
+
+        # Split into the bit fields of R, G, B, each left-aligned in its byte
+        shift = bits
+        for channel, field in enumerate(widths):
+            shift -= field
+            part = (value >> shift) & (2**field - 1)
+            np.left_shift(part, 8 - field, out=out[start:stop, :, channel], casting="unsafe")
+        out[start:stop, :, 3] = 255
+
+    _map_bands(encode_band, height, img.size, threads)
+
+    return out
+
+
+def decode_dithered(packed, mode="M16D"):
+    """Decode M16D or L48D RGBA pixels into integer values.
+
+    Inverse of `encode_dithered`. Bits that do not carry data are ignored,
+    as by the device.
+
+    Parameters
+    ----------
+    packed : ndarray
+        uint8 array of shape (H, W, 4) or (H, W, 3)
+    mode : {'M16D', 'L48D'}, optional
+        video mode, by default 'M16D'
+
+    Returns
+    -------
+    ndarray
+        uint16 array of shape (H, W): 16-bit values for M16D, 8-bit CLUT
+        indices for L48D
+    """
+    if mode not in DITHERED_LAYOUTS:
+        raise ValueError(f"mode must be one of {tuple(DITHERED_LAYOUTS)}, got {mode}")
+
+    value = np.zeros(packed.shape[:2], dtype=np.uint16)
+    for channel, field in enumerate(DITHERED_LAYOUTS[mode]):
+        value <<= field
+        value |= packed[:, :, channel].astype(np.uint16) >> (8 - field)
+    return value
+
+
+def encode_pixel_pairs(img, bits=16, out=None):
+    """Encode RGB image into even/odd packed RGBA pixel pairs.
+
+    Values are discretized by truncation, as in the other HRL encoders:
+    ``int(value * (2**bits - 1))``. Values outside [0.0, 1.0] are clipped.
+
+    Parameters
+    ----------
+    img : ndarray
+        RGB image with values in [0.0, 1.0] and shape (H, W, 3)
+    bits : {16, 12}, optional
+        bit depth per colour component: 16 for C48, 12 for C36D,
+        by default 16
+    out : ndarray, optional
+        uint8 array of shape (H, 2W, 4) to write into, by default None
+        (allocates a new array)
+
+    Returns
+    -------
+    ndarray
+        uint8 array of shape (H, 2W, 4): RGBA framebuffer pixels, with alpha
+        at maximum
+
+    Raises
+    ------
+    ValueError
+        if bits is not 16 or 12, or the shape of img or out is invalid
+    """
+    if bits not in (16, 12):
+        raise ValueError(f"bits must be 16 (C48) or 12 (C36D), got {bits}")
+
+    img = np.asarray(img)
+    if img.ndim != 3 or img.shape[2] != 3:
+        raise ValueError(f"RGB input must be (H, W, 3), got shape {img.shape}")
+    height, width = img.shape[:2]
+
+    if out is None:
+        out = np.empty((height, 2 * width, 4), dtype=np.uint8)
+    elif out.shape != (height, 2 * width, 4) or out.dtype != np.uint8:
+        raise ValueError(
+            f"Output must be uint8 array of shape {(height, 2 * width, 4)}, "
+            f"got {out.dtype} array of shape {out.shape}"
+        )
+
+    # Discretize to integers, one value per colour component
+    value = np.asarray(np.clip(img, 0.0, 1.0) * (2**bits - 1), dtype=np.uint16)
+
+    # Each framebuffer byte carries half of the bits, left-aligned
+    half = bits // 2
+    align = 8 - half
+    even = out[:, 0::2, :3]
+    odd = out[:, 1::2, :3]
+
+    np.right_shift(value, half, out=even, casting="unsafe")
+    np.bitwise_and(value, 2**half - 1, out=odd, casting="unsafe")
+    if align:
+        np.left_shift(even, align, out=even)
+        np.left_shift(odd, align, out=odd)
+    out[:, :, 3] = 255
+
+    return out
+
+
+def decode_pixel_pairs(packed, bits=16):
+    """Decode even/odd packed RGBA pixel pairs into integer RGB values.
+
+    Inverse of `encode_pixel_pairs`, e.g., to check what the device will
+    display for a given framebuffer content.
+
+    Parameters
+    ----------
+    packed : ndarray
+        uint8 array of shape (H, 2W, 4) or (H, 2W, 3)
+    bits : {16, 12}, optional
+        bit depth per colour component: 16 for C48, 12 for C36D,
+        by default 16
+
+    Returns
+    -------
+    ndarray
+        uint16 array of shape (H, W, 3) with values in [0, 2**bits - 1]
+    """
+    if bits not in (16, 12):
+        raise ValueError(f"bits must be 16 (C48) or 12 (C36D), got {bits}")
+
+    half = bits // 2
+    align = 8 - half
+    even = packed[:, 0::2, :3].astype(np.uint16) >> align
+    odd = packed[:, 1::2, :3].astype(np.uint16) >> align
+
+    return (even << half) | odd
@@ -26,9 +26,21 @@ GPU_grey, GPU_RGB
 DATAPixx
     VPixx DataPixx device in M16 mode for 16-bit greyscale (R-G concatenation).
 
+DATAPixx_L48
+    VPixx DataPixx device in L48 mode, gamma corrected by a hardware CLUT per
+    VGA output.
+
+DATAPixx_M16D, DATAPixx_L48D, VIEWPixx_M16D
+    Variants of the M16 and L48 devices in the dithered video modes, which
+    only use the high bits of each channel and so survive GPU dithering.
+
 VIEWPixx_grey, VIEWPixx_RGB
     VPixx ViewPixx 3D device in M16 mode (greyscale) or C24 mode (RGB).
 
+VIEWPixx_C48, VIEWPixx_C36D
+    VPixx ViewPixx 3D device in C48 (16-bit) or C36D (12-bit) RGB mode, packing
+    each displayed pixel into an even/odd framebuffer pixel pair.
+
 Image Processing Pipeline
 --------------------------
 The image presentation pipeline consists of:
@@ -43,6 +55,7 @@ The image presentation pipeline consists of:
 3. Channel encoding: conversion to device-specific RGBA representation
    - GPU: 8-bit per channel
    - DataPixx/ViewPixx M16: 16-bit via R-G concatenation
+   - ViewPixx C48/C36D: 16/12-bit RGB via even/odd pixel pairs
 
 4. Texture creation: OpenGL texture object ready for display
 
@@ -62,8 +75,16 @@ import numpy as np
 import OpenGL.GL as opengl
 import pygame
 
-from hrl.graphics.texture import Texture, deleteTexture, deleteTextureDL
-from hrl.luts import gamma_correct_grey, gamma_correct_RGB
+from hrl.graphics.atlas import TextureAtlas
+from hrl.graphics.batch import Batch, Renderer
+from hrl.graphics.cache import TextureCache, array_digest
+from hrl.graphics.overlay import OverlayCompositor
+from hrl.graphics.pipeline import StimulusPipeline
+from hrl.graphics.stereo import FramePacker
+from hrl.graphics.texture import Texture, UploadRing, deleteTexture, deleteTextureDL
+from hrl.graphics.timing import OnsetService, VsyncLog
+from hrl.graphics.verify import LineVerifier
+from hrl.luts import compile_lut, gamma_correct_grey, gamma_correct_RGB
 
 
 class Graphics(ABC):
@@ -78,6 +99,7 @@ class Graphics(ABC):
     - Display buffer management (flip, clear)
     - LookUp Table (LUT) loading for gamma correction
     - Texture object creation from numpy arrays
+    - Optional caching of textures created from identical arrays
     - Background color management
 
     Attributes
@@ -95,6 +117,11 @@ class Graphics(ABC):
     device : object or None
         hardware device connection (e.g., pypixxlib instance) for devices
         requiring external hardware communication. None for standard GPUs.
+    output_levels : int
+        number of output levels per colour component (set by subclasses
+        with more than 8 bits); sets the resolution of the compiled LUT
+    video_mode : str or None
+        VPixx video mode (set by subclasses for VPixx devices), e.g., "M16"
 
     Notes
     -----
@@ -102,6 +129,9 @@ class Graphics(ABC):
     GPU_grey, GPU_RGB, DATAPixx, VIEWPixx_grey, or VIEWPixx_RGB.
     """
 
+    output_levels = 2**8
+    video_mode = None
+
     @abstractmethod
     def channels_from_img(self, img):
         """Convert image array to device-specific RGBA channel representation.
@@ -170,6 +200,18 @@ class Graphics(ABC):
         self.width = width
         self.height = height
 
+        # Texture cache, streaming uploads, onset timestamps, vsync log,
+        # line verification, horizontal overlay, frame packing (opt-in, see
+        # enable_*)
+        self.texture_cache = None
+        self.upload_ring = None
+        self._renderer = None
+        self.onset_service = None
+        self.vsync_log = None
+        self.line_verifier = None
+        self.overlay = None
+        self.frame_packer = None
+
         # Hardware device connection (None for GPU, set by *Pixx subclasses)
         if not hasattr(self, "device"):
             self.device = None
@@ -203,10 +245,30 @@ class Graphics(ABC):
             # Load specified LUT
             print(f"..using look-up table: {lut}")
             self._lut = np.genfromtxt(lut, skip_header=1, delimiter=',')
+            # Precompile for constant-time lookups, at the device's resolution
+            self._compiled_lut = compile_lut(self._lut, n_levels=self.output_levels)
+            self._lut_digest = array_digest(self._lut)
         else:  # No LUT provided
             self._lut = None
+            self._lut_digest = None
             self._gamma_correct = lambda x: x  # By default, no gamma correction: identity function
 
+    def _set_video_mode(self):
+        """Switch the hardware device to the video mode of this class.
+
+        Called by VPixx devices after opening their `device`, before
+        initializing the display.
+        """
+        mode = self.device.getVideoMode()
+        print(f"Current video mode: {mode}")
+
+        if mode != self.video_mode:
+            print(f"Setting video mode to {self.video_mode}...")
+            self.device.setVideoMode(self.video_mode)
+            self.device.updateRegisterCache()
+            mode = self.device.getVideoMode()
+            print(f"Video mode now: {mode}")
+
     def bytestring_from_channels(self, R, G, B, Alpha):
         """Pack RGBA channels into 32-bit bytestring for OpenGL.
 
@@ -242,6 +304,25 @@ class Graphics(ABC):
     def gamma_correct(self, img):
         return img
 
+    def bytestring_from_img(self, img):
+        """Gamma correct and encode image array into RGBA bytestring for OpenGL.
+
+        Subclasses may override this with a fused encoder, as long as the
+        resulting bytes are identical.
+
+        Parameters
+        ----------
+        img : ndarray
+            input image array with values in [0.0, 1.0]
+
+        Returns
+        -------
+        bytes
+            packed 32-bit RGBA bytestring for OpenGL texture data
+        """
+        arr = self.gamma_correct(img)
+        return self.bytestring_from_channels(*self.channels_from_img(arr))
+
     def newTexture(self, arr0, shape="square"):
         """Create OpenGL texture from image array.
 
@@ -267,13 +348,162 @@ class Graphics(ABC):
         -----
         Images use matrix-style coordinates: origin at top-left, increasing
         rightward (x) and downward (y). This matches numpy array indexing.
+
+        If a texture cache is enabled (see enable_texture_cache()), a texture
+        previously created from an identical array is reused.
         """
-        arr = self.gamma_correct(arr0)
+        if self.texture_cache is None:
+            return self._create_texture(arr0, shape)
+
+        key = self.texture_cache.key(arr0, shape, self._lut_digest)
+        return self.texture_cache.get(key, partial(self._create_texture, arr0, shape))
 
-        byts = self.bytestring_from_channels(*self.channels_from_img(arr))
+    def _create_texture(self, arr0, shape):
+        if self.upload_ring is not None:
+            # Encode straight into mapped PBO memory, upload asynchronously
+            slot = self.upload_ring.stage(arr0.shape[0] * arr0.shape[1] * 4)
+            self.encode_into(arr0, slot.array)
+            return Texture(slot, arr0.shape[1], arr0.shape[0], shape)
+
+        byts = self.bytestring_from_img(arr0)
 
         return Texture(byts, arr0.shape[1], arr0.shape[0], shape)
 
+    def encode_into(self, img, out):
+        """Gamma correct and encode image array into a uint8 RGBA buffer.
+
+        Subclasses with a fused encoder override this to write into the
+        buffer directly.
+
+        Parameters
+        ----------
+        img : ndarray
+            input image array with values in [0.0, 1.0]
+        out : ndarray
+            uint8 array of (H * W * 4) bytes to write into
+        """
+        out[:] = np.frombuffer(self.bytestring_from_img(img), dtype=np.uint8)
+
+    def encode_image(self, img):
+        """Gamma correct and encode image array into uint8 RGBA pixels.
+
+        Parameters
+        ----------
+        img : ndarray
+            input image array with values in [0.0, 1.0]
+
+        Returns
+        -------
+        ndarray
+            uint8 array of shape (H, W, 4)
+        """
+        img = np.asarray(img)
+        pixels = np.empty((img.shape[0], img.shape[1], 4), dtype=np.uint8)
+        self.encode_into(img, pixels.reshape(-1))
+        return pixels
+
+    def newAtlas(self, size=2048, padding=1):
+        """Create a TextureAtlas, to pack many small stimuli into few textures.
+
+        Parameters
+        ----------
+        size : int, optional
+            width and height of each atlas page in pixels, by default 2048
+        padding : int, optional
+            pixels of replicated edge around each stimulus, by default 1
+
+        Returns
+        -------
+        TextureAtlas
+            with add(arr) returning a drawable AtlasTexture
+        """
+        return TextureAtlas(self.encode_image, size=size, padding=padding)
+
+    def newPipeline(self, workers=2):
+        """Create a StimulusPipeline, to prepare upcoming stimuli in threads.
+
+        Stimulus generation and encoding run in worker threads; only the
+        texture upload stays on the render thread.
+
+        Parameters
+        ----------
+        workers : int, optional
+            number of worker threads, by default 2
+
+        Returns
+        -------
+        StimulusPipeline
+            with submit(generate, *args) returning a PendingStimulus
+        """
+        return StimulusPipeline(self, workers=workers)
+
+    def enable_streaming_uploads(self, n_buffers=3):
+        """Upload new textures asynchronously through pixel buffer objects.
+
+        Encoded pixels are written into a ring of mapped pixel buffer
+        objects (PBOs), from which the driver copies them to the GPU while
+        Python continues. Preparing the next stimulus then overlaps with
+        presenting the current one. Use Texture.ready() to check whether an
+        upload has completed.
+
+        Parameters
+        ----------
+        n_buffers : int, optional
+            number of PBOs, i.e., uploads that can be in flight, by default 3
+        """
+        if self.upload_ring is None:
+            self.upload_ring = UploadRing(n_buffers, size=self.width * self.height * 4)
+
+    def disable_streaming_uploads(self):
+        """Wait for pending uploads, and return to synchronous uploads."""
+        if self.upload_ring is not None:
+            self.upload_ring.delete()
+            self.upload_ring = None
+
+    def newBatch(self):
+        """Create a Batch, to render many texture draws with few draw calls.
+
+        Returns
+        -------
+        Batch
+            with add(texture, pos, sz, rot, rotc) as Texture.draw(), and
+            draw() to render all added draws
+        """
+        if self._renderer is None:
+            self._renderer = Renderer(self.width, self.height)
+        return Batch(self._renderer)
+
+    def enable_texture_cache(self, budget=256 * 2**20):
+        """Reuse textures created by newTexture() from identical arrays.
+
+        Textures are cached by a hash of the input array, the LUT and the
+        shape mask. When the cached textures exceed the memory budget, the
+        least recently used ones are deleted. Textures from the cache are
+        owned by it: do not delete them by hand.
+
+        Parameters
+        ----------
+        budget : int, optional
+            GPU memory budget (bytes) for cached textures, by default 256 MiB
+
+        Returns
+        -------
+        TextureCache
+            the cache, e.g., to inspect its stats()
+        """
+        if self.texture_cache is None:
+            self.texture_cache = TextureCache(budget)
+        else:
+            self.texture_cache.budget = budget
+            self.texture_cache._evict()
+        return self.texture_cache
+
+    def disable_texture_cache(self):
+        """Delete all cached textures, and stop caching."""
+        if self.texture_cache is not None:
+            self.texture_cache.clear()
+            self.texture_cache = None
+
     def flip(self, clr=True):
         """Swap display buffers to show rendered content.
 
@@ -287,11 +517,205 @@ class Graphics(ABC):
             clear the back buffer after flipping, by default True.
             Set to False to accumulate drawings across frames (useful for
             performance-sensitive scenarios).
+
+        Returns
+        -------
+        int or None
+            frame number of the flipped frame if onset timestamps are
+            enabled (see enable_onset_timestamps()), None otherwise
         """
+        if self.frame_packer is not None:
+            self.frame_packer.before_swap()
+        if self.line_verifier is not None:
+            self.line_verifier.before_swap()
+        frame = None
+        if self.onset_service is not None:
+            frame = self.onset_service.tag()
+        if self.overlay is not None:
+            self.overlay.apply()
+
         pygame.display.flip()
+        if self.line_verifier is not None:
+            self.line_verifier.after_swap()
         if clr:
             opengl.glClear(opengl.GL_COLOR_BUFFER_BIT)
 
+        return frame
+
+    def enable_onset_timestamps(self, **kwargs):
+        """Timestamp the onset of every flip() on the device clock.
+
+        VPixx devices only. Every flip() tags its frame with a unique pixel
+        sync pattern, and returns its frame number; a background thread
+        collects the time at which the device displayed the pattern.
+
+        Parameters
+        ----------
+        **kwargs
+            passed on to OnsetService (raster_line, timeout, blank_line)
+
+        Returns
+        -------
+        OnsetService
+            use its onset(frame) to get the onset of a frame
+        """
+        if self.onset_service is None:
+            self.onset_service = OnsetService(self, **kwargs)
+        return self.onset_service
+
+    def trigger(self, value=None, mask=0xFFFFFF, schedule=False):
+        """Set digital outputs (DOUT) at the onset of the next flip().
+
+        VPixx devices only, with onset timestamps enabled. The DOUT change
+        rides on the pixel sync of the next flipped frame, so it happens
+        when that frame is displayed, e.g., for EEG/MEG trigger codes.
+
+        Parameters
+        ----------
+        value : int, optional
+            DOUT value, by default None (outputs unchanged)
+        mask : int, optional
+            DOUT bits to set, by default all 24
+        schedule : bool, optional
+            start the DOUT schedule, by default False
+
+        Returns
+        -------
+        Trigger
+            with the device-clock time of the change, once displayed
+
+        Raises
+        ------
+        RuntimeError
+            if onset timestamps are not enabled
+        """
+        if self.onset_service is None:
+            raise RuntimeError("Triggers need onset timestamps: call enable_onset_timestamps() first")
+        return self.onset_service.trigger(value, mask=mask, schedule=schedule)
+
+    def disable_onset_timestamps(self):
+        """Collect the pending onsets, and stop tagging frames."""
+        if self.onset_service is not None:
+            self.onset_service.close()
+            self.onset_service = None
+
+    def enable_vsync_log(self, **kwargs):
+        """Log the time of every vertical sync on the device clock.
+
+        VPixx devices only. A background thread records every vsync, for the
+        measured refresh rate, its jitter, and gaps in the video signal. To
+        count frames dropped by the stimulus, use onset timestamps instead:
+        see timing.dropped_frames(). The log pauses while onset timestamps
+        are enabled, as both wait on the device.
+
+        Parameters
+        ----------
+        **kwargs
+            passed on to VsyncLog (capacity)
+
+        Returns
+        -------
+        VsyncLog
+            use its stats() for the session statistics
+        """
+        if self.vsync_log is None:
+            self.vsync_log = VsyncLog(**kwargs)
+        return self.vsync_log
+
+    def disable_vsync_log(self):
+        """Stop logging vsyncs."""
+        if self.vsync_log is not None:
+            self.vsync_log.close()
+            self.vsync_log = None
+
+    def enable_line_verification(self, row=0, every=1):
+        """Verify displayed pixels against the framebuffer on sampled flips.
+
+        VPixx devices only. Every Nth flip() compares a framebuffer row with
+        the pixels the device received, as captured by its video line
+        buffer, and records mismatches (e.g., from driver dithering or a GPU
+        gamma ramp). The line is read by a background thread two frames
+        after the swap, so sample flips of static displays. Flips are not
+        verified while onset timestamps are enabled (see LineVerifier).
+
+        Parameters
+        ----------
+        row : int, optional
+            framebuffer row (from the top) to verify, by default 0
+        every : int, optional
+            verify every Nth flip, by default 1
+
+        Returns
+        -------
+        LineVerifier
+            use its checks or failures() for the results
+        """
+        if self.line_verifier is not None:
+            self.line_verifier.close()
+        self.line_verifier = LineVerifier(self, row=row, every=every)
+        return self.line_verifier
+
+    def disable_line_verification(self):
+        """Check the pending flips, and stop verifying flips."""
+        if self.line_verifier is not None:
+            self.line_verifier.close()
+            self.line_verifier = None
+
+    def enable_horizontal_overlay(self):
+        """Composite the right half of the image over the left half.
+
+        VPixx devices only. The device blends the right (overlay) half over
+        a rectangle of the left (main) half, with a table of alpha values.
+        Changes to the rectangle and alpha table, scheduled with the
+        compositor's schedule(), take effect with the next flip().
+
+        Returns
+        -------
+        OverlayCompositor
+            to draw both halves, and schedule overlay changes
+        """
+        if self.overlay is None:
+            self.overlay = OverlayCompositor(self)
+        return self.overlay
+
+    def disable_horizontal_overlay(self):
+        """Show the full image again, without compositing."""
+        if self.overlay is not None:
+            self.overlay.close()
+            self.overlay = None
+
+    def enable_frame_packing(self, mode, blueline=True):
+        """Pack left/right images into a stereo or split-screen framebuffer.
+
+        VPixx devices only. In 'stereo' mode, the top and bottom halves of
+        the window are shown in sequential frames to the left and right eye;
+        in 'split' mode, the left and right halves are shown on VGA 1 and
+        VGA 2. Create image pairs with the packer's newTexture(left, right).
+
+        Parameters
+        ----------
+        mode : {'stereo', 'split'}
+            frame packing mode
+        blueline : bool, optional
+            in stereo mode, drive shutter glasses on the VESA 3D connector
+            by blueline codes drawn on every flip(), by default True
+
+        Returns
+        -------
+        FramePacker
+            to create StereoTextures, and map positions into each half
+        """
+        if self.frame_packer is not None:
+            self.frame_packer.close()
+        self.frame_packer = FramePacker(self, mode, blueline=blueline)
+        return self.frame_packer
+
+    def disable_frame_packing(self):
+        """Return to a monoscopic framebuffer."""
+        if self.frame_packer is not None:
+            self.frame_packer.close()
+            self.frame_packer = None
+
     def changeBackground(self, background):
         """Change display background color or intensity.
 
@@ -387,7 +811,7 @@ class Graphics_grey(Graphics):
 
         # Setup gamma correction for greyscale
         if self._lut is not None:
-            self.gamma_correct = partial(gamma_correct_grey, LUT=self._lut)
+            self.gamma_correct = partial(gamma_correct_grey, LUT=self._compiled_lut)
 
         # Set initial background (scalar value)
         bg = kwargs.get("background", 0.5)
@@ -487,7 +911,7 @@ class Graphics_RGB(Graphics):
 
         # Setup gamma correction for RGB
         if self._lut is not None:
-            self.gamma_correct = partial(gamma_correct_RGB, CLUT=self._lut)
+            self.gamma_correct = partial(gamma_correct_RGB, CLUT=self._compiled_lut)
 
         # Set initial background (use changeBackground which handles scalar/RGB conversion)
         background = kwargs.get("background", 0.5)
@@ -0,0 +1,233 @@
+"""Horizontal overlay: compositing of the two image halves in hardware.
+
+With the horizontal overlay enabled, VPixx devices show a composite of the
+left and right halves of the video image: inside a bounding rectangle of the
+left half, the right half is blended over it, with an alpha given by a table
+of 512 horizontal and 512 vertical 16-bit values (X0..X511, Y0..Y511). The
+main stimulus is rendered into the left half and, e.g., a fixation mark or a
+mask into the right half.
+
+An OverlayCompositor renders both halves in one Batch draw, and changes the
+bounds and alpha of the overlay frame-locked: changes scheduled with
+schedule() are sent right before the next flip() swaps buffers, in one USB
+message that the device holds until the vertical sync at which the new frame
+appears. The overlay can thus be changed between two frames without
+re-rendering the main stimulus (flip with clr=False).
+
+Alpha tables are cached by content, and a table is only sent to the device
+if it differs from the one sent last.
+
+Example
+-------
+    overlay = ihrl.graphics.enable_horizontal_overlay()
+    overlay.add_main(stimulus, (100, 100))
+    overlay.add_overlay(fixation, (390, 290))
+    overlay.draw()
+    overlay.schedule(alpha=overlay.alpha_table(x=ramp, y=1.0), bounds=(380, 280, 420, 320))
+    ihrl.graphics.flip(clr=False)
+"""
+
+import ctypes
+
+import numpy as np
+
+from hrl.graphics.cache import array_digest
+from hrl.graphics.timing import DPX_LOCK
+
+# Entries of each (horizontal, vertical) profile of the alpha table
+ALPHA_ENTRIES = 512
+
+# Maximum 16-bit alpha value, i.e., fully opaque overlay
+ALPHA_MAX = 65535
+
+
+class OverlayCompositor:
+    """Renders and composites the left (main) and right (overlay) image halves.
+
+    Create with Graphics.enable_horizontal_overlay(), which enables the
+    overlay on the device; Graphics.flip() then sends scheduled changes.
+
+    Parameters
+    ----------
+    graphics : Graphics
+        graphics device, for its size and Batches
+    dpx : module, optional
+        libdpx bindings, by default pypixxlib._libdpx
+
+    Attributes
+    ----------
+    half_width : int
+        width of each image half in pixels
+    sent : int
+        number of alpha tables sent to the device
+    skipped : int
+        number of scheduled alpha tables not sent, as the device had them
+    """
+
+    def __init__(self, graphics, dpx=None):
+        if dpx is None:
+            from pypixxlib import _libdpx as dpx
+
+        self.graphics = graphics
+        self.dpx = dpx
+        self.half_width = graphics.width // 2
+        self.height = graphics.height
+        self.sent = 0
+        self.skipped = 0
+
+        self._tables = {}
+        self._device_digest = None
+        self._pending_alpha = None
+        self._pending_bounds = None
+        self._batch = None
+
+        with DPX_LOCK:
+            dpx.DPxEnableVidHorizOverlay()
+            dpx.DPxUpdateRegCache()
+
+    def alpha_table(self, x=1.0, y=1.0):
+        """Alpha table from a horizontal and a vertical profile.
+
+        Tables are cached: identical profiles return the same array.
+
+        Parameters
+        ----------
+        x : float or array-like, optional
+            horizontal profile, a scalar or 512 values, by default 1.0
+        y : float or array-like, optional
+            vertical profile, a scalar or 512 values, by default 1.0.
+            Float values in [0.0, 1.0] are scaled to the 16-bit range;
+            integer values are used as they are.
+
+        Returns
+        -------
+        ndarray
+            uint16 alpha table of 1024 values, X0..X511, Y0..Y511
+        """
+        table = np.concatenate([_alpha_profile(x), _alpha_profile(y)])
+        digest = array_digest(table)
+        return self._tables.setdefault(digest, table)
+
+    def schedule(self, alpha=None, bounds=None):
+        """Change the overlay on the next flip.
+
+        Parameters
+        ----------
+        alpha : ndarray, optional
+            alpha table of 1024 values, e.g., from alpha_table(); by
+            default unchanged
+        bounds : (int, int, int, int), optional
+            (x1, y1, x2, y2) of the composited rectangle, in pixels of the
+            left half; by default unchanged
+
+        Raises
+        ------
+        ValueError
+            if the alpha table does not have 1024 values, or the bounds are
+            outside the left half
+        """
+        if alpha is not None:
+            alpha = np.ascontiguousarray(alpha, dtype=np.uint16)
+            if alpha.shape != (2 * ALPHA_ENTRIES,):
+                raise ValueError(f"Alpha table needs {2 * ALPHA_ENTRIES} values, got {alpha.shape}")
+            self._pending_alpha = alpha
+        if bounds is not None:
+            x1, y1, x2, y2 = (int(b) for b in bounds)
+            if not (0 <= x1 <= x2 <= self.half_width and 0 <= y1 <= y2 <= self.height):
+                raise ValueError(
+                    f"Overlay bounds {bounds} outside the left half ({self.half_width}x{self.height})"
+                )
+            self._pending_bounds = (x1, y1, x2, y2)
+
+    def pending(self):
+        """Whether changes are scheduled for the next flip."""
+        return self._pending_alpha is not None or self._pending_bounds is not None
+
+    def apply(self):
+        """Send scheduled changes, to take effect on the next vertical sync.
+
+        Called by Graphics.flip() right before swapping buffers. Call it
+        directly to change the overlay on the next frame without a flip.
+
+        Returns
+        -------
+        bool
+            True if an alpha table was sent
+        """
+        if not self.pending():
+            return False
+
+        alpha = self._pending_alpha
+        if alpha is not None:
+            digest = array_digest(alpha)
+            if digest == self._device_digest:
+                self.skipped += 1
+                alpha = None
+
+        dpx = self.dpx
+        with DPX_LOCK:
+            if self._pending_bounds is not None:
+                dpx.DPxSetVidHorizOverlayBounds(*self._pending_bounds)
+            write = getattr(dpx, "DPxWriteVidHorizOverlayAfterVideoSync", None)
+            if write is not None:
+                write(None if alpha is None else _alpha_array(alpha))
+            else:
+                # Bindings without the combined message: the alpha table
+                # takes effect immediately, not on the vertical sync
+                dpx.DPxWriteRegCacheAfterVideoSync()
+                if alpha is not None:
+                    dpx.DPxSetVidHorizOverlayAlpha(_alpha_array(alpha))
+
+        self._pending_alpha = None
+        self._pending_bounds = None
+        if alpha is None:
+            return False
+        self._device_digest = digest
+        self.sent += 1
+        return True
+
+    def add_main(self, texture, pos, sz=None, rot=0, rotc=None):
+        """Add a draw into the left (main) half, as Texture.draw()."""
+        self._get_batch().add(texture, pos, sz, rot, rotc)
+
+    def add_overlay(self, texture, pos, sz=None, rot=0, rotc=None):
+        """Add a draw into the right (overlay) half, as Texture.draw().
+
+        Positions are relative to the overlay half, i.e., the same as in
+        the composited image.
+        """
+        self._get_batch().add(texture, (pos[0] + self.half_width, pos[1]), sz, rot, rotc)
+
+    def draw(self):
+        """Render all added draws of both halves in one pass, and clear them."""
+        if self._batch is not None:
+            self._batch.draw()
+            self._batch.clear()
+
+    def close(self):
+        """Disable the overlay on the device."""
+        with DPX_LOCK:
+            self.dpx.DPxDisableVidHorizOverlay()
+            self.dpx.DPxUpdateRegCache()
+        self._device_digest = None
+
+    def _get_batch(self):
+        if self._batch is None:
+            self._batch = self.graphics.newBatch()
+        return self._batch
+
+
+def _alpha_profile(profile):
+    """One 512-entry profile of an alpha table, as uint16"""
+    profile = np.asarray(profile)
+    if profile.dtype.kind in "iu":
+        values = np.clip(profile, 0, ALPHA_MAX)
+    else:
+        values = np.round(np.clip(profile, 0.0, 1.0) * ALPHA_MAX)
+    return np.broadcast_to(values, (ALPHA_ENTRIES,)).astype(np.uint16)
+
+
+def _alpha_array(table):
+    """An alpha table as the C array of uint16 taken by the libdpx bindings"""
+    table = np.ascontiguousarray(table, dtype=np.uint16)
+    return (ctypes.c_uint16 * table.size).from_buffer_copy(table)
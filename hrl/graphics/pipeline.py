@@ -0,0 +1,120 @@
+"""Background preparation of stimuli in worker threads.
+
+Normally, the whole path from stimulus generation through gamma correction
+and encoding to the texture upload runs on the main thread between trials,
+so the inter-trial interval depends on how long the next stimulus takes to
+compute. A StimulusPipeline runs the generation and encoding of upcoming
+trials in worker threads while the current trial is presented. The numpy
+kernels of the encoders release the GIL, so this runs in parallel. Only the
+final texture upload remains on the render thread, as OpenGL requires.
+
+Example
+-------
+    pipeline = ihrl.graphics.newPipeline()
+    pending = pipeline.submit(make_stimulus, trials[0])
+    for i, trial in enumerate(trials):
+        textures = pending.textures()       # upload, on the render thread
+        if i + 1 < len(trials):
+            pending = pipeline.submit(make_stimulus, trials[i + 1])
+        ... present trial with textures ...
+    pipeline.close()
+"""
+
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+
+from hrl.graphics.texture import Texture
+
+
+class PendingStimulus:
+    """Stimulus being generated and encoded in a worker thread.
+
+    Returned by StimulusPipeline.submit().
+    """
+
+    def __init__(self, future, graphics, shape):
+        self._future = future
+        self._graphics = graphics
+        self._shape = shape
+        self._textures = None
+
+    def done(self):
+        """Whether generation and encoding have finished."""
+        return self._future.done()
+
+    def textures(self):
+        """Upload the encoded images as textures, on the calling thread.
+
+        Waits for the worker if it has not finished yet. Must be called on
+        the thread that owns the OpenGL context. Any exception raised while
+        generating or encoding is re-raised here.
+
+        Returns
+        -------
+        Texture, list of Texture or dict of Texture
+            same structure as returned by the generating function
+        """
+        if self._textures is None:
+            encoded = self._future.result()
+            ring = self._graphics.upload_ring
+            upload = lambda pixels: Texture(
+                pixels.tobytes(), pixels.shape[1], pixels.shape[0], self._shape, ring=ring
+            )
+            self._textures = _map_images(upload, encoded)
+        return self._textures
+
+
+class StimulusPipeline:
+    """Worker threads that generate and encode stimuli ahead of time.
+
+    Create with Graphics.newPipeline().
+
+    Parameters
+    ----------
+    graphics : Graphics
+        graphics device, whose encode_image() is used
+    workers : int, optional
+        number of worker threads, by default 2
+    """
+
+    def __init__(self, graphics, workers=2):
+        self.graphics = graphics
+        self._executor = ThreadPoolExecutor(max_workers=workers, thread_name_prefix="hrl-stimulus")
+
+    def submit(self, generate, *args, shape="square", **kwargs):
+        """Generate and encode a stimulus in a worker thread.
+
+        Parameters
+        ----------
+        generate : callable
+            called as generate(*args, **kwargs) in a worker thread. Returns
+            an image array, or a list or dict of image arrays, with values
+            in [0.0, 1.0] as for newTexture. Must not call OpenGL.
+        shape : {'square', 'circle'}, optional
+            shape mask of the textures, by default 'square'
+
+        Returns
+        -------
+        PendingStimulus
+            use its textures() to upload and get the textures
+        """
+        encode = self.graphics.encode_image
+
+        def prepare():
+            return _map_images(encode, generate(*args, **kwargs))
+
+        return PendingStimulus(self._executor.submit(prepare), self.graphics, shape)
+
+    def close(self):
+        """Wait for pending work, and stop the worker threads."""
+        self._executor.shutdown(wait=True)
+
+
+def _map_images(func, images):
+    """Apply func to an image array, or to each in a list or dict"""
+    if isinstance(images, dict):
+        return {key: func(np.asarray(image)) for key, image in images.items()}
+    if isinstance(images, (list, tuple)):
+        return [func(np.asarray(image)) for image in images]
+    return func(np.asarray(images))
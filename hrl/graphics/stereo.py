@@ -0,0 +1,222 @@
+"""Stereo and split-screen frame packing for VPixx devices.
+
+In vertical stereo mode, the device shows the top and bottom halves of the
+framebuffer in two sequential video frames, for the left and the right eye.
+In horizontal split mode, VGA 1 shows the left half of the framebuffer and
+VGA 2 the right half, e.g., for a haploscope with two monitors. In both, the
+window is twice the height (stereo) or width (split) of what each eye sees.
+
+A FramePacker sets up the device for a mode, and packs stimulus pairs:
+newTexture(left, right) encodes both images into one texture, with a single
+upload, and returns a StereoTexture that draws each image at the same
+position in its half of the framebuffer. Pairs no longer need to be
+assembled into double-height arrays by hand.
+
+In stereo mode, the VESA 3D connector (shutter glasses, emitters) follows
+blueline codes in the video signal: before every swap, the last raster line
+of each eye is drawn as a blue line over 25% (left eye) or 75% (right eye)
+of its width, so that the middle pixel tells the device which eye a frame
+is for.
+"""
+
+import numpy as np
+import OpenGL.GL as opengl
+
+from hrl.graphics.atlas import AtlasTexture
+from hrl.graphics.timing import DPX_LOCK
+
+MODES = ("stereo", "split")
+
+# Fraction of the last raster line drawn blue, per eye
+BLUELINE = {"left": 0.25, "right": 0.75}
+
+
+class StereoTexture:
+    """Pair of left and right images in one packed texture.
+
+    Created by FramePacker.newTexture(). Draws like a Texture, with
+    positions relative to each eye's half of the framebuffer.
+
+    Attributes
+    ----------
+    texture : Texture
+        packed texture of both images
+    left : AtlasTexture
+        sub-rectangle of the left image
+    right : AtlasTexture
+        sub-rectangle of the right image
+    """
+
+    def __init__(self, texture, packer):
+        self.texture = texture
+        self.packer = packer
+        if packer.mode == "stereo":
+            wdth, hght = texture.wdth, texture.hght // 2
+            regions = ((0.0, 0.0, 1.0, 0.5), (0.0, 0.5, 1.0, 0.5))
+        else:
+            wdth, hght = texture.wdth // 2, texture.hght
+            regions = ((0.0, 0.0, 0.5, 1.0), (0.5, 0.0, 0.5, 1.0))
+        self.wdth = wdth
+        self.hght = hght
+        self.left = AtlasTexture(texture._txid, wdth, hght, regions[0])
+        self.right = AtlasTexture(texture._txid, wdth, hght, regions[1])
+
+    def draw(self, pos=(0, 0), sz=None, rot=0, rotc=None):
+        """Draw both images, each at pos within its eye's half.
+
+        Parameters as for Texture.draw().
+        """
+        for eye, texture in (("left", self.left), ("right", self.right)):
+            texture.draw(self.packer.position(eye, pos), sz, rot, rotc)
+
+    def add_to(self, batch, pos=(0, 0), sz=None, rot=0, rotc=None):
+        """Add the draws of both images to a Batch.
+
+        Parameters as for Batch.add().
+        """
+        for eye, texture in (("left", self.left), ("right", self.right)):
+            batch.add(texture, self.packer.position(eye, pos), sz, rot, rotc)
+
+    def delete(self):
+        """Remove the packed texture and the display lists of both images"""
+        self.left.delete()
+        self.right.delete()
+        self.texture.delete()
+
+
+class FramePacker:
+    """Packs left/right images into a stereo or split-screen framebuffer.
+
+    Create with Graphics.enable_frame_packing(), which configures the
+    device; Graphics.flip() then draws the blueline codes.
+
+    Parameters
+    ----------
+    graphics : Graphics
+        graphics device, whose newTexture() encodes and uploads pairs
+    mode : {'stereo', 'split'}
+        'stereo' for top (left eye) / bottom (right eye) halves shown in
+        sequential frames, 'split' for left / right halves on VGA 1 / VGA 2
+    blueline : bool, optional
+        in stereo mode, drive the VESA 3D connector by blueline codes, by
+        default True
+    dpx : module, optional
+        libdpx bindings, by default pypixxlib._libdpx
+
+    Attributes
+    ----------
+    size : (int, int)
+        width and height in pixels of each eye's half
+    """
+
+    def __init__(self, graphics, mode, blueline=True, dpx=None):
+        if mode not in MODES:
+            raise ValueError(f"Unknown frame packing mode '{mode}', use one of {MODES}")
+        if dpx is None:
+            from pypixxlib import _libdpx as dpx
+
+        self.graphics = graphics
+        self.mode = mode
+        self.blueline = blueline and mode == "stereo"
+        self.dpx = dpx
+
+        if mode == "stereo":
+            self.size = (graphics.width, graphics.height // 2)
+            self._origins = {"left": (0, 0), "right": (0, graphics.height // 2)}
+        else:
+            self.size = (graphics.width // 2, graphics.height)
+            self._origins = {"left": (0, 0), "right": (graphics.width // 2, 0)}
+        self._bluelines = self._build_bluelines() if self.blueline else None
+
+        with DPX_LOCK:
+            if mode == "stereo":
+                dpx.DPxEnableVidVertStereo()
+                if self.blueline:
+                    dpx.DPxEnableVidVesaBlueline()
+                else:
+                    dpx.DPxDisableVidVesaBlueline()
+            else:
+                dpx.DPxEnableVidHorizSplit()
+            dpx.DPxUpdateRegCache()
+
+    def position(self, eye, pos=(0, 0)):
+        """Framebuffer position of a position within an eye's half.
+
+        Parameters
+        ----------
+        eye : {'left', 'right'}
+        pos : (float, float), optional
+            position within the half, by default (0, 0)
+
+        Returns
+        -------
+        (float, float)
+        """
+        x0, y0 = self._origins[eye]
+        return (x0 + pos[0], y0 + pos[1])
+
+    def newTexture(self, left, right):
+        """Encode a left/right image pair into one packed texture.
+
+        Parameters
+        ----------
+        left : ndarray
+            left eye (or VGA 1) image, as for Graphics.newTexture
+        right : ndarray
+            right eye (or VGA 2) image, of the same shape
+
+        Returns
+        -------
+        StereoTexture
+            draws both images, always as squares
+
+        Raises
+        ------
+        ValueError
+            if the images differ in shape
+        """
+        left = np.asarray(left)
+        right = np.asarray(right)
+        if left.shape != right.shape:
+            raise ValueError(f"Left and right images differ in shape: {left.shape}, {right.shape}")
+
+        axis = 0 if self.mode == "stereo" else 1
+        texture = self.graphics.newTexture(np.concatenate([left, right], axis=axis))
+        return StereoTexture(texture, self)
+
+    def before_swap(self):
+        """Draw the blueline codes onto the last raster line of each eye.
+
+        Called by Graphics.flip() after all drawing.
+        """
+        if self._bluelines is None:
+            return
+
+        wdth, hght = self.size
+        opengl.glDisable(opengl.GL_TEXTURE_2D)
+        for eye, pixels in self._bluelines.items():
+            # Window coordinates count rows from the bottom
+            row = self._origins[eye][1] + hght - 1
+            opengl.glWindowPos2i(0, self.graphics.height - 1 - row)
+            opengl.glDrawPixels(wdth, 1, opengl.GL_RGBA, opengl.GL_UNSIGNED_BYTE, pixels)
+        opengl.glEnable(opengl.GL_TEXTURE_2D)
+
+    def close(self):
+        """Return the device to automatic stereo and split detection."""
+        with DPX_LOCK:
+            if self.mode == "stereo":
+                self.dpx.DPxAutoVidVertStereo()
+                self.dpx.DPxDisableVidVesaBlueline()
+            else:
+                self.dpx.DPxAutoVidHorizSplit()
+            self.dpx.DPxUpdateRegCache()
+
+    def _build_bluelines(self):
+        wdth = self.size[0]
+        bluelines = {}
+        for eye, fraction in BLUELINE.items():
+            line = np.zeros((wdth, 4), dtype=np.uint8)
+            line[:, 3] = 255
+            line[: int(round(fraction * wdth)), 2] = 255
+            bluelines[eye] = line.tobytes()
+        return bluelines
@@ -1,3 +1,4 @@
+import ctypes
 import warnings
 
 import numpy as np
@@ -10,30 +11,46 @@ class Texture:
     OpenGL. It's only method is the draw method.
     """
 
-    def __init__(self, byts, wdth, hght, shape):
+    # Sub-rectangle (u, v, width, height) of the GL texture that is drawn
+    region = (0.0, 0.0, 1.0, 1.0)
+
+    def __init__(self, byts, wdth, hght, shape, ring=None):
         """
         The internal constructor for Textures. Users should use
         Graphics.newTexture to create textures rather than this constructor.
 
         Parameters
         ----------
-        byts : A bytestring representation of the greyscale array
+        byts : A bytestring representation of the greyscale array, or a
+            PixelSlot of an UploadRing that the encoded pixels were written to
         wdth : The width of the array
         hght : The height of the array
         shape : The shape to 'cut out' of the given greyscale array. A square
             will render the entire array. Available: 'square', 'circle'
+        ring : An UploadRing to stream bytestrings through, instead of
+            uploading them synchronously. Default: None
 
         Returns
         -------
         Texture object
         """
-        self._txid, self.wdth, self.hght = loadTexture(byts, wdth, hght)
-        if shape == "square":
-            self._dlid = createSquareDL(self._txid, self.wdth, self.hght)
-        elif shape == "circle":
-            self._dlid = createCircleDL(self._txid, self.wdth, self.hght)
-        else:
+        if shape not in ("square", "circle"):
             raise NameError("Invalid Shape")
+        self.shape = shape
+
+        self._slot = None
+        if isinstance(byts, PixelSlot):
+            self._slot = byts
+            self._txid, self.wdth, self.hght = byts.ring.upload(byts, wdth, hght)
+        elif ring is not None:
+            self._slot = ring.stage(len(byts))
+            self._slot.array[:] = np.frombuffer(byts, dtype=np.uint8)
+            self._txid, self.wdth, self.hght = ring.upload(self._slot, wdth, hght)
+        else:
+            self._txid, self.wdth, self.hght = loadTexture(byts, wdth, hght)
+
+        # Display list is compiled on first draw(); a Batch does not need one
+        self._dlid = None
 
     def draw(self, pos=None, sz=None, rot=0, rotc=None):
         """
@@ -72,8 +89,22 @@ class Texture:
             (wdth, hght) = sz
             opengl.glScalef(wdth / (self.wdth * 1.0), hght / (self.hght * 1.0), 1.0)
 
+        if self._dlid is None and self._txid is not None:
+            if self.shape == "square":
+                self._dlid = createSquareDL(self._txid, self.wdth, self.hght, self.region)
+            else:
+                self._dlid = createCircleDL(self._txid, self.wdth, self.hght)
+
         opengl.glCallList(self._dlid)
 
+    def ready(self):
+        """
+        Whether the upload of this Texture has completed on the GPU. Drawing
+        is always safe: OpenGL orders the draw after the upload. This only
+        tells whether drawing would have to wait for it.
+        """
+        return self._slot is None or self._slot.done()
+
     #def __del__(self):
     #    self.delete()
     
@@ -121,32 +152,198 @@ def loadTexture(byts, wdth, hght):
     return txid, wdth, hght
 
 
+## Streaming uploads through Pixel Buffer Objects ##
+
+
+class PixelSlot:
+    """
+    One staging buffer of an UploadRing, handed out by UploadRing.stage. The
+    encoded RGBA pixels are to be written into its array, which is mapped
+    memory of a pixel buffer object (PBO), before creating a Texture from it.
+    """
+
+    def __init__(self, ring, index, generation, array):
+        self.ring = ring
+        self.index = index
+        self.generation = generation
+        self.array = array
+
+    def done(self):
+        """Whether the GPU has finished uploading from this slot."""
+        return self.ring.done(self.index, self.generation)
+
+
+class UploadRing:
+    """
+    A ring of pixel buffer objects (PBOs) for asynchronous texture uploads.
+
+    Encoded pixels are written straight into mapped PBO memory, and
+    glTexImage2D copies from the PBO, so the driver can DMA the pixels to the
+    GPU while the CPU continues, e.g. to prepare the next stimulus. A fence
+    per PBO signals when its upload has completed; a PBO is only reused
+    after that, so at most n_buffers uploads are in flight.
+
+    If the OpenGL context supports it (OpenGL 4.4 or ARB_buffer_storage),
+    the PBOs are persistently mapped. Otherwise each upload orphans and maps
+    its PBO anew.
+    """
+
+    def __init__(self, n_buffers=3, size=1920 * 1080 * 4):
+        self.n_buffers = n_buffers
+        self.persistent = bool(opengl.glBufferStorage)
+        self._pbos = list(opengl.glGenBuffers(n_buffers)) if n_buffers > 1 else [opengl.glGenBuffers(1)]
+        self._sizes = [0] * n_buffers
+        self._arrays = [None] * n_buffers
+        self._fences = [None] * n_buffers
+        self._generations = [0] * n_buffers
+        self._next = 0
+
+        for index in range(n_buffers):
+            self._allocate(index, size)
+
+    def _allocate(self, index, size):
+        flags = opengl.GL_MAP_WRITE_BIT
+        opengl.glBindBuffer(opengl.GL_PIXEL_UNPACK_BUFFER, self._pbos[index])
+        if self.persistent:
+            # Immutable storage: replace the buffer to grow it
+            if self._sizes[index]:
+                opengl.glUnmapBuffer(opengl.GL_PIXEL_UNPACK_BUFFER)
+                opengl.glDeleteBuffers(1, [self._pbos[index]])
+                self._pbos[index] = opengl.glGenBuffers(1)
+                opengl.glBindBuffer(opengl.GL_PIXEL_UNPACK_BUFFER, self._pbos[index])
+            flags |= opengl.GL_MAP_PERSISTENT_BIT | opengl.GL_MAP_COHERENT_BIT
+            opengl.glBufferStorage(opengl.GL_PIXEL_UNPACK_BUFFER, size, None, flags)
+            self._arrays[index] = _map(size, flags)
+        else:
+            opengl.glBufferData(opengl.GL_PIXEL_UNPACK_BUFFER, size, None, opengl.GL_STREAM_DRAW)
+        opengl.glBindBuffer(opengl.GL_PIXEL_UNPACK_BUFFER, 0)
+        self._sizes[index] = size
+
+    def stage(self, nbytes):
+        """
+        Get the next PBO in the ring, to write nbytes of encoded pixels to.
+        Waits until the GPU has finished the previous upload from this PBO.
+
+        Parameters
+        ----------
+        nbytes : Number of bytes to write (width * height * 4)
+
+        Returns
+        -------
+        PixelSlot, whose array is a writable uint8 view of nbytes
+        """
+        index = self._next
+        self._next = (index + 1) % self.n_buffers
+        self.wait(index)
+
+        if nbytes > self._sizes[index]:
+            self._allocate(index, nbytes)
+
+        if self.persistent:
+            array = self._arrays[index]
+        else:
+            # Orphan the old storage, so mapping does not wait for the GPU
+            opengl.glBindBuffer(opengl.GL_PIXEL_UNPACK_BUFFER, self._pbos[index])
+            opengl.glBufferData(
+                opengl.GL_PIXEL_UNPACK_BUFFER, self._sizes[index], None, opengl.GL_STREAM_DRAW
+            )
+            array = _map(nbytes, opengl.GL_MAP_WRITE_BIT | opengl.GL_MAP_INVALIDATE_BUFFER_BIT)
+            opengl.glBindBuffer(opengl.GL_PIXEL_UNPACK_BUFFER, 0)
+
+        self._generations[index] += 1
+        return PixelSlot(self, index, self._generations[index], array[:nbytes])
+
+    def upload(self, slot, wdth, hght):
+        """
+        Create a texture from the pixels written to slot. Returns without
+        waiting for the transfer; a fence marks its completion.
+        """
+        index = slot.index
+        opengl.glBindBuffer(opengl.GL_PIXEL_UNPACK_BUFFER, self._pbos[index])
+        if not self.persistent:
+            opengl.glUnmapBuffer(opengl.GL_PIXEL_UNPACK_BUFFER)
+
+        # With a PBO bound, the pixel pointer is an offset into the PBO
+        txid, wdth, hght = loadTexture(None, wdth, hght)
+        opengl.glBindBuffer(opengl.GL_PIXEL_UNPACK_BUFFER, 0)
+
+        self._fences[index] = opengl.glFenceSync(opengl.GL_SYNC_GPU_COMMANDS_COMPLETE, 0)
+        opengl.glFlush()
+
+        return txid, wdth, hght
+
+    def done(self, index, generation):
+        """Whether the upload of the given generation of a PBO has completed."""
+        if generation != self._generations[index] or self._fences[index] is None:
+            return True
+        status = opengl.glClientWaitSync(self._fences[index], 0, 0)
+        return status in (opengl.GL_ALREADY_SIGNALED, opengl.GL_CONDITION_SATISFIED)
+
+    def wait(self, index):
+        """Block until the last upload from a PBO has completed."""
+        fence = self._fences[index]
+        if fence is None:
+            return
+        while opengl.glClientWaitSync(
+            fence, opengl.GL_SYNC_FLUSH_COMMANDS_BIT, 10**9
+        ) == opengl.GL_TIMEOUT_EXPIRED:
+            pass
+        opengl.glDeleteSync(fence)
+        self._fences[index] = None
+
+    def delete(self):
+        """Wait for all uploads, then unmap and delete the PBOs."""
+        for index in range(self.n_buffers):
+            self.wait(index)
+            if self.persistent:
+                opengl.glBindBuffer(opengl.GL_PIXEL_UNPACK_BUFFER, self._pbos[index])
+                opengl.glUnmapBuffer(opengl.GL_PIXEL_UNPACK_BUFFER)
+        opengl.glBindBuffer(opengl.GL_PIXEL_UNPACK_BUFFER, 0)
+        opengl.glDeleteBuffers(self.n_buffers, self._pbos)
+        self._arrays = [None] * self.n_buffers
+
+
+def _map(size, flags):
+    """Map the bound pixel unpack buffer, as writable uint8 numpy array."""
+    pointer = opengl.glMapBufferRange(opengl.GL_PIXEL_UNPACK_BUFFER, 0, size, flags)
+    address = pointer if isinstance(pointer, int) else ctypes.cast(pointer, ctypes.c_void_p).value
+    buffer = (ctypes.c_ubyte * size).from_address(address)
+    return np.frombuffer(buffer, dtype=np.uint8)
+
+
 ## OpenGL Display List Functions ##
 
+# Outline of the circle shape: 360 points, radius 0.5 around the origin
+UNIT_CIRCLE = np.column_stack(
+    [np.cos(np.linspace(0, 2 * np.pi, 360)) / 2, np.sin(np.linspace(0, 2 * np.pi, 360)) / 2]
+)
+
 
-def createSquareDL(txid, wdth, hght):
+def createSquareDL(txid, wdth, hght, region=(0.0, 0.0, 1.0, 1.0)):
     """
     createSquareDL takes a texture id with width and height and
     generates a display list - an precompiled set of instructions for
     rendering the image. This speeds up image display. The instructions
     compiled are essentially creating a square and binding the texture
-    to it.
+    to it. The optional region (u, v, width, height) selects a
+    sub-rectangle of the texture, e.g., in a TextureAtlas.
     """
+    (u, v, uw, vh) = region
+
     dlid = opengl.glGenLists(1)
     opengl.glNewList(dlid, opengl.GL_COMPILE)
     opengl.glBindTexture(opengl.GL_TEXTURE_2D, txid)
 
     opengl.glBegin(opengl.GL_QUADS)
-    opengl.glTexCoord2f(0, 0)
+    opengl.glTexCoord2f(u, v)
     opengl.glVertex2f(0, 0)
-    opengl.glTexCoord2f(0, 1)
+    opengl.glTexCoord2f(u, v + vh)
     opengl.glVertex2f(0, hght)
-    opengl.glTexCoord2f(1, 1)
+    opengl.glTexCoord2f(u + uw, v + vh)
     opengl.glVertex2f(wdth, hght)
-    opengl.glTexCoord2f(1, 0)
+    opengl.glTexCoord2f(u + uw, v)
     opengl.glVertex2f(wdth, 0)
     opengl.glEnd()
-    opengl.glFinish()
 
     opengl.glEndList()
 
@@ -167,13 +364,11 @@ def createCircleDL(txid, wdth, hght):
 
     opengl.glBegin(opengl.GL_TRIANGLE_FAN)
 
-    for ang in np.linspace(0, 2 * np.pi, 360):
-        (x, y) = ((np.cos(ang)) / 2, (np.sin(ang)) / 2)
+    for x, y in UNIT_CIRCLE:
         opengl.glTexCoord2f(x, y)
         opengl.glVertex2f(x * wdth, y * hght)
 
     opengl.glEnd()
-    opengl.glFinish()
 
     opengl.glEndList()
 
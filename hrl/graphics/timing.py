@@ -0,0 +1,735 @@
+"""Display timing services for VPixx devices.
+
+OnsetService
+    One verified stimulus-onset timestamp per flip(), from the device clock,
+    using pixel sync: each flip is tagged with a unique pixel pattern, and the
+    device latches its clock when that pattern is scanned out. Digital
+    output triggers (DOUT) can ride on the same pixel sync.
+VsyncLog
+    Device-clock timestamp of every vertical sync, with refresh period,
+    jitter and gap statistics.
+RasterModel
+    Scan-out time of any raster line of any frame, fitted to vsync times.
+
+The services talk to the device from background I/O threads, so the render
+thread never waits on USB. libdpx is not thread-safe: while a service is
+running, other libdpx calls should hold `DPX_LOCK`. It is granted in the
+order it was requested, so a service that waits on the device in a loop
+cannot lock out the other threads.
+"""
+
+import collections
+import queue
+import threading
+
+import numpy as np
+import OpenGL.GL as opengl
+
+# First pixel of every pixel sync pattern; the second pixel holds the frame
+PSYNC_MAGIC = (0xF0, 0x0F, 0xA5)
+
+# Intervals longer than this many video periods count as missed frames
+GAP_PERIODS = 1.5
+
+
+class FifoLock:
+    """Lock granted in the order it was requested.
+
+    A threading.Lock may be taken again by the thread that just released
+    it, ahead of threads that have been waiting: a loop that holds it
+    across a blocking call, like the VsyncLog, could starve all others.
+    """
+
+    def __init__(self):
+        self._mutex = threading.Lock()
+        self._waiters = collections.deque()
+        self._locked = False
+
+    def acquire(self):
+        with self._mutex:
+            if not self._locked:
+                self._locked = True
+                return True
+            waiter = threading.Lock()
+            waiter.acquire()
+            self._waiters.append(waiter)
+        # release() hands the lock over by releasing the waiter
+        waiter.acquire()
+        return True
+
+    def release(self):
+        with self._mutex:
+            if self._waiters:
+                self._waiters.popleft().release()
+            else:
+                self._locked = False
+
+    def locked(self):
+        return self._locked
+
+    def __enter__(self):
+        return self.acquire()
+
+    def __exit__(self, *exc_info):
+        self.release()
+
+
+# Serializes libdpx calls of all services (and of any other thread)
+DPX_LOCK = FifoLock()
+
+
+def psync_pattern(frame):
+    """Unique pixel sync pattern (2 RGB pixels) for a frame number.
+
+    Parameters
+    ----------
+    frame : int
+        frame number; patterns repeat after 2**24 frames
+
+    Returns
+    -------
+    bytes
+        R0, G0, B0, R1, G1, B1
+    """
+    frame %= 2**24
+    return bytes(PSYNC_MAGIC) + bytes([frame >> 16, (frame >> 8) & 0xFF, frame & 0xFF])
+
+
+# DOUT bits of all 24 digital outputs
+DOUT_MASK = 0xFFFFFF
+
+
+class Trigger:
+    """Digital output trigger, released by the pixel sync of a frame.
+
+    Attributes
+    ----------
+    frame : int
+        frame number of the flip that carried the trigger; a later flip
+        than the one it was attached to if the I/O thread skipped frames
+    value : int or None
+        DOUT value set, or None if only a DOUT schedule was started
+    mask : int
+        DOUT bits set
+    schedule : bool
+        whether the DOUT schedule was started
+    time : float or None
+        time in seconds on the device clock at which the DOUT changed, the
+        onset of the frame; None if not (yet) known, or if the pattern was
+        not seen (the device then applied the trigger after the timeout)
+    """
+
+    def __init__(self, frame, value, mask, schedule):
+        self.frame = frame
+        self.value = value
+        self.mask = mask
+        self.schedule = schedule
+        self.time = None
+
+    def __repr__(self):
+        return f"Trigger(frame={self.frame}, value={self.value}, time={self.time})"
+
+
+class OnsetService:
+    """Stimulus-onset timestamps through pixel sync and the device marker.
+
+    tag() draws a unique pixel sync pattern onto the raster line and queues
+    the frame to the I/O thread. That thread latches the device marker as
+    soon as the pattern is displayed: it sets the marker in the register
+    cache, and writes it with DPxUpdateRegCacheAfterPixelSync(), which the
+    device holds back until the pattern appears. The latched marker time is
+    the onset of that frame, in seconds on the device clock.
+
+    The I/O thread must issue the wait before the tagged frame is displayed.
+    If it lags behind by more than a frame, the pattern has already been
+    replaced and the wait times out: the onset of that frame is None, never
+    a wrong time. After a timeout, the thread skips the frames queued in the
+    meantime, whose onsets are None too, and waits for the newest one, so
+    that it catches up instead of timing out on every frame after.
+
+    trigger() attaches a DOUT value (e.g., an EEG trigger code) or the start
+    of a DOUT schedule to the next tagged frame. It is written in the same
+    register write as the marker, so the device changes the outputs exactly
+    when it latches the onset, with no host-side jitter in between.
+
+    Create with Graphics.enable_onset_timestamps(); Graphics.flip() then
+    tags every frame and returns its frame number. A VsyncLog and a
+    LineVerifier pause while the service is running.
+
+    Parameters
+    ----------
+    graphics : Graphics
+        graphics device, for its height
+    raster_line : int, optional
+        raster line (from the top) carrying the pattern, by default 0
+    timeout : int, optional
+        maximum number of video frames to wait for a pattern, by default 6
+    blank_line : bool, optional
+        display the raster line black, hiding the pattern, by default False
+    dpx : module, optional
+        libdpx bindings, by default pypixxlib._libdpx
+    """
+
+    # Number of running services; VsyncLogs wait for changes
+    running = 0
+    changed = threading.Condition()
+
+    def __init__(self, graphics, raster_line=0, timeout=6, blank_line=False, dpx=None):
+        if dpx is None:
+            from pypixxlib import _libdpx as dpx
+
+        self.graphics = graphics
+        self.raster_line = raster_line
+        self.timeout = timeout
+        self.dpx = dpx
+        self.lock = DPX_LOCK
+
+        # Only recognize patterns on the tagged raster line
+        with self.lock:
+            dpx.DPxSetVidPsyncRasterLine(raster_line)
+            dpx.DPxEnableVidPsyncSingleLine()
+            if blank_line:
+                dpx.DPxEnableVidPsyncBlankLine()
+            else:
+                dpx.DPxDisableVidPsyncBlankLine()
+            dpx.DPxUpdateRegCache()
+
+        self._next_frame = 0
+        self._onsets = {}
+        self._trigger = None
+        self._triggers = []
+        self._done = threading.Condition()
+        self._queue = queue.Queue()
+        self._thread = threading.Thread(target=self._run, name="hrl-onsets", daemon=True)
+        self._thread.start()
+        with OnsetService.changed:
+            OnsetService.running += 1
+            OnsetService.changed.notify_all()
+
+    def tag(self):
+        """Draw the pattern of the next frame into the back buffer, and queue it.
+
+        Call right before swapping buffers, after all other drawing.
+
+        Returns
+        -------
+        int
+            frame number, to look up its onset
+        """
+        frame = self._next_frame
+        self._next_frame += 1
+        pattern = psync_pattern(frame)
+        trigger, self._trigger = self._trigger, None
+        if trigger is not None:
+            trigger.frame = frame
+
+        # Raw RGBA pixels, unaffected by texturing, LUT or encoding
+        pixels = np.frombuffer(pattern, dtype=np.uint8).reshape(2, 3)
+        pixels = np.hstack([pixels, np.full((2, 1), 255, dtype=np.uint8)])
+        opengl.glDisable(opengl.GL_TEXTURE_2D)
+        opengl.glWindowPos2i(0, self.graphics.height - 1 - self.raster_line)
+        opengl.glDrawPixels(2, 1, opengl.GL_RGBA, opengl.GL_UNSIGNED_BYTE, pixels.tobytes())
+        opengl.glEnable(opengl.GL_TEXTURE_2D)
+
+        self._queue.put((frame, pattern, trigger))
+        return frame
+
+    def trigger(self, value=None, mask=DOUT_MASK, schedule=False):
+        """Attach a digital output trigger to the next tagged frame.
+
+        The device sets the DOUT bits (and/or starts the DOUT schedule) when
+        the frame is displayed. DOUT values persist: reset them with another
+        trigger on a later frame, or play a pulse with a DOUT schedule set
+        up beforehand (DPxSetDoutBuff, DPxSetDoutSched).
+
+        Parameters
+        ----------
+        value : int, optional
+            DOUT value, by default None (outputs unchanged)
+        mask : int, optional
+            DOUT bits to set, by default all 24
+        schedule : bool, optional
+            start the DOUT schedule, by default False
+
+        Returns
+        -------
+        Trigger
+            its frame and time are filled in once the frame is tagged and
+            displayed
+        """
+        trigger = Trigger(None, value, mask, schedule)
+        self._trigger = trigger
+        return trigger
+
+    def _drain(self):
+        """Take all queued frames, leaving a stop request in the queue."""
+        items = []
+        while True:
+            try:
+                item = self._queue.get_nowait()
+            except queue.Empty:
+                return items
+            if item is None:
+                self._queue.put(None)
+                return items
+            items.append(item)
+
+    def _run(self):
+        dpx = self.dpx
+        timed_out = False
+        while True:
+            item = self._queue.get()
+            if item is None:
+                return
+
+            # After a timeout, the frames queued meanwhile have been displayed
+            # already, and waiting for each of them would time out in turn.
+            # Wait for the newest one only, and release the triggers of the
+            # skipped frames with it.
+            skipped = []
+            if timed_out:
+                skipped = [item] + self._drain()
+                item = skipped.pop()
+            frame, pattern, _ = item
+            triggers = [trigger for _, _, trigger in skipped + [item] if trigger is not None]
+
+            with self.lock:
+                for trigger in triggers:
+                    if trigger.value is not None:
+                        dpx.DPxSetDoutValue(trigger.value, trigger.mask)
+                    if trigger.schedule:
+                        dpx.DPxStartDoutSched()
+                dpx.DPxSetMarker()
+                dpx.DPxUpdateRegCacheAfterPixelSync(2, list(pattern), self.timeout)
+                timed_out = bool(dpx.DPxIsPsyncTimeout())
+                onset = None if timed_out else dpx.DPxGetMarker()
+
+            with self._done:
+                for skipped_frame, _, _ in skipped:
+                    self._onsets[skipped_frame] = None
+                self._onsets[frame] = onset
+                for trigger in triggers:
+                    trigger.frame = frame
+                    trigger.time = onset
+                    self._triggers.append(trigger)
+                self._done.notify_all()
+
+    def onset(self, frame, wait=False, timeout=None):
+        """Onset time of a tagged frame.
+
+        Parameters
+        ----------
+        frame : int
+            frame number, as returned by tag() or Graphics.flip()
+        wait : bool, optional
+            block until the onset is known, by default False
+        timeout : float, optional
+            maximum time (s) to block, by default None (no limit)
+
+        Returns
+        -------
+        float or None
+            onset in seconds on the device clock; None if not (yet) known,
+            or if the pattern was not seen
+        """
+        with self._done:
+            if wait:
+                self._done.wait_for(lambda: frame in self._onsets, timeout)
+            return self._onsets.get(frame)
+
+    def onsets(self):
+        """All onsets collected so far.
+
+        Returns
+        -------
+        dict
+            frame number -> onset in seconds (or None)
+        """
+        with self._done:
+            return dict(self._onsets)
+
+    def triggers(self):
+        """All triggers released so far.
+
+        Returns
+        -------
+        list of Trigger
+            in frame order, with their device-clock times
+        """
+        with self._done:
+            return list(self._triggers)
+
+    def close(self):
+        """Process all queued frames, then stop the I/O thread."""
+        self._queue.put(None)
+        self._thread.join()
+        with OnsetService.changed:
+            OnsetService.running -= 1
+            OnsetService.changed.notify_all()
+
+
+class VsyncLog:
+    """Device-clock timestamps of every vertical sync, in a ring buffer.
+
+    A background thread repeatedly latches the device marker on the leading
+    edge of the next vertical sync (DPxSetMarker, then
+    DPxUpdateRegCacheAfterVideoSync), and stores the marker time. Intervals
+    longer than GAP_PERIODS video periods (DPxGetVidVPeriod) are flagged as
+    gaps: the video signal was interrupted, or the logger missed vsyncs
+    because a USB round trip took longer than a frame.
+
+    Vertical syncs keep coming when the stimulus misses a frame; to count
+    missed stimulus frames on the device clock, use `dropped_frames` on the
+    onsets of an OnsetService.
+
+    The device handles one request at a time, and holds a vsync wait until
+    the vsync: other libdpx calls can wait up to a frame while the log runs.
+    A pixel sync wait of an OnsetService must be issued before its frame is
+    displayed, so the log pauses while an OnsetService is running; intervals
+    across a pause are neither counted nor flagged as gaps.
+
+    Parameters
+    ----------
+    capacity : int, optional
+        number of timestamps kept, by default 36000 (10 min at 60 Hz)
+    dpx : module, optional
+        libdpx bindings, by default pypixxlib._libdpx
+    """
+
+    def __init__(self, capacity=36000, dpx=None):
+        if dpx is None:
+            from pypixxlib import _libdpx as dpx
+
+        self.dpx = dpx
+        self.lock = DPX_LOCK
+        with self.lock:
+            dpx.DPxUpdateRegCache()
+            self.period = dpx.DPxGetVidVPeriod() * 1e-9
+
+        self._times = np.zeros(capacity)
+        self._count = 0
+        self._gaps = []
+        self._n_intervals = 0
+        self._sum = 0.0
+        self._sum_squares = 0.0
+        self._min = np.inf
+        self._max = 0.0
+        self._data = threading.Lock()
+        self._pauses = 0
+
+        self._running = True
+        self._thread = threading.Thread(target=self._run, name="hrl-vsync", daemon=True)
+        self._thread.start()
+
+    def _run(self):
+        dpx = self.dpx
+        last = None
+        while True:
+            with OnsetService.changed:
+                if OnsetService.running:
+                    last = None
+                    self._pauses += 1
+                OnsetService.changed.wait_for(lambda: not (self._running and OnsetService.running))
+                if not self._running:
+                    return
+
+            with self.lock:
+                dpx.DPxSetMarker()
+                dpx.DPxUpdateRegCacheAfterVideoSync()
+                time = dpx.DPxGetMarker()
+
+            with self._data:
+                self._times[self._count % len(self._times)] = time
+                self._count += 1
+                if last is not None:
+                    self._add_interval(last, time - last)
+            last = time
+
+    def _add_interval(self, start, interval):
+        self._n_intervals += 1
+        self._sum += interval
+        self._sum_squares += interval**2
+        self._min = min(self._min, interval)
+        self._max = max(self._max, interval)
+        if interval > GAP_PERIODS * self.period:
+            missed = int(round(interval / self.period)) - 1
+            self._gaps.append((start, max(missed, 1)))
+
+    def times(self):
+        """Logged vsync times, oldest first (at most capacity).
+
+        Returns
+        -------
+        ndarray
+            vsync times in seconds on the device clock
+        """
+        with self._data:
+            capacity = len(self._times)
+            if self._count <= capacity:
+                return self._times[: self._count].copy()
+            start = self._count % capacity
+            return np.concatenate([self._times[start:], self._times[:start]])
+
+    def gaps(self):
+        """Gaps in the log, over the whole session.
+
+        Returns
+        -------
+        list of (float, int)
+            time of the last vsync before the gap, number of missing vsyncs
+        """
+        with self._data:
+            return list(self._gaps)
+
+    def stats(self):
+        """Refresh statistics over the whole session.
+
+        Returns
+        -------
+        dict
+            number of vsyncs, nominal period (s), mean interval (s), jitter
+            (standard deviation of intervals, s), min and max interval (s),
+            measured refresh rate (Hz), number of gaps, missing vsyncs, and
+            number of pauses for an OnsetService
+        """
+        with self._data:
+            n = self._n_intervals
+            mean = self._sum / n if n else np.nan
+            variance = self._sum_squares / n - mean**2 if n else np.nan
+            return {
+                "vsyncs": self._count,
+                "period": self.period,
+                "mean_interval": mean,
+                "jitter": np.sqrt(max(variance, 0.0)) if n else np.nan,
+                "min_interval": self._min if n else np.nan,
+                "max_interval": self._max if n else np.nan,
+                "refresh_rate": 1.0 / mean if n else np.nan,
+                "gaps": len(self._gaps),
+                "missed": sum(missed for _, missed in self._gaps),
+                "pauses": self._pauses,
+            }
+
+    def close(self):
+        """Stop logging, after the current vsync."""
+        with OnsetService.changed:
+            self._running = False
+            OnsetService.changed.notify_all()
+        self._thread.join()
+
+
+def dropped_frames(onsets, period):
+    """Count frames missed between consecutive flips, from their onsets.
+
+    Parameters
+    ----------
+    onsets : dict or array-like
+        onset times (s) of consecutive flips, or frame number -> onset,
+        e.g., OnsetService.onsets(); an unknown onset (None) means the frame
+        was not seen on time, and counts as one dropped frame
+    period : float
+        video frame period (s), e.g., VsyncLog.period
+
+    Returns
+    -------
+    int
+        number of video frames between flips in excess of one per flip,
+        plus the number of flips with unknown onsets
+    """
+    if not isinstance(onsets, dict):
+        onsets = dict(enumerate(onsets))
+    known = sorted(frame for frame, onset in onsets.items() if onset is not None)
+    unknown = len(onsets) - len(known)
+    if len(known) < 2:
+        return unknown
+
+    # Video frames elapsed between known onsets, versus flips in between
+    frames = np.round(np.diff([onsets[frame] for frame in known]) / period)
+    flips = np.diff(known)
+    return unknown + int(np.sum(np.maximum(frames - flips, 0)))
+
+
+class RasterModel:
+    """Scan-out times of raster lines on the device clock.
+
+    A frame starts with the leading edge of its vertical sync, which is the
+    time DPxUpdateRegCacheAfterVideoSync latches (see VsyncLog). Sync and
+    back porch lines follow, then the active lines from the top of the
+    screen, then the front porch. On a CRT, or on a display scanning like
+    one, the bottom of the screen is therefore shown almost a frame period
+    later than the top.
+
+    Fit the model to vsync times with fit(), e.g., from a VsyncLog, and
+    refit it as more vsyncs are logged to follow drift of the video clock.
+
+    Parameters
+    ----------
+    vtotal : int
+        lines per frame, including vertical blanking
+    vactive : int
+        visible lines per frame
+    period : float
+        frame period (s)
+    front_porch : int, optional
+        lines between the last visible line and the vertical sync, by
+        default 3. Can be measured with DPxAnalyzeVideoScope.
+    vsync : float, optional
+        time (s) of a vertical sync leading edge on the device clock, the
+        start of frame 0, by default 0.0
+    """
+
+    def __init__(self, vtotal, vactive, period, front_porch=3, vsync=0.0):
+        self.vtotal = vtotal
+        self.vactive = vactive
+        self.front_porch = front_porch
+        self.period = period
+        self.vsync = vsync
+
+    @classmethod
+    def from_device(cls, front_porch=3, dpx=None):
+        """Model with the video timing the device measures on its input.
+
+        Parameters
+        ----------
+        front_porch : int, optional
+            vertical front porch in lines, by default 3
+        dpx : module, optional
+            libdpx bindings, by default pypixxlib._libdpx
+
+        Returns
+        -------
+        RasterModel
+            not yet fitted to any vsync time
+        """
+        if dpx is None:
+            from pypixxlib import _libdpx as dpx
+
+        with DPX_LOCK:
+            dpx.DPxUpdateRegCache()
+            vtotal = dpx.DPxGetVidVTotal()
+            vactive = dpx.DPxGetVidVActive()
+            period = dpx.DPxGetVidVPeriod() * 1e-9
+        return cls(vtotal, vactive, period, front_porch)
+
+    @property
+    def line_period(self):
+        """Time (s) to scan out one line, including horizontal blanking"""
+        return self.period / self.vtotal
+
+    def fit(self, times):
+        """Fit frame period and phase to vertical sync times.
+
+        Missing vsyncs are allowed: each time is assigned to the nearest
+        whole frame of the current period before a least-squares line fit.
+
+        Parameters
+        ----------
+        times : array-like
+            vsync times (s) on the device clock, in increasing order,
+            e.g., VsyncLog.times()
+
+        Returns
+        -------
+        RasterModel
+            self, fitted; frame 0 starts at the first of the times
+        """
+        times = np.asarray(times, dtype=float)
+        if len(times) < 2:
+            raise ValueError("Need at least two vsync times to fit the raster model")
+
+        frames = np.round((times - times[0]) / self.period)
+        self.period, self.vsync = np.polyfit(frames, times, 1)
+        return self
+
+    def frame(self, time):
+        """Frame being scanned out at a time.
+
+        Parameters
+        ----------
+        time : float
+            time (s) on the device clock
+
+        Returns
+        -------
+        int
+            frame number, counting from the vsync of frame 0
+        """
+        return int(np.floor((time - self.vsync) / self.period))
+
+    def line_time(self, line, frame):
+        """Time at which a raster line of a frame starts to be scanned out.
+
+        Parameters
+        ----------
+        line : int or ndarray
+            visible line, 0 at the top of the screen
+        frame : int
+            frame number, see frame()
+
+        Returns
+        -------
+        float or ndarray
+            time (s) on the device clock
+        """
+        blank_lines = self.vtotal - self.vactive - self.front_porch
+        return self.vsync + frame * self.period + (blank_lines + np.asarray(line)) * self.line_period
+
+    def next_line_time(self, line, time):
+        """Next time after a given time at which a raster line is scanned out.
+
+        Parameters
+        ----------
+        line : int
+            visible line, 0 at the top of the screen
+        time : float
+            time (s) on the device clock
+
+        Returns
+        -------
+        float
+            time (s) on the device clock
+        """
+        frame = self.frame(time)
+        if self.line_time(line, frame) < time:
+            frame += 1
+        return self.line_time(line, frame)
+
+    def row_onset(self, onset, row, onset_row=0):
+        """Onset of a framebuffer row, from the onset of another row.
+
+        Parameters
+        ----------
+        onset : float
+            onset (s) of onset_row, e.g., from OnsetService, whose pixel sync
+            pattern is on its raster_line
+        row : float
+            row (from the top) whose onset is wanted
+        onset_row : int, optional
+            row of the known onset, by default 0
+
+        Returns
+        -------
+        float
+            onset (s) of row on the device clock
+        """
+        return onset + (row - onset_row) * self.line_period
+
+    def centre_onset(self, onset, pos, sz, onset_row=0):
+        """Onset of the centre row of a stimulus drawn at pos with size sz.
+
+        Parameters
+        ----------
+        onset : float
+            onset (s) of onset_row, e.g., from OnsetService
+        pos : (float, float)
+            position (pixels) of the upper left corner, as in Texture.draw
+        sz : (float, float)
+            (width, height) of the stimulus in pixels
+        onset_row : int, optional
+            row of the known onset, by default 0
+
+        Returns
+        -------
+        float
+            onset (s) of the centre row on the device clock
+        """
+        return self.row_onset(onset, pos[1] + sz[1] / 2, onset_row)
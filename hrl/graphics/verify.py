@@ -0,0 +1,241 @@
+"""Verification of displayed pixels through the VPixx video line buffer.
+
+The device keeps a copy of the first raster line of the video signal it
+receives, as 16 bits per R/G/B/U component (DPxGetVidLine). Comparing it with
+the framebuffer catches everything between the rendered, encoded pixels and
+the wire: GPU gamma ramps, driver dithering, scaling or colour management
+that would silently corrupt M16 or C48 encodings.
+
+A LineVerifier samples every Nth flip. Before the swap, it reads the
+selected framebuffer row (the expected encoded pixels) and, if that row is
+not the top one, copies it onto the top raster line, the only line the
+device captures. After the swap, a background I/O thread waits until the
+frame is displayed, reads the line buffer, and compares all pixels at once;
+the render thread does not wait.
+
+The line is read two vsyncs after the swap, and a copied row replaces the
+top raster line of the sampled frame. Sample flips of static displays,
+e.g., the first flip of every Nth trial.
+
+The vsync waits would hold up the pixel sync waits of onset timestamps,
+which must be issued before their frames are displayed: like a VsyncLog,
+the verifier pauses while an OnsetService is running, and flips sampled
+meanwhile are skipped.
+"""
+
+import queue
+import threading
+
+import numpy as np
+import OpenGL.GL as opengl
+
+from hrl.graphics.timing import DPX_LOCK, OnsetService
+
+# Pixels held by the line buffer
+LINE_PIXELS = 2048
+
+
+class LineCheck:
+    """Result of comparing one displayed raster line with the framebuffer.
+
+    Attributes
+    ----------
+    flip : int
+        number of the verified flip, counting from enabling verification
+    row : int
+        framebuffer row that was verified
+    columns : ndarray
+        columns of mismatched pixels
+    expected : ndarray
+        uint8 (N, 3) RGB of mismatched pixels in the framebuffer
+    actual : ndarray
+        uint8 (N, 3) RGB of mismatched pixels as received by the device
+    """
+
+    def __init__(self, flip, row, columns, expected, actual):
+        self.flip = flip
+        self.row = row
+        self.columns = columns
+        self.expected = expected
+        self.actual = actual
+
+    def __bool__(self):
+        return len(self.columns) == 0
+
+    def __repr__(self):
+        return f"LineCheck(flip={self.flip}, row={self.row}, mismatches={len(self.columns)})"
+
+    @property
+    def expected16(self):
+        """Mismatched expected pixels as 16-bit M16 values (R[7:0]G[7:0])"""
+        return self.expected[:, 0].astype(np.uint16) << 8 | self.expected[:, 1]
+
+    @property
+    def actual16(self):
+        """Mismatched received pixels as 16-bit M16 values (R[7:0]G[7:0])"""
+        return self.actual[:, 0].astype(np.uint16) << 8 | self.actual[:, 1]
+
+
+def compare_line(expected, line):
+    """Compare framebuffer pixels with line buffer pixels.
+
+    Parameters
+    ----------
+    expected : ndarray
+        uint8 (W, 3 or 4) framebuffer pixels
+    line : ndarray
+        uint16 (>=W, 4) R/G/B/U line buffer pixels, the 8-bit component
+        in the high byte
+
+    Returns
+    -------
+    (ndarray, ndarray, ndarray)
+        mismatched columns, their expected and received RGB
+    """
+    wdth = len(expected)
+    expected = expected[:, :3]
+    actual = (line[:wdth, :3] >> 8).astype(np.uint8)
+    columns = np.flatnonzero(np.any(expected != actual, axis=1))
+    return columns, expected[columns], actual[columns]
+
+
+class LineVerifier:
+    """Checks sampled flips against the device line buffer.
+
+    Create with Graphics.enable_line_verification(); Graphics.flip() then
+    verifies every Nth flip, and appends the result to `checks`.
+
+    Parameters
+    ----------
+    graphics : Graphics
+        graphics device, for its size
+    row : int, optional
+        framebuffer row (from the top) to verify, by default 0
+    every : int, optional
+        verify every Nth flip, by default 1
+    dpx : module, optional
+        libdpx bindings, by default pypixxlib._libdpx
+
+    Attributes
+    ----------
+    checks : list of LineCheck
+        results of all verified flips so far, in flip order; a LineCheck is
+        False if any pixel mismatched. Call wait() for the pending ones.
+    skipped : list of int
+        sampled flips that were not verified, because an OnsetService was
+        running
+    """
+
+    def __init__(self, graphics, row=0, every=1, dpx=None):
+        if dpx is None:
+            from pypixxlib import _libdpx as dpx
+
+        self.graphics = graphics
+        self.row = row
+        self.every = every
+        self.dpx = dpx
+        self.checks = []
+        self.skipped = []
+        self._flips = 0
+        self._expected = None
+        self._queue = queue.Queue()
+        self._thread = threading.Thread(target=self._run, name="hrl-verify", daemon=True)
+        self._thread.start()
+
+    def before_swap(self):
+        """Read the expected row of the back buffer, if this flip is sampled.
+
+        Call after all drawing, right before swapping buffers.
+        """
+        self._expected = None
+        if self._flips % self.every:
+            return
+
+        wdth = min(self.graphics.width, LINE_PIXELS)
+        hght = self.graphics.height
+        pixels = opengl.glReadPixels(
+            0, hght - 1 - self.row, wdth, 1, opengl.GL_RGBA, opengl.GL_UNSIGNED_BYTE
+        )
+        self._expected = np.frombuffer(bytes(pixels), dtype=np.uint8).reshape(wdth, 4)
+
+        # The device only captures the top raster line
+        if self.row != 0:
+            opengl.glDisable(opengl.GL_TEXTURE_2D)
+            opengl.glWindowPos2i(0, hght - 1)
+            opengl.glDrawPixels(
+                wdth, 1, opengl.GL_RGBA, opengl.GL_UNSIGNED_BYTE, self._expected.tobytes()
+            )
+            opengl.glEnable(opengl.GL_TEXTURE_2D)
+
+    def after_swap(self):
+        """Queue the comparison of the displayed line, if this flip is sampled.
+
+        Returns
+        -------
+        int or None
+            number of the sampled flip, or None
+        """
+        flip = self._flips
+        self._flips += 1
+        if self._expected is None:
+            return None
+
+        self._queue.put((flip, self._expected, self._pattern_columns()))
+        self._expected = None
+        return flip
+
+    def wait(self):
+        """Block until all queued flips are checked."""
+        self._queue.join()
+
+    def close(self):
+        """Check all queued flips, then stop the I/O thread."""
+        self._queue.put(None)
+        self._thread.join()
+
+    def _pattern_columns(self):
+        # Columns of the captured top line which hold a pixel sync pattern
+        # of onset timestamps. It is drawn on its raster line after the row
+        # was read and copied, so it only shows up when on the top line.
+        onset_service = self.graphics.onset_service
+        if onset_service is not None and onset_service.raster_line == 0:
+            return 2
+        return 0
+
+    def _run(self):
+        dpx = self.dpx
+        while True:
+            item = self._queue.get()
+            if item is None:
+                self._queue.task_done()
+                return
+            flip, expected, skip = item
+
+            with OnsetService.changed:
+                if OnsetService.running:
+                    self.skipped.append(flip)
+                    self._queue.task_done()
+                    continue
+
+            # The swap takes effect on the next vsync; the frame after it
+            # shows the flipped image on its top line. The lock is released
+            # in between, not to hold up other services for two frames.
+            with DPX_LOCK:
+                dpx.DPxUpdateRegCacheAfterVideoSync()
+            with DPX_LOCK:
+                dpx.DPxUpdateRegCacheAfterVideoSync()
+                line = dpx.DPxGetVidLine()
+            line = np.asarray(line[: LINE_PIXELS * 4], dtype=np.uint16).reshape(-1, 4)
+
+            columns, expected, actual = compare_line(expected[skip:], line[skip:])
+            self.checks.append(LineCheck(flip, self.row, columns + skip, expected, actual))
+            self._queue.task_done()
+
+    def failures(self):
+        """Checks with mismatched pixels.
+
+        Returns
+        -------
+        list of LineCheck
+        """
+        return [check for check in self.checks if not check]
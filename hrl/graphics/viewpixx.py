@@ -1,6 +1,9 @@
 import numpy as np
+import OpenGL.GL as opengl
 
+from .encoding import encode_dithered, encode_m16, encode_pixel_pairs
 from .graphics import Graphics_grey, Graphics_RGB
+from .texture import Texture
 
 
 class VIEWPixx_grey(Graphics_grey):
@@ -27,6 +30,8 @@ class VIEWPixx_grey(Graphics_grey):
     """
 
     bitdepth = 8  # bit depth per physical channel
+    output_levels = 2**16  # 16-bit greyscale
+    video_mode = "M16"
     device = None
 
     def __init__(self, *args, **kwargs):
@@ -36,15 +41,8 @@ class VIEWPixx_grey(Graphics_grey):
         self.device = device()
 
         # Set video mode to M16: concatente R & G channels for 16-bit greyscale
-        mode = self.device.getVideoMode()
-        print(f"Current video mode: {mode}")
-
-        if mode != "M16":
-            print("Setting video mode to M16...")
-            self.device.setVideoMode("M16")
-            self.device.updateRegisterCache()
-            mode = self.device.getVideoMode()
-            print(f"Video mode now: {mode}")
+        # (or a dithered variant of a subclass)
+        self._set_video_mode()
 
         # Call parent initializer
         super().__init__(*args, **kwargs)
@@ -85,6 +83,101 @@ class VIEWPixx_grey(Graphics_grey):
 
         return channels
 
+    def bytestring_from_img(self, img):
+        """Gamma correct and encode greyscale image in one fused M16 pass.
+
+        Gives the same bytes as `channels_from_img` followed by
+        `bytestring_from_channels`, without the uint32 temporaries.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+
+        Returns
+        -------
+        bytes
+            packed 32-bit RGBA bytestring for OpenGL texture data
+        """
+        return encode_m16(np.atleast_2d(img), gamma_correct=self.gamma_correct).tobytes()
+
+    def encode_into(self, img, out):
+        """Gamma correct and M16 encode greyscale image into a uint8 buffer.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+        out : ndarray
+            uint8 array of (H * W * 4) bytes to write into
+        """
+        img = np.atleast_2d(img)
+        encode_m16(img, gamma_correct=self.gamma_correct, out=out.reshape(*img.shape, 4))
+
+
+class VIEWPixx_M16D(VIEWPixx_grey):
+    """VPixx ViewPixx 3D in M16D mode: 16-bit greyscale, robust to dithering.
+
+    Like `VIEWPixx_grey`, but in the M16D video mode, which concatenates
+    R[7:3], G[7:3] and B[7:2] into the 16-bit value. The low bits of each
+    channel are ignored by the device, so the display is unaffected by
+    GPUs or drivers that dither the framebuffer.
+
+    See Also
+    --------
+    VIEWPixx_grey : M16 mode, all 8 bits of R and G carry data
+    """
+
+    video_mode = "M16D"
+
+    def channels_from_img(self, img):
+        """Convert greyscale image to the M16D R-G-B bit fields.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+
+        Returns
+        -------
+        tuple of (ndarray, ndarray, ndarray, int)
+            4-channel representation as (R, G, B, Alpha) where:
+            - R = bits 15-11, in R[7:3]
+            - G = bits 10-6, in G[7:3]
+            - B = bits 5-0, in B[7:2]
+            - Alpha = 255
+        """
+        pixels = encode_dithered(np.atleast_2d(img), "M16D").astype(np.uint32)
+        return (pixels[..., 0], pixels[..., 1], pixels[..., 2], 2**self.bitdepth - 1)
+
+    def bytestring_from_img(self, img):
+        """Gamma correct and encode greyscale image in one fused M16D pass.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+
+        Returns
+        -------
+        bytes
+            packed 32-bit RGBA bytestring for OpenGL texture data
+        """
+        return encode_dithered(np.atleast_2d(img), "M16D", gamma_correct=self.gamma_correct).tobytes()
+
+    def encode_into(self, img, out):
+        """Gamma correct and M16D encode greyscale image into a uint8 buffer.
+
+        Parameters
+        ----------
+        img : ndarray
+            input greyscale image with values in [0.0, 1.0] and shape (H, W)
+        out : ndarray
+            uint8 array of (H * W * 4) bytes to write into
+        """
+        img = np.atleast_2d(img)
+        encode_dithered(img, "M16D", gamma_correct=self.gamma_correct, out=out.reshape(*img.shape, 4))
+
 
 class VIEWPixx_RGB(Graphics_RGB):
     """VPixx ViewPixx 3D in C24 mode for RGB color display.
@@ -108,6 +201,7 @@ class VIEWPixx_RGB(Graphics_RGB):
     """
 
     bitdepth = 8  # bit depth per physical channel
+    video_mode = "C24"
 
     def __init__(self, *args, **kwargs):
         # Open hardware connection
@@ -116,15 +210,7 @@ class VIEWPixx_RGB(Graphics_RGB):
         self.device = device()
 
         # Set video mode to C24: regular 8-bit per channel RGB
-        mode = self.device.getVideoMode()
-        print(f"Current video mode: {mode}")
-
-        if mode != "C24":
-            print("Setting video mode to C24...")
-            self.device.setVideoMode("C24")
-            self.device.updateRegisterCache()
-            mode = self.device.getVideoMode()
-            print(f"Video mode now: {mode}")
+        self._set_video_mode()
 
         # Call parent initializer
         super().__init__(*args, **kwargs)
@@ -160,3 +246,164 @@ class VIEWPixx_RGB(Graphics_RGB):
         )
 
         return arr
+
+
+class VIEWPixx_C48(Graphics_RGB):
+    """VPixx ViewPixx 3D in C48 mode for 16-bit per channel RGB display.
+
+    Uses C48 video mode which combines each even/odd pair of horizontally
+    adjacent framebuffer pixels into one displayed pixel: the even pixel
+    carries the high bytes, the odd pixel the low bytes of 16-bit R, G and B
+    components. The displayed image thus has half the horizontal resolution
+    of the framebuffer.
+
+    Images passed to newTexture() are in displayed pixels, i.e., an (H, W, 3)
+    image becomes a texture 2W framebuffer pixels wide. Positions and sizes
+    passed to Texture.draw() remain in framebuffer pixels. Textures must be
+    drawn at even x-positions and at their natural size: any scaling or
+    rotation interpolates between the packed bytes.
+
+    Since a single glClearColor cannot encode differing even/odd pixels, the
+    background is drawn as a full-screen texture after each flip().
+
+    The device connection is established automatically during initialization.
+
+    Attributes
+    ----------
+    bitdepth : int
+        bit depth per physical channel (8, but combined to 16-bit)
+    pair_bits : int
+        bit depth per colour component of a displayed pixel (16)
+    device : VIEWPixx3D
+        pypixxlib device instance for hardware communication
+
+    See Also
+    --------
+    VIEWPixx_C36D : 12-bit per channel RGB, robust against dithering
+    VIEWPixx_RGB : 8-bit per channel RGB mode for ViewPixx hardware
+    """
+
+    bitdepth = 8  # bit depth per physical channel
+    output_levels = 2**16  # 16 bits per colour component
+    pair_bits = 16  # bit depth per colour component of a displayed pixel
+    video_mode = "C48"
+    device = None
+
+    def __init__(self, *args, **kwargs):
+        # Open hardware connection
+        from pypixxlib.viewpixx import VIEWPixx3D as device
+
+        self.device = device()
+        self._background_texture = None
+
+        # Set video mode: even/odd pixel pairs form one high bit-depth pixel
+        self._set_video_mode()
+
+        # Call parent initializer
+        super().__init__(*args, **kwargs)
+
+    def channels_from_img(self, img):
+        """Convert RGB image to packed even/odd pixel pair RGBA representation.
+
+        Parameters
+        ----------
+        img : ndarray
+            input RGB image with values in [0.0, 1.0] and shape (H, W, 3)
+
+        Returns
+        -------
+        tuple of (ndarray, ndarray, ndarray, int)
+            4-channel representation as (R, G, B, Alpha) of the framebuffer
+            pixels, each of shape (H, 2W), with Alpha=255
+        """
+        packed = encode_pixel_pairs(img, bits=self.pair_bits).astype(np.uint32)
+
+        return (
+            packed[:, :, 0],  # R channel
+            packed[:, :, 1],  # G channel
+            packed[:, :, 2],  # B channel
+            2**self.bitdepth - 1,  # Alpha channel (max intensity)
+        )
+
+    def _create_texture(self, arr0, shape):
+        # Pack into even/odd pixel pairs: texture is 2W framebuffer pixels wide
+        height, width = arr0.shape[0], 2 * arr0.shape[1]
+        arr = self.gamma_correct(arr0)
+
+        if self.upload_ring is not None:
+            slot = self.upload_ring.stage(height * width * 4)
+            encode_pixel_pairs(arr, bits=self.pair_bits, out=slot.array.reshape(height, width, 4))
+            return Texture(slot, width, height, shape)
+
+        packed = encode_pixel_pairs(arr, bits=self.pair_bits)
+
+        return Texture(packed.tobytes(), width, height, shape)
+
+    def encode_image(self, img):
+        # Pack into even/odd pixel pairs: 2W framebuffer pixels wide
+        return encode_pixel_pairs(self.gamma_correct(np.asarray(img)), bits=self.pair_bits)
+
+    def changeBackground(self, background):
+        """Change background color.
+
+        Parameters
+        ----------
+        background : float, tuple, or ndarray
+            background color specification:
+            - float: grey value in [0.0, 1.0] applied equally to R, G, B
+            - tuple/array: (r, g, b) values each in [0.0, 1.0]
+        """
+        # Convert scalar to RGB array
+        if isinstance(background, (int, float)):
+            background = np.array([background, background, background])
+        background = np.asarray(background, dtype=float).reshape(1, 1, 3)
+
+        # One row of the displayed screen, stretched vertically when drawn
+        if self._background_texture is not None:
+            self._background_texture.delete()
+        row = np.broadcast_to(background, (1, self.width // 2, 3))
+        self._background_texture = self._create_texture(row, "square")
+        self.background = background
+
+        opengl.glClear(opengl.GL_COLOR_BUFFER_BIT)
+        self._draw_background()
+
+    def _draw_background(self):
+        self._background_texture.draw((0, 0), (self._background_texture.wdth, self.height))
+
+    def flip(self, clr=True):
+        """Swap display buffers to show rendered content.
+
+        Parameters
+        ----------
+        clr : bool, optional
+            clear the back buffer to the background after flipping,
+            by default True.
+
+        Returns
+        -------
+        int or None
+            frame number, if onset timestamps are enabled
+        """
+        frame = super().flip(clr)
+        if clr:
+            self._draw_background()
+        return frame
+
+
+class VIEWPixx_C36D(VIEWPixx_C48):
+    """VPixx ViewPixx 3D in C36D mode for 12-bit per channel RGB display.
+
+    Like C48, but each framebuffer byte only carries 6 bits in RED/GREEN/
+    BLUE[7:2]: the even pixel the high 6 bits, the odd pixel the low 6 bits
+    of 12-bit R, G and B components. The device ignores bits [1:0], so the
+    encoding survives GPU dithering.
+
+    See Also
+    --------
+    VIEWPixx_C48 : 16-bit per channel RGB
+    """
+
+    pair_bits = 12  # bit depth per colour component of a displayed pixel
+    output_levels = 2**12  # 12 bits per colour component
+    video_mode = "C36D"
@@ -58,6 +58,12 @@ class HRL:
 
         graphics : The graphics device to use. Available: 'gpu','datapixx'
             (to be used with DataPixx 1) or 'viewpixx' (for ViewPixx 3D).
+            'datapixx_l48' gamma corrects in the DataPixx CLUTs, with lut
+            given per VGA output as a (VGA 1, VGA 2) pair.
+            For GPUs or drivers that dither: 'datapixx_m16d',
+            'viewpixx_m16d' (16-bit) or 'datapixx_l48d' (CLUTs).
+            High bit-depth RGB on ViewPixx 3D: 'viewpixx_c48' (16-bit) or
+            'viewpixx_c36d' (12-bit), at half the horizontal resolution.
             Default: 'gpu'
         inputs : The input device to use. Available: 'keyboard', 'responsepixx'.
             Default: 'keyboard'
@@ -79,7 +85,8 @@ class HRL:
             Matrix. The string names should be without spaces, e.g.
             'InputLuminance'. If rfl != None, rhds must be provided.
             Default: None
-        lut : The lookup table. Default: None
+        lut : The lookup table. Default: None. For 'datapixx_l48', also a
+            pair of lookup tables, one per VGA output.
         mouse: enables or disables the mouse cursor. Default: False
 
         Returns
@@ -143,10 +150,11 @@ class HRL:
                 mouse=mouse,
             )
 
-        elif graphics.lower() == "datapixx":
-            from .graphics.datapixx import DATAPixx
+        elif graphics.lower() in ("datapixx", "datapixx_m16d"):
+            from .graphics.datapixx import DATAPixx, DATAPixx_M16D
 
-            self.graphics = DATAPixx(
+            device = DATAPixx if graphics.lower() == "datapixx" else DATAPixx_M16D
+            self.graphics = device(
                 width=wdth,
                 height=hght,
                 background=bg,
@@ -155,10 +163,30 @@ class HRL:
                 lut=lut,
                 mouse=mouse,
             )
-        elif graphics.lower() in ("viewpixx", "viewpixx_grey", "viewpixx_gray", "viewpixx_gray8"):
-            from .graphics.viewpixx import VIEWPixx_grey
+        elif graphics.lower() in ("datapixx_l48", "datapixx_l48d"):
+            from .graphics.datapixx import DATAPixx_L48, DATAPixx_L48D
 
-            self.graphics = VIEWPixx_grey(
+            device = DATAPixx_L48 if graphics.lower() == "datapixx_l48" else DATAPixx_L48D
+            self.graphics = device(
+                width=wdth,
+                height=hght,
+                background=bg,
+                fullscreen=fs,
+                double_buffer=db,
+                lut=lut,
+                mouse=mouse,
+            )
+        elif graphics.lower() in (
+            "viewpixx",
+            "viewpixx_grey",
+            "viewpixx_gray",
+            "viewpixx_gray8",
+            "viewpixx_m16d",
+        ):
+            from .graphics.viewpixx import VIEWPixx_grey, VIEWPixx_M16D
+
+            device = VIEWPixx_M16D if graphics.lower() == "viewpixx_m16d" else VIEWPixx_grey
+            self.graphics = device(
                 width=wdth,
                 height=hght,
                 background=bg,
@@ -181,6 +209,20 @@ class HRL:
                 mouse=mouse,
             )
 
+        elif graphics.lower() in ("viewpixx_c48", "viewpixx_c36d"):
+            from .graphics.viewpixx import VIEWPixx_C36D, VIEWPixx_C48
+
+            device = VIEWPixx_C48 if graphics.lower() == "viewpixx_c48" else VIEWPixx_C36D
+            self.graphics = device(
+                width=wdth,
+                height=hght,
+                background=[bg, bg, bg],
+                fullscreen=fs,
+                double_buffer=db,
+                lut=lut,
+                mouse=mouse,
+            )
+
         else:
             self.graphics = None
 
@@ -254,6 +296,16 @@ class HRL:
         Closes all the devices and systems maintained by the HRL object.
         This should be called at the end of the program.
         """
+        if self.graphics.line_verifier != None:
+            self.graphics.disable_line_verification()
+        if self.graphics.onset_service != None:
+            self.graphics.disable_onset_timestamps()
+        if self.graphics.vsync_log != None:
+            self.graphics.disable_vsync_log()
+        if self.graphics.overlay != None:
+            self.graphics.disable_horizontal_overlay()
+        if self.graphics.frame_packer != None:
+            self.graphics.disable_frame_packing()
         if self.graphics.device != None:
             self.graphics.device.close()
         if self._rfl != None:
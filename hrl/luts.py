@@ -37,12 +37,159 @@ create_lut(n=256, gamma=1.0, k=1.0, dark=0.0)
     Create a parametric LUT with gamma correction and luminance scaling.
 create_clut(n=256, gamma=[1.0, 1.0, 1.0], color_matrix=None, dark_chromaticity=None)
     Create a parametric CLUT with gamma correction and color conversion.
+compile_lut(LUT, n_levels=2**16)
+    Precompute a (C)LUT for constant-time gamma correction.
 
 """
 
 import numpy as np
 
 
+class CompiledLUT:
+    """(C)LUT precompiled for constant-time gamma correction.
+
+    `np.interp` binary searches the LUT rows for every pixel. A CompiledLUT
+    instead keeps a dense table with, for each of `n_levels` equally wide
+    bins of input intensity, the index of the LUT row at the start of that
+    bin. Looking up a pixel is then a direct index into this table, followed
+    by at most a few steps to the exact row, when several rows fall into one
+    bin. Interpolation uses the same arithmetic as `np.interp`, so results
+    are bit-identical.
+
+    Use `compile_lut` to create one; `gamma_correct_grey` and
+    `gamma_correct_RGB` accept it in place of the LUT array.
+
+    Attributes
+    ----------
+    xp : Array[float]
+        input intensities of the LUT rows
+    fp : Array[float]
+        corrected output values, shape (N, n_channels)
+    n_levels : int
+        number of bins in the dense index table
+    """
+
+    def __init__(self, xp, fp, n_levels=2**16):
+        xp = np.asarray(xp, dtype=float)
+        fp = np.asarray(fp, dtype=float).reshape(len(xp), -1)
+        if len(xp) < 2:
+            raise ValueError(f"LUT must have at least 2 rows, got {len(xp)}")
+        if np.any(np.diff(xp) < 0):
+            raise ValueError("LUT input intensities must be increasing")
+
+        self.xp = xp
+        self.fp = fp
+        self.n_levels = n_levels
+
+        # Same slope arithmetic as np.interp
+        with np.errstate(divide="ignore", invalid="ignore"):
+            self._slopes = (fp[1:] - fp[:-1]) / (xp[1:] - xp[:-1])[:, None]
+
+        # Dense table: LUT row at the start of each input bin
+        self._scale = (n_levels - 1) / (xp[-1] - xp[0]) if xp[-1] > xp[0] else 0.0
+        starts = xp[0] + np.arange(n_levels) / self._scale if self._scale else np.full(1, xp[0])
+        self._index = np.clip(np.searchsorted(xp, starts, side="right") - 1, 0, len(xp) - 2)
+
+    def rows(self, x):
+        """Index j of the LUT row with xp[j] <= x < xp[j+1], for each x.
+
+        Parameters
+        ----------
+        x : Array[float]
+            input intensities, within [xp[0], xp[-1])
+
+        Returns
+        -------
+        Array[int]
+            row indices, same shape as x
+        """
+        xp = self.xp
+        last = len(xp) - 2
+
+        k = np.clip((x - xp[0]) * self._scale, 0, len(self._index) - 1).astype(np.intp)
+        j = self._index[k]
+
+        # Step to the exact row, if bins and rows do not line up
+        while True:
+            down = x < xp[j]
+            up = (x >= xp[np.minimum(j + 1, last + 1)]) & (j < last)
+            if not (down.any() or up.any()):
+                return j
+            j = j - down + up
+
+    def __call__(self, img, channel=0):
+        """Apply gamma correction to intensities, as np.interp would.
+
+        Parameters
+        ----------
+        img : Array[float]
+            input intensities, scalar or array of any shape
+        channel : int, optional
+            which output column to use, by default 0
+
+        Returns
+        -------
+        Array[float]
+            gamma-corrected intensities, same shape as input
+        """
+        x = np.asarray(img, dtype=float)
+        scalar = x.ndim == 0
+        x = np.atleast_1d(x)
+        xp, fp, slopes = self.xp, self.fp[:, channel], self._slopes[:, channel]
+
+        inside = (x >= xp[0]) & (x < xp[-1])
+        everywhere = inside.all()
+        xi = x if everywhere else x[inside]
+        j = self.rows(xi)
+        dx = xi - xp[j]
+        with np.errstate(invalid="ignore"):
+            inner = slopes[j] * dx + fp[j]
+
+            # If we get nan in one direction, try the other (as np.interp)
+            nan = np.isnan(inner)
+            if nan.any():
+                jn = j[nan]
+                retry = slopes[jn] * (xi[nan] - xp[jn + 1]) + fp[jn + 1]
+                flat = np.isnan(retry) & (fp[jn] == fp[jn + 1])
+                inner[nan] = np.where(flat, fp[jn], retry)
+        exact = dx == 0
+        inner[exact] = fp[j[exact]]
+
+        if everywhere:
+            result = inner
+        else:
+            result = np.where(x < xp[0], fp[0], fp[-1])
+            result[np.isnan(x)] = np.nan
+            result[inside] = inner
+
+        return result[0] if scalar else result
+
+
+def compile_lut(LUT, n_levels=2**16):
+    """Precompute a (C)LUT for constant-time gamma correction.
+
+    Parameters
+    ----------
+    LUT : Array[float]
+        LookUp Table with at least shape (N, 2), or Color LookUp Table
+        with at least shape (N, 4); see `gamma_correct_grey` and
+        `gamma_correct_RGB`. The first column are the input intensities,
+        all further columns up to the fourth are compiled.
+    n_levels : int, optional
+        number of bins of the dense index table, by default 2**16.
+        Match this to the output levels of the display (e.g., 2**16 for M16,
+        2**8 for C24). It only affects speed, never the results.
+
+    Returns
+    -------
+    CompiledLUT
+        to be passed as LUT (or CLUT) to `gamma_correct_grey`
+        (or `gamma_correct_RGB`)
+    """
+    LUT = np.asarray(LUT, dtype=float)
+    return CompiledLUT(LUT[:, 0], LUT[:, 1:4], n_levels=n_levels)
+
+
 def gamma_correct_grey(img, LUT):
     """Apply gamma correction to a greyscale array using a provided LUT.
 
@@ -51,16 +198,19 @@ def gamma_correct_grey(img, LUT):
     img : Array[float]
         input greyscale array with values between [0.0, 1.0].
         Can be a scalar, 1D array, or 2D array.
-    LUT : Array[float]
+    LUT : Array[float] or CompiledLUT
         LookUp Table with at least shape (N, 2), where the first column is
         input intensities and the second column is the corrected values.
         Can have more columns, which will be ignored.
+        Or a LUT precompiled with `compile_lut`.
 
     Returns
     -------
     Array[float]
         gamma-corrected greyscale array with the same shape as input.
     """
+    if isinstance(LUT, CompiledLUT):
+        return LUT(img)
     return np.interp(img, LUT[:, 0], LUT[:, 1])
 
 
@@ -72,16 +222,20 @@ def gamma_correct_RGB(img, CLUT):
     img : Array[float]
         input RGB array with values between [0.0, 1.0].
         Can be a single RGB triplet (shape: (1, 1, 3)) or an RGB image (shape: (H, W, 3)).
-    CLUT : Array[float]
+    CLUT : Array[float] or CompiledLUT
         Color LookUp Table with at least shape (N, 4), where the first column is
         input intensities and the next three columns are the corrected R, G, B values.
         Can have more columns, which will be ignored.
+        Or a CLUT precompiled with `compile_lut`.
 
     Returns
     -------
     Array[float]
         gamma-corrected RGB array with the same shape as input.
     """
+    if isinstance(CLUT, CompiledLUT):
+        return np.stack([CLUT(img[..., channel], channel) for channel in range(img.shape[-1])], axis=-1)
+
     # Apply interpolation per channel
     linearized_RGB = np.array(
         [
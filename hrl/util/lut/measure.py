@@ -4,7 +4,12 @@ from functools import partial
 from timeit import default_timer as timer
 
 from hrl import HRL
-from hrl.calibration.measurement import draw_uniform_square, measure_lut, setup_intensities
+from hrl.calibration.measurement import (
+    ClutSquare,
+    draw_uniform_square,
+    measure_lut,
+    setup_intensities,
+)
 from hrl.util import graphics_argparser
 from hrl.util.lut import intensities_argparser
 
@@ -41,6 +46,11 @@ patch_arggroup.add_argument(
     default=0.5,
     help="Patch size as fraction of screen, by default 0.5",
 )
+patch_arggroup.add_argument(
+    "--clut",
+    action="store_true",
+    help="Set patch intensity through the L48 video CLUT instead of new textures (VPixx devices only)",
+)
 
 
 parser = argparse.ArgumentParser(
@@ -100,15 +110,24 @@ def command(parsed_args):
         f"Measuring {len(intensities)} intensity values ([{parsed_args.int_min}, {parsed_args.int_max}])..."
     )
 
+    # Set up calibration patch
+    if parsed_args.clut:
+        stim_draw_func = ClutSquare(ihrl, patch_size=parsed_args.patch_size)
+    else:
+        stim_draw_func = partial(draw_uniform_square, patch_size=parsed_args.patch_size)
+
     # Measure luminance for intensity values
     measure_lut(
         ihrl,
         intensities=intensities,
-        stim_draw_func=partial(draw_uniform_square, patch_size=parsed_args.patch_size),
+        stim_draw_func=stim_draw_func,
         n_samples=parsed_args.n_samples,
         sleep_time=parsed_args.sleep_time,
     )
 
+    if parsed_args.clut:
+        stim_draw_func.close()
+
     # Experiment is over!
     ihrl.close()
 
@@ -33,6 +33,11 @@
 #include <string.h>
 #include <math.h>
 #include <ctype.h>
+#if defined(__AVX2__)
+#include <immintrin.h>		// Bulk buffer decoding kernels
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "libdpx.h"		// user API.  Make sure to include libdpx src folder in user include path
 #include "usb.h"		// Must be from libusb, not OS, so  make sure libusb is in user include path
@@ -2428,6 +2433,136 @@ double DPxMakeFloat64FromTwoUInt32(UInt32 highUInt32, UInt32 lowUInt32)
 }
 
 
+// Host shadow of DATAPixx RAM.
+// We keep a content hash for each DPX_RAM_SHADOW_PAGE_SIZE page which the host has written with DPxWriteRam().
+// A full page which would be rewritten with identical contents is not transmitted again.
+// Pages which the DATAPixx can write by itself (ADC, DIN and MIC buffers) are invalidated whenever those schedules could run.
+#define DPX_RAM_SHADOW_MAX_PAGES	((256 << 20) / DPX_RAM_SHADOW_PAGE_SIZE)
+
+static unsigned long long dpxRamShadowHash[DPX_RAM_SHADOW_MAX_PAGES];
+static unsigned char dpxRamShadowValid[DPX_RAM_SHADOW_MAX_PAGES];
+static int dpxRamShadowEnabled = 0;
+static double dpxRamShadowBytesSent = 0;
+static double dpxRamShadowBytesSkipped = 0;
+
+// Copy of the horizontal overlay alpha table last written to the DATAPixx, so that identical tables are not re-sent
+static UInt16 dpxVidAlphaShadow[1024];
+static int dpxVidAlphaShadowValid = 0;
+
+
+// 64-bit FNV-1a style hash of one shadow page, consuming 8 bytes per step
+static unsigned long long DPxRamShadowHashPage(const char* data)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	unsigned long long word;
+	int i;
+
+	for (i = 0; i < DPX_RAM_SHADOW_PAGE_SIZE; i += 8) {
+		memcpy(&word, data + i, 8);
+		hash = (hash ^ word) * 1099511628211ULL;
+		hash ^= hash >> 29;
+	}
+	return hash;
+}
+
+
+// Forget the contents of all shadow pages which overlap the specified block of DATAPixx RAM
+void DPxInvalidateRamShadow(unsigned address, unsigned length)
+{
+	unsigned iPage, lastPage;
+
+	if (!length)
+		return;
+	iPage = address / DPX_RAM_SHADOW_PAGE_SIZE;
+	lastPage = (address + length - 1) / DPX_RAM_SHADOW_PAGE_SIZE;
+	for ( ; iPage <= lastPage && iPage < DPX_RAM_SHADOW_MAX_PAGES; iPage++)
+		dpxRamShadowValid[iPage] = 0;
+}
+
+
+// Non-0 if the schedule whose start/stop field is at startStopShift has been started, or is about to be started by a pending register write
+static int DPxIsRamShadowSchedActive(int startStopShift, int isRunning)
+{
+	return isRunning || ((dpxRegisterCache[DPXREG_SCHED_STARTSTOP/2] >> startStopShift) & DPXREG_SCHED_STARTSTOP_MASK) == DPXREG_SCHED_STARTSTOP_START;
+}
+
+
+// Get the RAM buffers which the DATAPixx could currently be writing into.
+// Fills baseAddr[] and size[] with up to 3 entries, and returns the number of entries.
+static int DPxGetRamShadowVolatileBuffs(unsigned* baseAddr, unsigned* size)
+{
+	int nBuffs = 0;
+
+	if (DPxIsRamShadowSchedActive(DPXREG_SCHED_STARTSTOP_SHIFT_ADC, DPxIsAdcSchedRunning())) {
+		baseAddr[nBuffs] = DPxGetAdcBuffBaseAddr();
+		size[nBuffs++] = DPxGetAdcBuffSize();
+	}
+	if (DPxIsRamShadowSchedActive(DPXREG_SCHED_STARTSTOP_SHIFT_DIN, DPxIsDinSchedRunning() || DPxIsDinLogEvents())) {
+		baseAddr[nBuffs] = DPxGetDinBuffBaseAddr();
+		size[nBuffs++] = DPxGetDinBuffSize();
+	}
+	if (DPxIsRamShadowSchedActive(DPXREG_SCHED_STARTSTOP_SHIFT_MIC, DPxIsMicSchedRunning())) {
+		baseAddr[nBuffs] = DPxGetMicBuffBaseAddr();
+		size[nBuffs++] = DPxGetMicBuffSize();
+	}
+	return nBuffs;
+}
+
+
+// Called each time registers are written to the DATAPixx.
+// Invalidates the shadow of each buffer which a starting or running ADC/DIN/MIC schedule can write into.
+static void DPxInvalidateRamShadowVolatileBuffs(void)
+{
+	unsigned baseAddr[3], size[3];
+	int iBuff, nBuffs;
+
+	if (!dpxRamShadowEnabled)
+		return;
+	nBuffs = DPxGetRamShadowVolatileBuffs(baseAddr, size);
+	for (iBuff = 0; iBuff < nBuffs; iBuff++)
+		DPxInvalidateRamShadow(baseAddr[iBuff], size[iBuff]);
+}
+
+
+// Enable the host shadow of DATAPixx RAM, so DPxWriteRam() skips pages which already hold the same data.
+// The shadow starts out empty, so the first upload of each page is always transmitted.
+void DPxEnableRamShadow()
+{
+	memset(dpxRamShadowValid, 0, sizeof(dpxRamShadowValid));
+	dpxRamShadowBytesSent = 0;
+	dpxRamShadowBytesSkipped = 0;
+	dpxRamShadowEnabled = 1;
+}
+
+
+// Disable the host shadow of DATAPixx RAM.  DPxWriteRam() transmits every byte.
+void DPxDisableRamShadow()
+{
+	dpxRamShadowEnabled = 0;
+}
+
+
+// Returns non-0 if DPxWriteRam() skips pages which already hold the same data
+int DPxIsRamShadow()
+{
+	return dpxRamShadowEnabled;
+}
+
+
+// Number of bytes which DPxWriteRam() has transmitted since DPxEnableRamShadow()
+double DPxGetRamShadowBytesSent()
+{
+	return dpxRamShadowBytesSent;
+}
+
+
+// Number of bytes which DPxWriteRam() has skipped since DPxEnableRamShadow(), because the DATAPixx already held the same data
+double DPxGetRamShadowBytesSkipped()
+{
+	return dpxRamShadowBytesSkipped;
+}
+
+
 // Call before any other DPx*() functions
 void DPxOpen()
 {
@@ -2439,6 +2574,10 @@ void DPxOpen()
 	// Any error during open should leave the register cache cleared
 	memset(dpxRegisterCache, 0, sizeof(dpxRegisterCache));
 
+	// Another app could have modified DATAPixx RAM or alpha table since we last wrote them
+	memset(dpxRamShadowValid, 0, sizeof(dpxRamShadowValid));
+	dpxVidAlphaShadowValid = 0;
+
     // Throw out any posted writes which haven't been executed yet!
     // We don't want the upcoming DPxUpdateRegCache() to write back a 0 to a register.
 	memset(dpxRegisterModified, 0, sizeof(dpxRegisterModified));
@@ -2611,33 +2750,11 @@ void DPxReadRam(unsigned address, unsigned length, void* buffer)
 }
 
 
-// Write a local buffer to DATAPixx RAM
-void DPxWriteRam(unsigned address, unsigned length, void* buffer)
+// Write a local buffer to DATAPixx RAM, without any argument checking or RAM shadow lookup.
+// Returns non-0 if a USB error occurred.
+static int DPxWriteRamBlocks(unsigned address, unsigned length, char* buffPtr)
 {
 	unsigned short blockLength, payloadLength;
-	char* buffPtr = (char*)buffer;
-
-	// Validate args
-	if (address & 1) {
-		DPxDebugPrint1("ERROR: DPxWriteRam() argument address 0x%x is not an even number\n", address);
-		DPxSetError(DPX_ERR_RAM_WRITE_ADDR_ODD);
-		return;
-	}
-	if (length & 1) {
-		DPxDebugPrint1("ERROR: DPxWriteRam() argument length 0x%x is not an even number\n", length);
-		DPxSetError(DPX_ERR_RAM_WRITE_LEN_ODD);
-		return;
-	}
-	if (address + length > DPxGetRamSize()) {
-		DPxDebugPrint2("ERROR: DPxWriteRam() argument address 0x%x plus length 0x%x exceeds DATAPixx memory size\n", address, length);
-		DPxSetError(DPX_ERR_RAM_WRITE_TOO_HIGH);
-		return;
-	}
-	if (!buffer) {
-		DPxDebugPrint0("ERROR: DPxWriteRam() argument buffer address is null\n");
-		DPxSetError(DPX_ERR_RAM_WRITE_BUFFER_NULL);
-		return;
-	}
 
 	// Break into largest supported tram chunks
 	while (length) {
@@ -2659,13 +2776,107 @@ void DPxWriteRam(unsigned address, unsigned length, void* buffer)
 		if (EZWriteEP2Tram(ep2out_Tram, 0, 0)) {
 			DPxDebugPrint0("ERROR: DPxWriteRam() call to EZWriteEP2Tram() failed\n");
 			DPxSetError(DPX_ERR_RAM_WRITE_USB_ERROR);
-			return;
+			return -1;
 		}
 
 		address += blockLength;
 		buffPtr += blockLength;
 		length  -= blockLength;
 	}
+	return 0;
+}
+
+
+// Write a local buffer to DATAPixx RAM.
+// If the RAM shadow is enabled, full pages which the DATAPixx already holds are not transmitted again,
+// and the remaining pages are transmitted as contiguous spans.
+void DPxWriteRam(unsigned address, unsigned length, void* buffer)
+{
+	char* buffPtr = (char*)buffer;
+	unsigned volatileAddr[3], volatileSize[3];
+	unsigned offset, chunkLength, pageAddr, spanOffset, spanLength, iPage;
+	unsigned long long hash;
+	int nVolatile, iVolatile, sendChunk;
+
+	// Validate args
+	if (address & 1) {
+		DPxDebugPrint1("ERROR: DPxWriteRam() argument address 0x%x is not an even number\n", address);
+		DPxSetError(DPX_ERR_RAM_WRITE_ADDR_ODD);
+		return;
+	}
+	if (length & 1) {
+		DPxDebugPrint1("ERROR: DPxWriteRam() argument length 0x%x is not an even number\n", length);
+		DPxSetError(DPX_ERR_RAM_WRITE_LEN_ODD);
+		return;
+	}
+	if (address + length > DPxGetRamSize()) {
+		DPxDebugPrint2("ERROR: DPxWriteRam() argument address 0x%x plus length 0x%x exceeds DATAPixx memory size\n", address, length);
+		DPxSetError(DPX_ERR_RAM_WRITE_TOO_HIGH);
+		return;
+	}
+	if (!buffer) {
+		DPxDebugPrint0("ERROR: DPxWriteRam() argument buffer address is null\n");
+		DPxSetError(DPX_ERR_RAM_WRITE_BUFFER_NULL);
+		return;
+	}
+
+	// Without a shadow, or when caller wrote directly into ep2out_Tram, just send everything
+	if (!dpxRamShadowEnabled || (void*)buffPtr == (void*)(ep2out_Tram+8)) {
+		if (dpxRamShadowEnabled) {
+			DPxInvalidateRamShadow(address, length);
+			dpxRamShadowBytesSent += length;
+		}
+		DPxWriteRamBlocks(address, length, buffPtr);
+		return;
+	}
+
+	// Walk through the block one shadow page at a time, accumulating a span of pages which must be sent.
+	// Partial pages and pages which a schedule could be writing are always sent, and are left invalid in the shadow.
+	nVolatile = DPxGetRamShadowVolatileBuffs(volatileAddr, volatileSize);
+	spanOffset = 0;
+	spanLength = 0;
+	for (offset = 0; offset < length; offset += chunkLength) {
+		pageAddr = address + offset;
+		iPage = pageAddr / DPX_RAM_SHADOW_PAGE_SIZE;
+		chunkLength = DPX_RAM_SHADOW_PAGE_SIZE - pageAddr % DPX_RAM_SHADOW_PAGE_SIZE;
+		if (chunkLength > length - offset)
+			chunkLength = length - offset;
+
+		sendChunk = 1;
+		for (iVolatile = 0; iVolatile < nVolatile; iVolatile++)
+			if (pageAddr < volatileAddr[iVolatile] + volatileSize[iVolatile] && pageAddr + chunkLength > volatileAddr[iVolatile])
+				break;
+		if (chunkLength == DPX_RAM_SHADOW_PAGE_SIZE && iVolatile == nVolatile) {
+			hash = DPxRamShadowHashPage(buffPtr + offset);
+			if (dpxRamShadowValid[iPage] && dpxRamShadowHash[iPage] == hash)
+				sendChunk = 0;
+			dpxRamShadowHash[iPage] = hash;
+			dpxRamShadowValid[iPage] = 1;
+		}
+		else
+			dpxRamShadowValid[iPage] = 0;
+
+		if (sendChunk) {
+			if (!spanLength)
+				spanOffset = offset;
+			spanLength += chunkLength;
+			continue;
+		}
+		dpxRamShadowBytesSkipped += chunkLength;
+		if (spanLength) {
+			dpxRamShadowBytesSent += spanLength;
+			if (DPxWriteRamBlocks(address + spanOffset, spanLength, buffPtr + spanOffset)) {
+				DPxInvalidateRamShadow(address, length);	// A USB error leaves the device contents unknown
+				return;
+			}
+			spanLength = 0;
+		}
+	}
+	if (spanLength) {
+		dpxRamShadowBytesSent += spanLength;
+		if (DPxWriteRamBlocks(address + spanOffset, spanLength, buffPtr + spanOffset))
+			DPxInvalidateRamShadow(address, length);
+	}
 }
 
 
@@ -2844,6 +3055,9 @@ void DPxBuildUsbMsgWriteRegs()
 		}
 	}
 
+	// Any RAM buffer which a schedule is about to write can no longer be trusted by the RAM shadow
+	DPxInvalidateRamShadowVolatileBuffs();
+
     // Some register bits are one-shots, and must be manually reset to 0 once they are written
 	dpxRegisterCache[DPXREG_SCHED_STARTSTOP/2] = 0;                     // Starting/stopping schedules
     dpxRegisterCache[DPXREG_CTRL/2] &= ~DPXREG_CTRL_CALIB_RELOAD;       // SPI calibration table reload
@@ -3766,6 +3980,158 @@ int DPxIsDacSchedRunning()
 /********************************************************************************/
 
 
+// Bulk decoding of timetagged RAM buffers.
+// A buffered dataset is an optional 64-bit nanosecond timetag (4 little-endian 16-bit words, least significant first),
+// followed by the 16-bit samples of the dataset.
+// The kernels below convert frames [iFrame, nFrames) of such a buffer, and return the index of the first frame they did not convert,
+// so that the SIMD versions can hand their tail to the scalar versions.
+// The SIMD versions perform the same IEEE operations as the scalar versions.
+// Timetags are bit-identical to DPxMakeFloat64FromTwoUInt32() * 1.0e-9, since hi * 2^32 is exact.
+
+// Read a little-endian 16-bit word, independent of host byte order and buffer alignment
+#define DPxDecodeWord(bytePtr) ((UInt16)((bytePtr)[0] | ((bytePtr)[1] << 8)))
+
+
+static int DPxDecodeTimetagsScalar(const unsigned char* buffer, int frameBytes, int iFrame, int nFrames, double* timeSecs)
+{
+	const unsigned char* framePtr;
+	UInt32 lowUInt32, highUInt32;
+
+	for ( ; iFrame < nFrames; iFrame++) {
+		framePtr = buffer + iFrame * frameBytes;
+		lowUInt32  = DPxDecodeWord(framePtr+0) | ((UInt32)DPxDecodeWord(framePtr+2) << 16);
+		highUInt32 = DPxDecodeWord(framePtr+4) | ((UInt32)DPxDecodeWord(framePtr+6) << 16);
+		timeSecs[iFrame] = DPxMakeFloat64FromTwoUInt32(highUInt32, lowUInt32) * 1.0e-9;
+	}
+	return iFrame;
+}
+
+
+static int DPxDecodeSamplesScalar(const unsigned char* buffer, int frameBytes, int iFrame, int nFrames, float scale, float offset, float* volts)
+{
+	for ( ; iFrame < nFrames; iFrame++)
+		volts[iFrame] = (float)(SInt16)DPxDecodeWord(buffer + iFrame * frameBytes) * scale + offset;
+	return iFrame;
+}
+
+
+#if defined(__AVX2__)
+
+// Convert 4 unsigned 32-bit integers (held in the low 32 bits of each 64-bit lane) to double
+static __m256d DPxDecodeUInt32ToDouble(__m256i x)
+{
+	__m128i packed = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0)));
+	__m256d signedDouble = _mm256_cvtepi32_pd(_mm_xor_si128(packed, _mm_set1_epi32((int)0x80000000)));
+	return _mm256_add_pd(signedDouble, _mm256_set1_pd(2147483648.0));
+}
+
+
+// 4 timetags per iteration, using a 64-bit gather
+static int DPxDecodeTimetagsSimd(const unsigned char* buffer, int frameBytes, int iFrame, int nFrames, double* timeSecs)
+{
+	__m128i index = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(frameBytes));
+	__m256i tags;
+	__m256d hi, lo;
+
+	for ( ; iFrame + 4 <= nFrames; iFrame += 4) {
+		tags = _mm256_i32gather_epi64((const long long*)(buffer + iFrame * frameBytes), index, 1);
+		lo = DPxDecodeUInt32ToDouble(tags);
+		hi = DPxDecodeUInt32ToDouble(_mm256_srli_epi64(tags, 32));
+		_mm256_storeu_pd(timeSecs + iFrame, _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(4294967296.0), hi), lo), _mm256_set1_pd(1.0e-9)));
+	}
+	return iFrame;
+}
+
+
+// 8 samples per iteration, using a 32-bit gather.
+// Each gather reads 2 bytes past the sample, so the last frame is always left to the scalar version.
+static int DPxDecodeSamplesSimd(const unsigned char* buffer, int frameBytes, int iFrame, int nFrames, float scale, float offset, float* volts)
+{
+	__m256i index = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(frameBytes));
+	__m256i samples;
+
+	for ( ; iFrame + 8 < nFrames; iFrame += 8) {
+		samples = _mm256_i32gather_epi32((const int*)(buffer + iFrame * frameBytes), index, 1);
+		samples = _mm256_srai_epi32(_mm256_slli_epi32(samples, 16), 16);
+		_mm256_storeu_ps(volts + iFrame, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(samples), _mm256_set1_ps(scale)), _mm256_set1_ps(offset)));
+	}
+	return iFrame;
+}
+
+#elif defined(__SSE2__)
+
+// Convert 2 unsigned 32-bit integers (in the low 2 lanes) to double
+static __m128d DPxDecodeUInt32ToDouble(__m128i x)
+{
+	__m128d signedDouble = _mm_cvtepi32_pd(_mm_xor_si128(x, _mm_set1_epi32((int)0x80000000)));
+	return _mm_add_pd(signedDouble, _mm_set1_pd(2147483648.0));
+}
+
+
+// 2 timetags per iteration.  SSE2 has no gather, so the 32-bit halves are loaded individually.
+static int DPxDecodeTimetagsSimd(const unsigned char* buffer, int frameBytes, int iFrame, int nFrames, double* timeSecs)
+{
+	const unsigned char *frame0, *frame1;
+	UInt32 lo0, lo1, hi0, hi1;
+	__m128d hi, lo;
+
+	for ( ; iFrame + 2 <= nFrames; iFrame += 2) {
+		frame0 = buffer + iFrame * frameBytes;
+		frame1 = frame0 + frameBytes;
+		memcpy(&lo0, frame0, 4);
+		memcpy(&hi0, frame0+4, 4);
+		memcpy(&lo1, frame1, 4);
+		memcpy(&hi1, frame1+4, 4);
+		lo = DPxDecodeUInt32ToDouble(_mm_setr_epi32((int)lo0, (int)lo1, 0, 0));
+		hi = DPxDecodeUInt32ToDouble(_mm_setr_epi32((int)hi0, (int)hi1, 0, 0));
+		_mm_storeu_pd(timeSecs + iFrame, _mm_mul_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(4294967296.0), hi), lo), _mm_set1_pd(1.0e-9)));
+	}
+	return iFrame;
+}
+
+
+// 8 samples per iteration, sign-extended to 32 bits and converted as 2 groups of 4
+static int DPxDecodeSamplesSimd(const unsigned char* buffer, int frameBytes, int iFrame, int nFrames, float scale, float offset, float* volts)
+{
+	const unsigned char* framePtr;
+	__m128i samples;
+	__m128 scaleVec = _mm_set1_ps(scale), offsetVec = _mm_set1_ps(offset);
+
+	for ( ; iFrame + 8 <= nFrames; iFrame += 8) {
+		framePtr = buffer + iFrame * frameBytes;
+		samples = _mm_setr_epi16((short)DPxDecodeWord(framePtr+0*frameBytes), (short)DPxDecodeWord(framePtr+1*frameBytes),
+								 (short)DPxDecodeWord(framePtr+2*frameBytes), (short)DPxDecodeWord(framePtr+3*frameBytes),
+								 (short)DPxDecodeWord(framePtr+4*frameBytes), (short)DPxDecodeWord(framePtr+5*frameBytes),
+								 (short)DPxDecodeWord(framePtr+6*frameBytes), (short)DPxDecodeWord(framePtr+7*frameBytes));
+		_mm_storeu_ps(volts + iFrame,   _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16)), scaleVec), offsetVec));
+		_mm_storeu_ps(volts + iFrame+4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16)), scaleVec), offsetVec));
+	}
+	return iFrame;
+}
+
+#else
+
+#define DPxDecodeTimetagsSimd(buffer, frameBytes, iFrame, nFrames, timeSecs)				(iFrame)
+#define DPxDecodeSamplesSimd(buffer, frameBytes, iFrame, nFrames, scale, offset, volts)	(iFrame)
+
+#endif
+
+
+// Decode the timetags of nFrames datasets of frameBytes each
+static void DPxDecodeTimetags(const unsigned char* buffer, int frameBytes, int nFrames, double* timeSecs)
+{
+	DPxDecodeTimetagsScalar(buffer, frameBytes, DPxDecodeTimetagsSimd(buffer, frameBytes, 0, nFrames, timeSecs), nFrames, timeSecs);
+}
+
+
+// Decode one 16-bit 2's complement channel of nFrames datasets of frameBytes each.
+// buffer points to the channel's first sample.
+static void DPxDecodeSamples(const unsigned char* buffer, int frameBytes, int nFrames, float scale, float offset, float* volts)
+{
+	DPxDecodeSamplesScalar(buffer, frameBytes, DPxDecodeSamplesSimd(buffer, frameBytes, 0, nFrames, scale, offset, volts), nFrames, scale, offset, volts);
+}
+
+
 // Returns number of ADC channels in system, excluding REF0/1
 int DPxGetAdcNumChans()
 {
@@ -4213,77 +4579,542 @@ int DPxIsAdcLogTimetags()
 }
 
 
-/********************************************************************************/
-/*																				*/
-/*	DOUT (Digital Output) Subsystem												*/
-/*																				*/
-/********************************************************************************/
-
-
-// Returns number of digital output bits in system (24 in current implementation)
-int DPxGetDoutNumBits()
+// DPxDecodeAdcBuff(), reporting errors as raised by caller.
+// Returns DPX_SUCCESS, or the error code which it also sets if the arguments are bad and nothing was decoded.
+static int DPxDecodeAdcData(const char* caller, void* buffer, int nFrames, int nChans, int* channels, int timetagged, double* timeSecs, float* volts)
 {
-	return 24;
-}
+	const unsigned char* bytePtr = (const unsigned char*)buffer;
+	int frameBytes, iChan, channel;
+	double minV, maxV, scale;
 
+	if (nFrames < 0 || nChans < 1 || nChans > DPX_ADC_NCHANS) {
+		DPxDebugPrint3("ERROR: %s() arguments nFrames %d and nChans %d out of range\n", caller, nFrames, nChans);
+		DPxSetError(DPX_ERR_ADC_DECODE_BAD_ARGS);
+		return DPX_ERR_ADC_DECODE_BAD_ARGS;
+	}
+	if (!buffer && nFrames) {
+		DPxDebugPrint1("ERROR: %s() argument buffer is null\n", caller);
+		DPxSetError(DPX_ERR_ADC_DECODE_NULL_PTR);
+		return DPX_ERR_ADC_DECODE_NULL_PTR;
+	}
 
-// For each of the 24 bits set in bitMask, set the DOUT to the value in the corresponding bitValue.
-void DPxSetDoutValue(int bitValue, int bitMask)
-{
-	// If user specified unimplemented bits, it's not a fatal error so don't return.
-	// At least set the implemented bits.
-	if (bitMask & 0xFF000000) {
-		DPxDebugPrint2("ERROR: DPxSetDoutValue() argument bitMask %08X includes unimplemented bits %08X\n", bitMask, bitMask & 0xFF000000);
-		DPxSetError(DPX_ERR_DOUT_SET_BAD_MASK);
+	// Check the channels here, rather than the global error after DPxGetAdcRange(), which could be left over from an earlier call
+	for (iChan = 0; iChan < nChans; iChan++) {
+		channel = channels ? channels[iChan] : iChan;
+		if (channel < 0 || channel > DPX_ADC_NCHANS+1) {
+			DPxDebugPrint3("ERROR: %s() channel %d is not in range 0 to %d\n", caller, channel, DPX_ADC_NCHANS+1);
+			DPxSetError(DPX_ERR_ADC_RANGE_BAD_CHANNEL);
+			return DPX_ERR_ADC_RANGE_BAD_CHANNEL;
+		}
 	}
 
-	// Internally, the 24 DOUT bits are implemented as a single 32-bit register.
-	// Note that a user write, and a schedule, can step over each other.
-	if (bitMask)
-		DPxSetReg32(DPXREG_DOUT_DATA_L, (DPxGetReg32(DPXREG_DOUT_DATA_L) & ~bitMask) | (bitValue & bitMask));
+	frameBytes = (nChans + (timetagged ? 4 : 0)) * 2;
+	if (timetagged) {
+		if (timeSecs)
+			DPxDecodeTimetags(bytePtr, frameBytes, nFrames, timeSecs);
+		bytePtr += 8;
+	}
+	if (!volts)
+		return DPX_SUCCESS;
+	for (iChan = 0; iChan < nChans; iChan++) {
+		DPxGetAdcRange(channels ? channels[iChan] : iChan, &minV, &maxV);
+		scale = (maxV - minV) / 65536;
+		DPxDecodeSamples(bytePtr + iChan * 2, frameBytes, nFrames, (float)scale, (float)(32768 * scale + minV), volts + iChan * nFrames);
+	}
+	return DPX_SUCCESS;
 }
 
 
-// Get the values of the 24 DOUT bits
-int DPxGetDoutValue()
+// Decode a block of ADC RAM buffer data, which has been copied to the host with DPxReadRam().
+// The buffer holds nFrames datasets, each with an optional 64-bit timetag followed by nChans 16-bit samples.
+// channels[] lists the ADC channel (0-17) of each of the nChans samples, for voltage calibration.
+// channels can be null, in which case sample i of each dataset is taken to be channel i.
+// timeSecs receives nFrames timetags in seconds, and can be null (it is ignored if timetagged is 0).
+// volts receives nChans*nFrames voltages, channel by channel, so channel i starts at volts[i*nFrames].  It can be null.
+void DPxDecodeAdcBuff(void* buffer, int nFrames, int nChans, int* channels, int timetagged, double* timeSecs, float* volts)
 {
-	return DPxGetReg32(DPXREG_DOUT_DATA_L);
+	DPxDecodeAdcData("DPxDecodeAdcBuff", buffer, nFrames, nChans, channels, timetagged, timeSecs, volts);
 }
 
 
-// Enable automatic DOUT schedules upon DIN button presses
-void DPxEnableDoutButtonSchedules()
+// Online ADC event detection.
+// Each ADC channel (0-15) can have one trigger, which is a Schmitt trigger on either the sample voltage (DPX_ADC_EVENT_LEVEL)
+// or on its time derivative in volts per second (DPX_ADC_EVENT_SLOPE).
+// The trigger switches high when the signal reaches threshold+hysteresis/2, and switches low when it reaches threshold-hysteresis/2.
+// Timetagged datasets are decoded in blocks, and event times are interpolated linearly between the two samples bracketing the crossing.
+typedef struct {
+	int		mode;				// DPX_ADC_EVENT_LEVEL/SLOPE, or -1 if the channel has no trigger
+	int		edge;				// OR of DPX_ADC_EVENT_RISING/FALLING
+	float	upper, lower;		// Schmitt trigger levels
+	int		state;				// -1 until the first sample, then 0 for low and 1 for high
+	int		hasLast;			// Non-0 once lastTime/lastVolts are valid
+	double	lastTime;			// Timetag of the previous dataset
+	float	lastVolts;			// Voltage of the previous dataset
+	float	lastSignal;			// Triggered signal (voltage or slope) of the previous dataset
+} DPxAdcEventTrigger;
+
+typedef struct {
+	int		channel;
+	int		edge;
+	double	timeSecs;
+} DPxAdcEvent;
+
+#define DPX_ADC_EVENT_BLOCK_FRAMES	(DPX_RWRAM_BLOCK_SIZE / 10)		// Largest number of timetagged datasets in one RAM read block
+
+#define DPX_ADC_EVENT_NO_TRIGGER	{ -1, 0, 0, 0, -1, 0, 0, 0, 0 }
+
+static DPxAdcEventTrigger dpxAdcEventTriggers[DPX_ADC_NCHANS] = {
+	DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER,
+	DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER,
+	DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER,
+	DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER, DPX_ADC_EVENT_NO_TRIGGER
+};
+static DPxAdcEvent dpxAdcEventQueue[DPX_ADC_EVENT_QUEUE_SIZE];
+static int dpxAdcEventQueueHead = 0;	// Index of oldest event
+static int dpxAdcEventQueueCount = 0;
+static unsigned dpxAdcEventsDropped = 0;
+static unsigned dpxAdcEventReadAddr = 0;
+static int dpxAdcEventReadAddrValid = 0;
+static double dpxAdcEventTimes[DPX_ADC_EVENT_BLOCK_FRAMES];
+static float dpxAdcEventVolts[DPX_ADC_NCHANS * DPX_ADC_EVENT_BLOCK_FRAMES];
+static float dpxAdcEventSignal[DPX_ADC_EVENT_BLOCK_FRAMES];
+static unsigned char dpxAdcEventRaw[DPX_ADC_EVENT_BLOCK_FRAMES * 10];
+
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// Index of the lowest set bit in a non-0 SIMD comparison mask
+static int DPxLowestSetBit(int mask)
 {
-	DPxSetReg16(DPXREG_DOUT_CTRL, DPxGetReg16(DPXREG_DOUT_CTRL) | DPXREG_DOUT_CTRL_BUTTON_SCHEDULES);
+	int iBit = 0;
+
+	while (!(mask & (1 << iBit)))
+		iBit++;
+	return iBit;
 }
+#endif
 
 
-// Disable automatic DOUT schedules upon DIN button presses
-void DPxDisableDoutButtonSchedules()
+// Index of the first signal[i] >= level for i in [iFrame, nFrames), or nFrames if there is none
+static int DPxAdcEventFindAbove(const float* signal, int iFrame, int nFrames, float level)
 {
-	DPxSetReg16(DPXREG_DOUT_CTRL, DPxGetReg16(DPXREG_DOUT_CTRL) & ~DPXREG_DOUT_CTRL_BUTTON_SCHEDULES);
+#if defined(__AVX2__)
+	__m256 levelVec = _mm256_set1_ps(level);
+	int mask;
+
+	for ( ; iFrame + 8 <= nFrames; iFrame += 8)
+		if ((mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(signal + iFrame), levelVec, _CMP_GE_OQ))))
+			return iFrame + DPxLowestSetBit(mask);
+#elif defined(__SSE2__)
+	__m128 levelVec = _mm_set1_ps(level);
+	int mask;
+
+	for ( ; iFrame + 4 <= nFrames; iFrame += 4)
+		if ((mask = _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(signal + iFrame), levelVec))))
+			return iFrame + DPxLowestSetBit(mask);
+#endif
+	for ( ; iFrame < nFrames; iFrame++)
+		if (signal[iFrame] >= level)
+			break;
+	return iFrame;
 }
 
 
-// Returns non-0 if automatic DOUT schedules occur upon DIN button presses
-int DPxIsDoutButtonSchedules()
+// Index of the first signal[i] <= level for i in [iFrame, nFrames), or nFrames if there is none
+static int DPxAdcEventFindBelow(const float* signal, int iFrame, int nFrames, float level)
 {
-	return DPxGetReg16(DPXREG_DOUT_CTRL) & DPXREG_DOUT_CTRL_BUTTON_SCHEDULES;
+#if defined(__AVX2__)
+	__m256 levelVec = _mm256_set1_ps(level);
+	int mask;
+
+	for ( ; iFrame + 8 <= nFrames; iFrame += 8)
+		if ((mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(signal + iFrame), levelVec, _CMP_LE_OQ))))
+			return iFrame + DPxLowestSetBit(mask);
+#elif defined(__SSE2__)
+	__m128 levelVec = _mm_set1_ps(level);
+	int mask;
+
+	for ( ; iFrame + 4 <= nFrames; iFrame += 4)
+		if ((mask = _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(signal + iFrame), levelVec))))
+			return iFrame + DPxLowestSetBit(mask);
+#endif
+	for ( ; iFrame < nFrames; iFrame++)
+		if (signal[iFrame] <= level)
+			break;
+	return iFrame;
 }
 
 
-// Set DOUT RAM buffer start address.  Must be an even value.
-void DPxSetDoutBuffBaseAddr(unsigned buffBaseAddr)
+// Append an event to the queue, dropping it if the queue is full.
+// Drops are only counted, for DPxGetAdcEventsDropped(); an error code would stop DPxPollAdcEvents() for good.
+static void DPxPushAdcEvent(int channel, int edge, double timeSecs)
 {
-	if (buffBaseAddr & 1) {
-		DPxDebugPrint1("ERROR: DPxSetDoutBuffBaseAddr(0x%x) illegal odd address\n", buffBaseAddr);
-		DPxSetError(DPX_ERR_DOUT_BUFF_ODD_BASEADDR);
+	DPxAdcEvent* event;
+
+	if (dpxAdcEventQueueCount == DPX_ADC_EVENT_QUEUE_SIZE) {
+		dpxAdcEventsDropped++;
+		DPxDebugPrint1("ERROR: ADC event queue is full, dropping event on channel %d\n", channel);
 		return;
 	}
-	if (buffBaseAddr >= DPxGetRamSize()) {
-		DPxDebugPrint1("ERROR: DPxSetDoutBuffBaseAddr(0x%x) exceeds DATAPixx RAM\n", buffBaseAddr);
-		DPxSetError(DPX_ERR_DOUT_BUFF_BASEADDR_TOO_HIGH);
-		return;
+	event = &dpxAdcEventQueue[(dpxAdcEventQueueHead + dpxAdcEventQueueCount) % DPX_ADC_EVENT_QUEUE_SIZE];
+	event->channel = channel;
+	event->edge = edge;
+	event->timeSecs = timeSecs;
+	dpxAdcEventQueueCount++;
+}
+
+
+// Run one channel's trigger over nFrames decoded datasets
+static void DPxDetectAdcChanEvents(int channel, const double* timeSecs, const float* volts, int nFrames)
+{
+	DPxAdcEventTrigger* trigger = &dpxAdcEventTriggers[channel];
+	const float* signal = volts;
+	float level, prevSignal;
+	double prevTime, dt;
+	int iFrame, iCross, edge;
+
+	if (nFrames <= 0)
+		return;
+
+	// Slope triggers run on the derivative of the voltage.  The first dataset ever seen has no derivative, so it repeats the second.
+	if (trigger->mode == DPX_ADC_EVENT_SLOPE) {
+		for (iFrame = 0; iFrame < nFrames; iFrame++) {
+			if (iFrame == 0 && !trigger->hasLast)
+				continue;
+			prevTime = iFrame ? timeSecs[iFrame-1] : trigger->lastTime;
+			dt = timeSecs[iFrame] - prevTime;
+			dpxAdcEventSignal[iFrame] = dt > 0 ? (float)((volts[iFrame] - (iFrame ? volts[iFrame-1] : trigger->lastVolts)) / dt) : 0;
+		}
+		if (!trigger->hasLast)
+			dpxAdcEventSignal[0] = nFrames > 1 ? dpxAdcEventSignal[1] : 0;
+		signal = dpxAdcEventSignal;
+	}
+
+	// Initial trigger state comes from the first sample, without generating an event
+	if (trigger->state < 0)
+		trigger->state = signal[0] >= (trigger->upper + trigger->lower) / 2;
+
+	for (iFrame = 0; iFrame < nFrames; iFrame = iCross + 1) {
+		if (trigger->state) {
+			level = trigger->lower;
+			iCross = DPxAdcEventFindBelow(signal, iFrame, nFrames, level);
+			edge = DPX_ADC_EVENT_FALLING;
+		}
+		else {
+			level = trigger->upper;
+			iCross = DPxAdcEventFindAbove(signal, iFrame, nFrames, level);
+			edge = DPX_ADC_EVENT_RISING;
+		}
+		if (iCross == nFrames)
+			break;
+		trigger->state = !trigger->state;
+		if (!(trigger->edge & edge))
+			continue;
+
+		// Interpolate the crossing time between the previous dataset and the one which crossed
+		if (iCross || trigger->hasLast) {
+			prevTime = iCross ? timeSecs[iCross-1] : trigger->lastTime;
+			prevSignal = iCross ? signal[iCross-1] : trigger->lastSignal;
+			if (signal[iCross] != prevSignal)
+				DPxPushAdcEvent(channel, edge, prevTime + (timeSecs[iCross] - prevTime) * (level - prevSignal) / (signal[iCross] - prevSignal));
+			else
+				DPxPushAdcEvent(channel, edge, timeSecs[iCross]);
+		}
+		else
+			DPxPushAdcEvent(channel, edge, timeSecs[iCross]);
+	}
+
+	trigger->hasLast = 1;
+	trigger->lastTime = timeSecs[nFrames-1];
+	trigger->lastVolts = volts[nFrames-1];
+	trigger->lastSignal = signal[nFrames-1];
+}
+
+
+// Decode and run all triggers over a block of at most DPX_ADC_EVENT_BLOCK_FRAMES timetagged datasets
+static void DPxDetectAdcEventsBlock(const unsigned char* buffer, int nFrames, int nChans, int* channels)
+{
+	int iChan, channel;
+
+	if (DPxDecodeAdcData("DPxProcessAdcEvents", (void*)buffer, nFrames, nChans, channels, 1, dpxAdcEventTimes, dpxAdcEventVolts) != DPX_SUCCESS)
+		return;
+	for (iChan = 0; iChan < nChans; iChan++) {
+		channel = channels ? channels[iChan] : iChan;
+		if (channel >= 0 && channel < DPX_ADC_NCHANS && dpxAdcEventTriggers[channel].mode >= 0)
+			DPxDetectAdcChanEvents(channel, dpxAdcEventTimes, dpxAdcEventVolts + iChan * nFrames, nFrames);
+	}
+}
+
+
+// Set the event trigger for one ADC channel (0-15).
+// mode is DPX_ADC_EVENT_LEVEL to trigger on voltage, or DPX_ADC_EVENT_SLOPE to trigger on volts per second.
+// edge is an OR of DPX_ADC_EVENT_RISING and DPX_ADC_EVENT_FALLING.
+// The trigger switches at threshold +/- hysteresis/2.
+void DPxSetAdcEventTrigger(int channel, int mode, int edge, double threshold, double hysteresis)
+{
+	DPxAdcEventTrigger* trigger;
+
+	if (channel < 0 || channel >= DPX_ADC_NCHANS) {
+		DPxDebugPrint2("ERROR: DPxSetAdcEventTrigger() argument channel %d is not in range 0 to %d\n", channel, DPX_ADC_NCHANS-1);
+		DPxSetError(DPX_ERR_ADC_EVENT_BAD_CHANNEL);
+		return;
+	}
+	if (mode != DPX_ADC_EVENT_LEVEL && mode != DPX_ADC_EVENT_SLOPE) {
+		DPxDebugPrint1("ERROR: DPxSetAdcEventTrigger() unrecognized mode %d\n", mode);
+		DPxSetError(DPX_ERR_ADC_EVENT_BAD_MODE);
+		return;
+	}
+	if (!edge || (edge & ~DPX_ADC_EVENT_BOTH) || hysteresis < 0) {
+		DPxDebugPrint2("ERROR: DPxSetAdcEventTrigger() unrecognized edge %d or negative hysteresis %g\n", edge, hysteresis);
+		DPxSetError(DPX_ERR_ADC_EVENT_BAD_EDGE);
+		return;
+	}
+	trigger = &dpxAdcEventTriggers[channel];
+	trigger->mode = mode;
+	trigger->edge = edge;
+	trigger->upper = (float)(threshold + hysteresis / 2);
+	trigger->lower = (float)(threshold - hysteresis / 2);
+	trigger->state = -1;
+	trigger->hasLast = 0;
+}
+
+
+// Remove the event trigger from one ADC channel (0-15)
+void DPxClearAdcEventTrigger(int channel)
+{
+	if (channel < 0 || channel >= DPX_ADC_NCHANS) {
+		DPxDebugPrint2("ERROR: DPxClearAdcEventTrigger() argument channel %d is not in range 0 to %d\n", channel, DPX_ADC_NCHANS-1);
+		DPxSetError(DPX_ERR_ADC_EVENT_BAD_CHANNEL);
+		return;
+	}
+	dpxAdcEventTriggers[channel].mode = -1;
+}
+
+
+// Flush the event queue, forget all trigger states, and restart DPxPollAdcEvents() at the start of the ADC buffer.
+// Call this just before starting the ADC schedule.
+void DPxResetAdcEvents()
+{
+	int iChan;
+
+	for (iChan = 0; iChan < DPX_ADC_NCHANS; iChan++) {
+		dpxAdcEventTriggers[iChan].state = -1;
+		dpxAdcEventTriggers[iChan].hasLast = 0;
+	}
+	dpxAdcEventQueueHead = 0;
+	dpxAdcEventQueueCount = 0;
+	dpxAdcEventsDropped = 0;
+	dpxAdcEventReadAddrValid = 0;
+}
+
+
+// Run the event triggers over a block of timetagged ADC buffer data which has already been copied to the host.
+// Buffer layout and channels[] are the same as for DPxDecodeAdcBuff().
+// Successive calls must pass successive blocks of the same stream.
+// Returns the number of events added to the queue.
+int DPxProcessAdcEvents(void* buffer, int nFrames, int nChans, int* channels)
+{
+	const unsigned char* bytePtr = (const unsigned char*)buffer;
+	int frameBytes = (nChans + 4) * 2;
+	int nEvents = dpxAdcEventQueueCount, nBlockFrames;
+
+	if (nFrames < 0 || nChans < 1 || nChans > DPX_ADC_NCHANS) {
+		DPxDebugPrint2("ERROR: DPxProcessAdcEvents() arguments nFrames %d and nChans %d out of range\n", nFrames, nChans);
+		DPxSetError(DPX_ERR_ADC_DECODE_BAD_ARGS);
+		return 0;
+	}
+	if (!buffer && nFrames) {
+		DPxDebugPrint0("ERROR: DPxProcessAdcEvents() argument buffer is null\n");
+		DPxSetError(DPX_ERR_ADC_DECODE_NULL_PTR);
+		return 0;
+	}
+
+	while (nFrames) {
+		nBlockFrames = nFrames < DPX_ADC_EVENT_BLOCK_FRAMES ? nFrames : DPX_ADC_EVENT_BLOCK_FRAMES;
+		DPxDetectAdcEventsBlock(bytePtr, nBlockFrames, nChans, channels);
+		bytePtr += nBlockFrames * frameBytes;
+		nFrames -= nBlockFrames;
+	}
+	return dpxAdcEventQueueCount - nEvents;
+}
+
+
+// Read all new datasets which the running ADC schedule has written to RAM since the last call, and run the event triggers over them.
+// The ADC schedule must log timetags.  The buffered channels are taken from DPxIsAdcBuffChan().
+// Does a DPxUpdateRegCache() to get the current ADC buffer write address.
+// Returns the number of events added to the queue.
+int DPxPollAdcEvents()
+{
+	int channels[DPX_ADC_NCHANS];
+	int nChans = 0, iChan, nEvents = dpxAdcEventQueueCount;
+	int prevError = DPxGetError();
+	unsigned baseAddr, buffSize, writeAddr, frameBytes, availBytes, chunkBytes, part1Bytes;
+
+	// Only stop for errors raised during this call; the error left by an earlier call is restored on success
+	DPxClearError();
+	DPxUpdateRegCache();
+	if (DPxGetError() != DPX_SUCCESS)
+		return 0;
+	if (!DPxIsAdcLogTimetags()) {
+		DPxDebugPrint0("ERROR: DPxPollAdcEvents() requires ADC timetag logging\n");
+		DPxSetError(DPX_ERR_ADC_EVENT_NO_TIMETAGS);
+		return 0;
+	}
+	for (iChan = 0; iChan < DPX_ADC_NCHANS; iChan++)
+		if (DPxIsAdcBuffChan(iChan))
+			channels[nChans++] = iChan;
+	if (!nChans) {
+		DPxSetError(prevError);
+		return 0;
+	}
+
+	frameBytes = (nChans + 4) * 2;
+	baseAddr = DPxGetAdcBuffBaseAddr();
+	buffSize = DPxGetAdcBuffSize();
+	writeAddr = DPxGetAdcBuffWriteAddr();
+	if (!dpxAdcEventReadAddrValid) {
+		dpxAdcEventReadAddr = baseAddr;
+		dpxAdcEventReadAddrValid = 1;
+	}
+	if (!buffSize) {
+		DPxSetError(prevError);
+		return 0;
+	}
+
+	// Only whole datasets are treated; the remainder is picked up by the next call.
+	// The buffer wraps after buffSize bytes, so a chunk can come from the end and the start of the buffer.
+	availBytes = (writeAddr + buffSize - dpxAdcEventReadAddr) % buffSize;
+	availBytes -= availBytes % frameBytes;
+	while (availBytes) {
+		chunkBytes = sizeof(dpxAdcEventRaw) - sizeof(dpxAdcEventRaw) % frameBytes;
+		if (chunkBytes > availBytes)
+			chunkBytes = availBytes;
+		part1Bytes = baseAddr + buffSize - dpxAdcEventReadAddr;
+		if (part1Bytes > chunkBytes)
+			part1Bytes = chunkBytes;
+		DPxReadRam(dpxAdcEventReadAddr, part1Bytes, dpxAdcEventRaw);
+		if (chunkBytes > part1Bytes)
+			DPxReadRam(baseAddr, chunkBytes - part1Bytes, dpxAdcEventRaw + part1Bytes);
+		if (DPxGetError() != DPX_SUCCESS)
+			break;
+		DPxDetectAdcEventsBlock(dpxAdcEventRaw, chunkBytes / frameBytes, nChans, channels);
+		dpxAdcEventReadAddr += chunkBytes;
+		if (dpxAdcEventReadAddr >= baseAddr + buffSize)
+			dpxAdcEventReadAddr -= buffSize;
+		availBytes -= chunkBytes;
+	}
+	if (DPxGetError() == DPX_SUCCESS)
+		DPxSetError(prevError);
+	return dpxAdcEventQueueCount - nEvents;
+}
+
+
+// Number of events waiting in the queue
+int DPxGetNumAdcEvents()
+{
+	return dpxAdcEventQueueCount;
+}
+
+
+// Remove the oldest event from the queue.
+// Returns 0 if the queue is empty, otherwise fills in the ADC channel, the DPX_ADC_EVENT_RISING/FALLING edge, and the interpolated time in seconds.
+// Any of the pointers can be null.
+int DPxGetAdcEvent(int* channel, int* edge, double* timeSecs)
+{
+	DPxAdcEvent* event;
+
+	if (!dpxAdcEventQueueCount)
+		return 0;
+	event = &dpxAdcEventQueue[dpxAdcEventQueueHead];
+	if (channel)
+		*channel = event->channel;
+	if (edge)
+		*edge = event->edge;
+	if (timeSecs)
+		*timeSecs = event->timeSecs;
+	dpxAdcEventQueueHead = (dpxAdcEventQueueHead + 1) % DPX_ADC_EVENT_QUEUE_SIZE;
+	dpxAdcEventQueueCount--;
+	return 1;
+}
+
+
+// Number of events dropped because the queue was full, since the last DPxResetAdcEvents()
+unsigned DPxGetAdcEventsDropped()
+{
+	return dpxAdcEventsDropped;
+}
+
+
+/********************************************************************************/
+/*																				*/
+/*	DOUT (Digital Output) Subsystem												*/
+/*																				*/
+/********************************************************************************/
+
+
+// Returns number of digital output bits in system (24 in current implementation)
+int DPxGetDoutNumBits()
+{
+	return 24;
+}
+
+
+// For each of the 24 bits set in bitMask, set the DOUT to the value in the corresponding bitValue.
+void DPxSetDoutValue(int bitValue, int bitMask)
+{
+	// If user specified unimplemented bits, it's not a fatal error so don't return.
+	// At least set the implemented bits.
+	if (bitMask & 0xFF000000) {
+		DPxDebugPrint2("ERROR: DPxSetDoutValue() argument bitMask %08X includes unimplemented bits %08X\n", bitMask, bitMask & 0xFF000000);
+		DPxSetError(DPX_ERR_DOUT_SET_BAD_MASK);
+	}
+
+	// Internally, the 24 DOUT bits are implemented as a single 32-bit register.
+	// Note that a user write, and a schedule, can step over each other.
+	if (bitMask)
+		DPxSetReg32(DPXREG_DOUT_DATA_L, (DPxGetReg32(DPXREG_DOUT_DATA_L) & ~bitMask) | (bitValue & bitMask));
+}
+
+
+// Get the values of the 24 DOUT bits
+int DPxGetDoutValue()
+{
+	return DPxGetReg32(DPXREG_DOUT_DATA_L);
+}
+
+
+// Enable automatic DOUT schedules upon DIN button presses
+void DPxEnableDoutButtonSchedules()
+{
+	DPxSetReg16(DPXREG_DOUT_CTRL, DPxGetReg16(DPXREG_DOUT_CTRL) | DPXREG_DOUT_CTRL_BUTTON_SCHEDULES);
+}
+
+
+// Disable automatic DOUT schedules upon DIN button presses
+void DPxDisableDoutButtonSchedules()
+{
+	DPxSetReg16(DPXREG_DOUT_CTRL, DPxGetReg16(DPXREG_DOUT_CTRL) & ~DPXREG_DOUT_CTRL_BUTTON_SCHEDULES);
+}
+
+
+// Returns non-0 if automatic DOUT schedules occur upon DIN button presses
+int DPxIsDoutButtonSchedules()
+{
+	return DPxGetReg16(DPXREG_DOUT_CTRL) & DPXREG_DOUT_CTRL_BUTTON_SCHEDULES;
+}
+
+
+// Set DOUT RAM buffer start address.  Must be an even value.
+void DPxSetDoutBuffBaseAddr(unsigned buffBaseAddr)
+{
+	if (buffBaseAddr & 1) {
+		DPxDebugPrint1("ERROR: DPxSetDoutBuffBaseAddr(0x%x) illegal odd address\n", buffBaseAddr);
+		DPxSetError(DPX_ERR_DOUT_BUFF_ODD_BASEADDR);
+		return;
+	}
+	if (buffBaseAddr >= DPxGetRamSize()) {
+		DPxDebugPrint1("ERROR: DPxSetDoutBuffBaseAddr(0x%x) exceeds DATAPixx RAM\n", buffBaseAddr);
+		DPxSetError(DPX_ERR_DOUT_BUFF_BASEADDR_TOO_HIGH);
+		return;
 	}
 	DPxSetReg32(DPXREG_DOUT_BUFF_BASEADDR_L, buffBaseAddr);
 }
@@ -4904,6 +5735,38 @@ int DPxIsDinLogEvents()
 }
 
 
+// Decode a block of DIN RAM buffer data, which has been copied to the host with DPxReadRam().
+// The buffer holds nFrames datasets, each with an optional 64-bit timetag followed by one 16-bit DIN value.
+// timeSecs receives nFrames timetags in seconds, and can be null (it is ignored if timetagged is 0).
+// dinValues receives nFrames DIN values, and can be null.
+void DPxDecodeDinBuff(void* buffer, int nFrames, int timetagged, double* timeSecs, UInt16* dinValues)
+{
+	const unsigned char* bytePtr = (const unsigned char*)buffer;
+	int frameBytes, iFrame;
+
+	if (nFrames < 0) {
+		DPxDebugPrint1("ERROR: DPxDecodeDinBuff() argument nFrames %d is negative\n", nFrames);
+		DPxSetError(DPX_ERR_DIN_DECODE_BAD_ARGS);
+		return;
+	}
+	if (!buffer && nFrames) {
+		DPxDebugPrint0("ERROR: DPxDecodeDinBuff() argument buffer is null\n");
+		DPxSetError(DPX_ERR_DIN_DECODE_NULL_PTR);
+		return;
+	}
+
+	frameBytes = timetagged ? 10 : 2;
+	if (timetagged) {
+		if (timeSecs)
+			DPxDecodeTimetags(bytePtr, frameBytes, nFrames, timeSecs);
+		bytePtr += 8;
+	}
+	if (dinValues)
+		for (iFrame = 0; iFrame < nFrames; iFrame++)
+			dinValues[iFrame] = DPxDecodeWord(bytePtr + iFrame * frameBytes);
+}
+
+
 /********************************************************************************/
 /*																				*/
 /*	TOUCHPixx Subsystem															*/
@@ -6435,6 +7298,77 @@ void DPxSetVidCluts(UInt16* clutData)
 }
 
 
+// Append composite USB message to write a video CLUT.
+// nEntries is 256 for DPxSetVidClut() format data, or 512 for DPxSetVidCluts() format data.
+// Like DPxSetVidClut(), the new CLUT is implemented at the next vertical blanking interval.
+void DPxBuildUsbMsgVidClut(UInt16* clutData, int nEntries)
+{
+	*dpxBuildUsbMsgPtr++ = (EP2OUT_WRITECLUT << 8) + '^';	// Tram header for a CLUT write
+	*dpxBuildUsbMsgPtr++ = nEntries * 3 * 2;				// payload contains 16-bit RGB CLUT entries
+	memcpy(dpxBuildUsbMsgPtr, clutData, nEntries * 3 * 2);
+	dpxBuildUsbMsgPtr += nEntries * 3;
+}
+
+
+// Play a precomputed sequence of video CLUTs, one per video frame.
+// clutData holds nFrames consecutive CLUTs of nEntries (256 or 512) RGB entries each, in DPxSetVidClut()/DPxSetVidCluts() order.
+// Each CLUT goes out in its own USB message, which the DATAPixx holds until the leading edge of vertical sync.
+// The message also latches the nanosecond marker and reads back the registers,
+// so the host only sends CLUT n+1 once CLUT n has been treated, and the DATAPixx always paces the sequence.
+// frameTimes (can be null) receives the device time in seconds at which each CLUT was treated.
+// frameSlips (can be null) receives the number of video frames which were skipped just before each CLUT;
+// this is normally 0, and is non-0 when the host did not send a CLUT in time for its vertical sync.
+// Returns the number of late CLUTs, or -1 if the sequence could not be played.
+// Only errors raised by this call make it fail; otherwise the error code left by an earlier call is kept.
+int DPxPlayVidClutSequence(UInt16* clutData, int nFrames, int nEntries, double* frameTimes, int* frameSlips)
+{
+	double frameTime, lastFrameTime = 0, vPeriod;
+	int iFrame, nSlips, nLate = 0;
+	int prevError;
+
+	if (!clutData || nFrames < 1 || (nEntries != 256 && nEntries != 512)) {
+		DPxDebugPrint2("ERROR: DPxPlayVidClutSequence() bad arguments nFrames %d, nEntries %d\n", nFrames, nEntries);
+		DPxSetError(DPX_ERR_VID_CLUT_SEQ_BAD_ARGS);
+		return -1;
+	}
+
+	prevError = DPxGetError();
+	DPxClearError();
+	vPeriod = DPxGetVidVPeriod() * 1.0e-9;
+	for (iFrame = 0; iFrame < nFrames; iFrame++) {
+		DPxBuildUsbMsgBegin();
+		DPxBuildUsbMsgVideoSync();
+		if (DPxGetError() != DPX_SUCCESS)
+			return -1;
+		DPxSetMarker();
+		DPxBuildUsbMsgWriteRegs();
+		DPxBuildUsbMsgVidClut(clutData + iFrame * nEntries * 3, nEntries);
+		DPxBuildUsbMsgReadRegs();
+		DPxBuildUsbMsgEnd();
+		if (DPxGetError() != DPX_SUCCESS) {
+			DPxDebugPrint1("ERROR: DPxPlayVidClutSequence() failed to send CLUT %d\n", iFrame);
+			DPxSetError(DPX_ERR_VID_CLUT_WRITE_USB_ERROR);
+			return -1;
+		}
+
+		// A gap of more than 1.5 frame periods since the previous CLUT means that at least one vertical sync went by without a new CLUT
+		frameTime = DPxGetMarker();
+		nSlips = 0;
+		if (iFrame && vPeriod > 0 && frameTime - lastFrameTime > 1.5 * vPeriod) {
+			nSlips = (int)floor((frameTime - lastFrameTime) / vPeriod + 0.5) - 1;
+			nLate++;
+		}
+		if (frameTimes)
+			frameTimes[iFrame] = frameTime;
+		if (frameSlips)
+			frameSlips[iFrame] = nSlips;
+		lastFrameTime = frameTime;
+	}
+	DPxSetError(prevError);
+	return nLate;
+}
+
+
 // VGA 1 shows left half of video image, VGA 2 shows right half of video image
 void DPxEnableVidHorizSplit()
 {
@@ -6534,11 +7468,30 @@ void DPxGetVidHorizOverlayBounds(int* X1, int* Y1, int* X2, int* Y2)
 }
 
 
-// Set 1024 16-bit video alpha values, in order X0,X1..X511,Y0,Y1...Y511
+// Returns non-0 if alphaData is identical to the alpha table last written to the DATAPixx
+static int DPxIsVidHorizOverlayAlphaCurrent(UInt16* alphaData)
+{
+	return dpxVidAlphaShadowValid && !memcmp(dpxVidAlphaShadow, alphaData, sizeof(dpxVidAlphaShadow));
+}
+
+
+// Remember the alpha table which has just been written to the DATAPixx
+static void DPxSetVidHorizOverlayAlphaShadow(UInt16* alphaData)
+{
+	memcpy(dpxVidAlphaShadow, alphaData, sizeof(dpxVidAlphaShadow));
+	dpxVidAlphaShadowValid = 1;
+}
+
+
+// Set 1024 16-bit video alpha values, in order X0,X1..X511,Y0,Y1...Y511.
+// A table identical to the one last written is not sent again.
 void DPxSetVidHorizOverlayAlpha(UInt16* alphaData)
 {
 	int payloadLength = 2048;
 
+	if (DPxIsVidHorizOverlayAlphaCurrent(alphaData))
+		return;
+
 	ep2out_Tram[0] = '^';
 	ep2out_Tram[1] = EP2OUT_WRITEALPHA;
 	ep2out_Tram[2] = LSB(payloadLength);
@@ -6547,7 +7500,54 @@ void DPxSetVidHorizOverlayAlpha(UInt16* alphaData)
 	if (EZWriteEP2Tram(ep2out_Tram, 0, 0)) {
 		DPxDebugPrint0("ERROR: DPxSetVidHorizOverlayAlpha() call to EZWriteEP2Tram() failed\n");
 		DPxSetError(DPX_ERR_VID_ALPHA_WRITE_USB_ERROR);
+		dpxVidAlphaShadowValid = 0;
+		return;
+	}
+	DPxSetVidHorizOverlayAlphaShadow(alphaData);
+}
+
+
+// Append composite USB message to write the 1024 video horizontal overlay alpha values
+void DPxBuildUsbMsgVidHorizOverlayAlpha(UInt16* alphaData)
+{
+	*dpxBuildUsbMsgPtr++ = (EP2OUT_WRITEALPHA << 8) + '^';	// Tram header for an alpha table write
+	*dpxBuildUsbMsgPtr++ = 2048;							// payload contains 1024 16-bit alpha values
+	memcpy(dpxBuildUsbMsgPtr, alphaData, 2048);
+	dpxBuildUsbMsgPtr += 1024;
+}
+
+
+// Frame-locked horizontal overlay update.
+// Writes the modified registers (eg: from DPxSetVidHorizOverlayBounds()) and the alpha table in one USB message,
+// which the DATAPixx holds until the leading edge of vertical sync, so bounds and alpha change together between two frames.
+// Like DPxWriteRegCacheAfterVideoSync(), this routine returns quickly, so it can be called right before a buffer swap.
+// The alpha table is only sent if alphaData is non-null and differs from the table last written.
+// Returns non-0 if the alpha table was sent.
+// Only errors raised by this call make it fail; otherwise the error code left by an earlier call is kept.
+int DPxWriteVidHorizOverlayAfterVideoSync(UInt16* alphaData)
+{
+	int sendAlpha = alphaData && !DPxIsVidHorizOverlayAlphaCurrent(alphaData);
+	int prevError = DPxGetError();
+
+	DPxClearError();
+	DPxBuildUsbMsgBegin();
+	DPxBuildUsbMsgVideoSync();
+	if (DPxGetError() != DPX_SUCCESS)
+		return 0;
+	DPxBuildUsbMsgWriteRegs();
+	if (sendAlpha)
+		DPxBuildUsbMsgVidHorizOverlayAlpha(alphaData);
+	DPxBuildUsbMsgEnd();
+	if (DPxGetError() != DPX_SUCCESS) {
+		DPxDebugPrint0("ERROR: DPxWriteVidHorizOverlayAfterVideoSync() failed to send USB message\n");
+		DPxSetError(DPX_ERR_VID_ALPHA_WRITE_USB_ERROR);
+		dpxVidAlphaShadowValid = 0;
+		return 0;
 	}
+	if (sendAlpha)
+		DPxSetVidHorizOverlayAlphaShadow(alphaData);
+	DPxSetError(prevError);
+	return sendAlpha;
 }
 
 
@@ -6887,606 +7887,952 @@ void DPxStopAllScheds()
 }
 
 
-typedef struct {
-    UInt16          ctrl;       // 15:Unused, 14:DE, 13:HSync, 12:VSync, 11-8:BlueLSB, 7-4:GreenLSB, 3-0:RedLSB
-    unsigned char   redE;
-    unsigned char   greenE;
-    unsigned char   blueE;
-    unsigned char   redO;
-    unsigned char   greenO;
-    unsigned char   blueO;
-} ScopePixel;
-
-// VScope video timing bit locations
-#define SCOPE_CTRL_DE       0x4000
-#define SCOPE_CTRL_HSYNC    0x2000
-#define SCOPE_CTRL_VSYNC    0x1000
+/********************************************************************************/
+/*																				*/
+/*	Schedule groups																*/
+/*																				*/
+/********************************************************************************/
 
-#define N_SCOPE_TEST_FRAMES 10
-#define MAX_SCOPE_HMSGS     20
-#define SCOPE_BUFF_SIZE ((165000000/120)*(N_SCOPE_TEST_FRAMES+2))      // Make sure we read in enough data to get all the frames we need, even under bizarre video format problems.
-ScopePixel scopePixelBuff[SCOPE_BUFF_SIZE]; 
 
-FILE *fpVScope;
-    
-static void PrintScopePixels(int inBuffIndex, int nPixels);
-void DPxVideoScope(int toFile)
+// Convert a DPX_SCHED_GROUP_* mask into DPXREG_SCHED_STARTSTOP command bits.
+// Bit i of the mask maps onto the 2-bit field at DPXREG_SCHED_STARTSTOP shift 2*i.
+static int DPxSchedGroupStartStopBits(int schedMask, int command)
 {
-    char *displayName;
-
-    int regVidCtrl2;
-    int timHActive, timHBl, timHFp, timHSync, timHBp, timHTotal, timVActive, timVBl, timVFp, timVSync, timVTotal, timFTotal;    
-    int i, j, k;
-    int inVBlank, vFrameEnd, vFrame, vFrameMin, vFrameMax, nVFrame, nVFrameErrors;
-    int hActiveStart, hActiveEnd, hActive, hActiveMin, hActiveMax, nHActive, nHActiveErrors;
-    int hFPEnd, hFP, hFPMin, hFPMax, nHFP, nHFPErrors;
-    int hSyncEnd, hSync, hSyncMin, hSyncMax, nHSync, nHSyncErrors;
-    int hBPEnd, hBP, hBPMin, hBPMax, nHBP, nHBPErrors;
-    int hTotalEnd, hTotal, hTotalMin, hTotalMax, nHTotal, nHTotalErrors;
-    double hActiveSum, hFPSum, hSyncSum, hBPSum, hTotalSum, vFrameSum;
-    int hLineNumber, hLastErrorLine, enableHMessages, hMsgNumber;
-    int yCoord;
-    UInt16* vidLineData;
-    int vertState, lineIsActive, vertLineCount, vertFpStartLine, vertSyncStartLine, vertBpStartLine;
-    int vertFp, vertSync, vertBp, vertFpMin, vertFpMax, vertSyncMin, vertSyncMax, vertBpMin, vertBpMax;
-    int i2, vSyncStartPhase, vSyncStartPhaseMin, vSyncStartPhaseMax, vSyncEndPhase, vSyncEndPhaseMin, vSyncEndPhaseMax;
-    double hiddenRed, hiddenGrn, hiddenBlu;
-
-    // Get expected video characteristics
-    if (DPxIsViewpixx3D()) {
-        displayName = "VIEWPixx3D";
-        timHActive  = 1920 / 2;
-        timHBl      = 80 / 2;
-        timHFp      = 16 / 2;
-        timHSync    = 32 / 2;
-        timVActive  = 1080;
-        timVBl      = DPxGetReg16(DPXREG_VID_VTOTAL) < 1080 + (212+470)/2 ? 212 : 470;  // OS could be running us at 100Hz or 120Hz
-        timVFp      = 3;
-        timVSync    = 6;
-    }
-    else if (DPxIsViewpixx()) {
-        displayName = "VIEWPixx";
-        timHActive  = 1920 / 2;
-        timHBl      = 160 / 2;
-        timHFp      = 48 / 2;
-        timHSync    = 32 / 2;
-        timVActive  = 1200;
-        timVBl      = DPxGetReg16(DPXREG_VID_VTOTAL) < 1200 + (35+281)/2 ? 35 : 281;  // OS could be running us at 100Hz or 120Hz
-        timVFp      = 3;
-        timVSync    = 6;
-    }
-    else if (DPxIsPropixx()) {
-        displayName = "PROPixx";
-        timHActive  = 1920 / 2;
-        timHBl      = 280 / 2;
-        timHFp      = 88 / 2;
-        timHSync    = 40 / 2;
-        timVActive  = 1080;
-        timVBl      = 47;
-        timVFp      = 3;
-        timVSync    = 6;
-    }
-    else {
-        printf("ERROR: Unknown display type\n");
-        return;
-    }
+	int iSched, bits = 0;
 
-#if 1
-    displayName = "VIEWPixx3D";
-    timHActive  = 1920 / 2;
-    timHBl      = 160 / 2;
-    timHFp      = 64 / 2;
-    timHSync    = 32 / 2;
-    timVActive  = 1080;
-    timVBl      = 202;
-    timVFp      = 2;
-    timVSync    = 2;
-#endif
-    
-    timHBp      = timHBl - timHFp - timHSync;
-    timHTotal   = timHActive + timHBl;
-    timVTotal   = timVActive + timVBl;
-    timFTotal   = timHTotal * timVTotal;    
+	for (iSched = 0; iSched < 7; iSched++)
+		if (schedMask & (1 << iSched))
+			bits |= command << (iSched * 2);
+	return bits;
+}
 
-    if (toFile)
-        fpVScope = fopen("listing.txt", "wt");
-    else
-        fpVScope = stdout;
-    
-    inVBlank        = 0;
-    vFrameEnd       = 0;
-    vFrameMin       = 0x7FFFFFFF;
-    vFrameMax       = -1;
-    nVFrame         = 0;
-    nVFrameErrors   = 0;
-    vFrameSum       = 0;
-
-    hActiveStart    = 0;
-    hActiveEnd      = 0;
-    hActiveMin      = 0x7FFFFFFF;
-    hActiveMax      = -1;
-    nHActive        = 0;
-    nHActiveErrors  = 0;
-    hActiveSum      = 0;
-
-    hFPEnd          = 0;
-    hFPMin          = 0x7FFFFFFF;
-    hFPMax          = -1;
-    nHFP            = 0;
-    nHFPErrors      = 0;
-    hFPSum          = 0;
-
-    hSyncEnd        = 0;
-    hSyncMin        = 0x7FFFFFFF;
-    hSyncMax        = -1;
-    nHSync          = 0;
-    nHSyncErrors    = 0;
-    hSyncSum        = 0;
-
-    hBPEnd          = 0;
-    hBPMin          = 0x7FFFFFFF;
-    hBPMax          = -1;
-    nHBP            = 0;
-    nHBPErrors      = 0;
-    hBPSum          = 0;
-
-    hTotalEnd       = 0;
-    hTotalMin       = 0x7FFFFFFF;
-    hTotalMax       = -1;
-    nHTotal         = 0;
-    nHTotalErrors   = 0;
-    hTotalSum       = 0;
-
-    hLineNumber     = 0;
-    hLastErrorLine  = -1;
-    hMsgNumber       = 0;
-    enableHMessages  = 1;
-
-    yCoord = 0;
-
-    vertState = 0;
-    lineIsActive = 0;
-    vertLineCount = 0;
-    vertFpMin = 1000000;
-    vertFpMax = -1;
-    vertSyncMin = 1000000;
-    vertSyncMax = -1;
-    vertBpMin = 1000000;
-    vertBpMax = -1;
-
-    vSyncStartPhaseMin = 1000000000;
-    vSyncStartPhaseMax = -1;
-    vSyncEndPhaseMin = 1000000000;
-    vSyncEndPhaseMax = -1;
-
-    hiddenRed = 0.0;
-    hiddenGrn = 0.0;
-    hiddenBlu = 0.0;
-
-    // Pixel drive will clobber VScope, so turn it off
-    regVidCtrl2 = DPxGetReg16(DPXREG_VID_CTRL2);
-    DPxSetReg16(DPXREG_VID_CTRL2, regVidCtrl2 & !(DPXREG_VID_CTRL2_PIXELDRIVE | DPXREG_VID_CTRL2_PIXELDRIVE_ACCUM));
-    DPxUpdateRegCache();
-    
-    // Initiate frame grab
-    DPxSetReg16(DPXREG_VID_SCOPE, 1);
-    DPxUpdateRegCache();
 
-    // Wait until frame grab done
-    do {
-        DPxUpdateRegCache();
-    } while (DPxGetReg16(DPXREG_VID_SCOPE));
+// Return non-0 if schedMask is a non-empty combination of DPX_SCHED_GROUP_* flags
+static int DPxIsSchedGroupMaskValid(int schedMask, const char* caller)
+{
+	if (!schedMask || (schedMask & ~DPX_SCHED_GROUP_ALL)) {
+		DPxDebugPrint2("ERROR: %s() unrecognized schedMask 0x%x\n", caller, schedMask);
+		DPxSetError(DPX_ERR_SCHED_GROUP_BAD_MASK);
+		return 0;
+	}
+	return 1;
+}
 
-    // Get buffer
-    DPxReadRam(0, sizeof(scopePixelBuff), scopePixelBuff);
-    
-    // Restore normal operation
-    DPxSetReg16(DPXREG_VID_CTRL2, regVidCtrl2);
-    DPxUpdateRegCache();
 
-    // Get first video line from line grabber
-    vidLineData = DPxGetVidLine();
+// Set the start bits for all schedules in schedMask.
+// Start bits for other schedules which are already pending in the local cache are preserved,
+// so the group goes out with the next register write, in the same write as any pending DPxStart*Sched().
+void DPxSetSchedGroupStart(int schedMask)
+{
+	int bits;
 
-    // Parse the buffer
-    for (i = 0; nVFrame < N_SCOPE_TEST_FRAMES; i++) {
+	if (!DPxIsSchedGroupMaskValid(schedMask, "DPxSetSchedGroupStart"))
+		return;
+	bits = DPxSchedGroupStartStopBits(schedMask, DPXREG_SCHED_STARTSTOP_START);
+	DPxSetReg16(DPXREG_SCHED_STARTSTOP, (DPxGetReg16(DPXREG_SCHED_STARTSTOP) & ~DPxSchedGroupStartStopBits(schedMask, DPXREG_SCHED_STARTSTOP_MASK)) | bits);
+	if (schedMask & DPX_SCHED_GROUP_AUX)
+		DPxSetCodecReg(58, 0x09);	// As in DPxStartAuxSched(), HPLCOM is powered down after Init().  Make sure it's on now.
+}
 
-        // Did we reach the end of our buffer without finding the desired number of video frames?
-        if (i >= SCOPE_BUFF_SIZE) {
-            if (nVFrame == 0) {
-                fprintf(fpVScope, "***ERROR: No VSYNC found.  Is %s connected to video source?\n", displayName);
-                goto end;
-            }
-            else {
-                fprintf(fpVScope, "***ERROR: Only %d of %d VSYNC found in buffer.\n", nVFrame, N_SCOPE_TEST_FRAMES);
-                goto end;
-            }
-        }        
-        
-        // We will use the convention that the first active pixel after vertical blanking is the start of a video frame, and the start of a video line
-        if (scopePixelBuff[i].ctrl & SCOPE_CTRL_VSYNC)
-            inVBlank = 1;
-        if (inVBlank && (scopePixelBuff[i+1].ctrl & SCOPE_CTRL_DE)) {   // We're in the last VBL pixel before a new frame
-            inVBlank = 0;
-            yCoord = 0;
-            if (vFrameEnd == 0) {   // Will this be the first frame we analyze?
-                fprintf(fpVScope, "First frame starts at address 0x%x\n", (unsigned int)((i+1)*sizeof(ScopePixel)));
-                vFrameEnd = i;
-                hTotalEnd = i;      // So that first video line can calculate HTOTAL
-                continue;           // Don't process last pixel in VBL
-            }
-            else {                  // This is not the first frame we process, so we can do frame length analysis
-                vFrame = i - vFrameEnd;
-                vFrameSum += vFrame;
-                nVFrame++;
-                if (vFrame != timFTotal) {
-                    nVFrameErrors++;
-                    fprintf(fpVScope, "***ERROR: Frame %d FTOTAL[nom=%d] = %d\n", nVFrame, timFTotal, vFrame);
-                }
-                if (vFrameMin > vFrame)
-                    vFrameMin = vFrame;
-                if (vFrameMax < vFrame)
-                    vFrameMax = vFrame;
-                vFrameEnd = i;
-            }
-        }
 
-        // We will not do any more processing of the buffer data until we have found the first frame start
-        if (!vFrameEnd)
-            continue;
-
-        // We are adding simplified calculation of vertical timing, updated on leading edge of each HSYNC
-        if ((scopePixelBuff[i].ctrl & SCOPE_CTRL_HSYNC) && !(scopePixelBuff[i-1].ctrl & SCOPE_CTRL_HSYNC)) {
-            vertLineCount++;
-            lineIsActive = scopePixelBuff[i-480].ctrl & SCOPE_CTRL_DE;  // 200 has to be 
-            switch (vertState) {
-                case 0: // Startup, waiting for active video before beginning processing
-                    if (lineIsActive)
-                        vertState = 1;
-                    break;
-                    
-                case 1:     // In active region, waiting for start of VBL
-                    if (!lineIsActive) {
-                        vertFpStartLine = vertLineCount;
-                        vertState = 2;
-                    }
-                    else    // Don't break if in VFP, in case VFP = 0
-                        break;
-                    
-                case 2:     // In vertical front porch, waiting for VSYNC
-                    if (scopePixelBuff[i-100].ctrl & SCOPE_CTRL_VSYNC) {
-                        vertSyncStartLine = vertLineCount;
-                        vertState = 3;
-                    }
-                    break;
-                    
-                case 3:     // In vertical sync, waiting for vertical back porch
-                    if (!(scopePixelBuff[i-100].ctrl & SCOPE_CTRL_VSYNC)) {
-                        vertBpStartLine = vertLineCount;
-                        vertState = 4;
-                    }
-                    else    // Don't break if going into VBP, in case VBP = 0
-                        break;
-                    
-                case 4:     // In vertical back porch, waiting for active
-                    if (lineIsActive) {
-                        vertFp = vertSyncStartLine - vertFpStartLine;
-                        vertSync = vertBpStartLine - vertSyncStartLine;
-                        vertBp = vertLineCount - vertBpStartLine;
-                        if (vertFpMin > vertFp)
-                            vertFpMin = vertFp;
-                        if (vertFpMax < vertFp)
-                            vertFpMax = vertFp;
-                        if (vertSyncMin > vertSync)
-                            vertSyncMin = vertSync;
-                        if (vertSyncMax < vertSync)
-                            vertSyncMax = vertSync;
-                        if (vertBpMin > vertBp)
-                            vertBpMin = vertBp;
-                        if (vertBpMax < vertBp)
-                            vertBpMax = vertBp;
-                        vertState = 1;
-                    }
-                    break;
-            }
+// Set the stop bits for all schedules in schedMask
+void DPxSetSchedGroupStop(int schedMask)
+{
+	int bits;
 
-            lineIsActive = 0;   // Reset for active test for next line
-        }
-        else if (scopePixelBuff[i].ctrl & SCOPE_CTRL_DE)    // Detect if line leading up to HSYNC is active
-            lineIsActive = 1;
-
-        // What's the phase relationship between VSYNC and HSYNC
-        if ((scopePixelBuff[i].ctrl & SCOPE_CTRL_VSYNC) && !(scopePixelBuff[i-1].ctrl & SCOPE_CTRL_VSYNC)) {
-            for (i2 = i; i2 > 0; i2--) {
-                if ((scopePixelBuff[i2].ctrl & SCOPE_CTRL_HSYNC) && !(scopePixelBuff[i2-1].ctrl & SCOPE_CTRL_HSYNC)) {
-                    vSyncStartPhase = i - i2;
-                    printf("vSyncStartPhase = %d, i = %d, i2 = %d\n", vSyncStartPhase, i, i2);
-                    if (vSyncStartPhaseMin > vSyncStartPhase)
-                        vSyncStartPhaseMin = vSyncStartPhase;
-                    if (vSyncStartPhaseMax < vSyncStartPhase)
-                        vSyncStartPhaseMax = vSyncStartPhase;
-                    break;
-                }
-            }
-        }
-        else if (!(scopePixelBuff[i].ctrl & SCOPE_CTRL_VSYNC) && (scopePixelBuff[i-1].ctrl & SCOPE_CTRL_VSYNC)) {
-            for (i2 = i; i2 > 0; i2--) {
-                if ((scopePixelBuff[i2].ctrl & SCOPE_CTRL_HSYNC) && !(scopePixelBuff[i2-1].ctrl & SCOPE_CTRL_HSYNC)) {
-                    vSyncEndPhase = i - i2;
-                    if (vSyncEndPhaseMin > vSyncEndPhase)
-                        vSyncEndPhaseMin = vSyncEndPhase;
-                    if (vSyncEndPhaseMax < vSyncEndPhase)
-                        vSyncEndPhaseMax = vSyncEndPhase;
-                    break;
-                }
-            }
-        }
+	if (!DPxIsSchedGroupMaskValid(schedMask, "DPxSetSchedGroupStop"))
+		return;
+	bits = DPxSchedGroupStartStopBits(schedMask, DPXREG_SCHED_STARTSTOP_STOP);
+	DPxSetReg16(DPXREG_SCHED_STARTSTOP, (DPxGetReg16(DPXREG_SCHED_STARTSTOP) & ~DPxSchedGroupStartStopBits(schedMask, DPXREG_SCHED_STARTSTOP_MASK)) | bits);
+}
 
-        // Report non-zero RGB data received during blanking
-        if (!(scopePixelBuff[i].ctrl & SCOPE_CTRL_DE) && scopePixelBuff[i].redE)
-            hiddenRed++;
-        if (!(scopePixelBuff[i].ctrl & SCOPE_CTRL_DE) && scopePixelBuff[i].redO)
-            hiddenRed++;
-        if (!(scopePixelBuff[i].ctrl & SCOPE_CTRL_DE) && scopePixelBuff[i].greenE)
-            hiddenGrn++;
-        if (!(scopePixelBuff[i].ctrl & SCOPE_CTRL_DE) && scopePixelBuff[i].greenO)
-            hiddenGrn++;
-        if (!(scopePixelBuff[i].ctrl & SCOPE_CTRL_DE) && scopePixelBuff[i].blueE)
-            hiddenBlu++;
-        if (!(scopePixelBuff[i].ctrl & SCOPE_CTRL_DE) && scopePixelBuff[i].blueO)
-            hiddenBlu++;
-
-        // Detect start of Horizontal Active.
-        if (!(scopePixelBuff[i-1].ctrl & SCOPE_CTRL_DE) && (scopePixelBuff[i].ctrl & SCOPE_CTRL_DE))
-            hActiveStart = i;
-
-        // Horizontal Active.
-        if ((scopePixelBuff[i].ctrl & SCOPE_CTRL_DE) && !(scopePixelBuff[i+1].ctrl & SCOPE_CTRL_DE)) {
-            hActiveEnd = i;
-            if (hActiveStart) {
-                hActive = hActiveEnd-hActiveStart+1;
-                hActiveSum += hActive;
-                nHActive++;
-                if (hActive != timHActive) {
-                    nHActiveErrors++;
-                    if (enableHMessages) {
-                        if (hLastErrorLine != hLineNumber) {
-                            hLastErrorLine = hLineNumber;
-                            fprintf(fpVScope, "***ERROR: Line %d, y=%d: ", hLineNumber, yCoord);
-                        }
-                        else
-                            fprintf(fpVScope, ", ");
-                        fprintf(fpVScope, "HACTIVE[nom=%d] = %d", timHActive, hActive);
-                    }
-                }
-                if (hActiveMin > hActive)
-                    hActiveMin = hActive;
-                if (hActiveMax < hActive)
-                    hActiveMax = hActive;
-            }
-        }
 
-        // Horizontal Front Porch
-        if (!(scopePixelBuff[i].ctrl & SCOPE_CTRL_HSYNC) && (scopePixelBuff[i+1].ctrl & SCOPE_CTRL_HSYNC)) {
-            hFPEnd = i;
-            if (hActiveEnd) {
-                hFP = hFPEnd-hActiveEnd;
-                if (hFP < timHTotal) {     // Ignore vertical blank periods
-                    hFPSum += hFP;
-                    nHFP++;
-                    if (hFP != timHFp) {
-                        nHFPErrors++;
-                        if (enableHMessages) {
-                            if (hLastErrorLine != hLineNumber) {
-                                hLastErrorLine = hLineNumber;
-                                fprintf(fpVScope, "***ERROR: Line %d, y=%d: ", hLineNumber, yCoord);
-                            }
-                            else
-                                fprintf(fpVScope, ", ");
-                            fprintf(fpVScope, "HFP[nom=%d] = %d", timHFp, hFP);
-                        }
-                    }
-                    if (hFPMin > hFP)
-                        hFPMin = hFP;
-                    if (hFPMax < hFP)
-                        hFPMax = hFP;
-                }
-            }
-        }
+// Common implementation for DPxStartSchedGroup*().
+// syncType is 0 for no sync, 1 for video sync, 2 for pixel sync.
+// The nanosecond marker is latched by the same USB message which writes the start bits,
+// so the returned time is the device time at which the whole group started.
+static void DPxStartSchedGroupSync(int schedMask, int syncType, int nPixels, unsigned char* pixelData, int timeout,
+								   unsigned *nanoHigh32, unsigned *nanoLow32)
+{
+	if (!DPxIsSchedGroupMaskValid(schedMask, "DPxStartSchedGroup"))
+		return;
+	DPxSetSchedGroupStart(schedMask);
+	DPxSetMarker();
 
-        // Horizontal Sync
-        if ((scopePixelBuff[i].ctrl & SCOPE_CTRL_HSYNC) && !(scopePixelBuff[i+1].ctrl & SCOPE_CTRL_HSYNC)) {
-            hSyncEnd = i;
-            if (hFPEnd) {
-                hSync = hSyncEnd-hFPEnd;
-                hSyncSum += hSync;
-                nHSync++;
-                if (hSync != timHSync) {
-                    nHSyncErrors++;
-                    if (enableHMessages) {
-                        if (hLastErrorLine != hLineNumber) {
-                            hLastErrorLine = hLineNumber;
-                            fprintf(fpVScope, "***ERROR: Line %d, y=%d: ", hLineNumber, yCoord);
-                        }
-                        else
-                            fprintf(fpVScope, ", ");
-                        fprintf(fpVScope, "HSYNC[nom=%d] = %d", timHSync, hSync);
-                    }
-                }
-                if (hSyncMin > hSync)
-                    hSyncMin = hSync;
-                if (hSyncMax < hSync)
-                    hSyncMax = hSync;
-            }
-        }
+	DPxBuildUsbMsgBegin();
+	if (syncType == 1)
+		DPxBuildUsbMsgVideoSync();
+	else if (syncType == 2)
+		DPxBuildUsbMsgPixelSync(nPixels, pixelData, timeout);
+	DPxBuildUsbMsgWriteRegs();
+	DPxBuildUsbMsgReadRegs();
+	if (syncType == 2)
+		dpxActivePSyncTimeout = timeout;	// Let low-level know that the timeout could be large
+	DPxBuildUsbMsgEnd();
+	dpxActivePSyncTimeout = -1;
 
-        // Horizontal Back Porch
-        if (!(scopePixelBuff[i].ctrl & SCOPE_CTRL_DE) && (scopePixelBuff[i+1].ctrl & SCOPE_CTRL_DE)) {
-            hBPEnd = i;
-            if (hSyncEnd) {
-                hBP = hBPEnd-hSyncEnd;
-                hBPSum += hBP;
-                nHBP++;
-                if (hBP != timHBp) {
-                    nHBPErrors++;
-                    if (enableHMessages) {
-                        if (hLastErrorLine != hLineNumber) {
-                            hLastErrorLine = hLineNumber;
-                            fprintf(fpVScope, "***ERROR: Line %d, y=%d: ", hLineNumber, yCoord);
-                        }
-                        else
-                            fprintf(fpVScope, ", ");
-                        fprintf(fpVScope, "HBP[nom=%d] = %d", timHBp, hBP);
-                    }
-                }
-                if (hBPMin > hBP)
-                    hBPMin = hBP;
-                if (hBPMax < hBP)
-                    hBPMax = hBP;
-            }
+	if (nanoHigh32 && nanoLow32)
+		DPxGetNanoMarker(nanoHigh32, nanoLow32);
+}
 
-            // While we're at the end of the back porch, we'll also collects stats for entire lines
-            if (hTotalEnd) {
-                hTotal = i - hTotalEnd;
-                if (hTotal < timHTotal*timVSync) {     // Ignore vertical blank periods
-                    hTotalSum += hTotal;
-                    nHTotal++;
-                    if (hTotal != timHTotal) {
-                        nHTotalErrors++;
-                        if (enableHMessages) {
-                            if (hLastErrorLine != hLineNumber) {
-                                hLastErrorLine = hLineNumber;
-                                fprintf(fpVScope, "***ERROR: Line %d, y=%d: ", hLineNumber, yCoord);
-                            }
-                            else
-                                fprintf(fpVScope, ", ");
-                            fprintf(fpVScope, "HTOTAL[nom=%d] = %d", timHTotal, hTotal);
-                        }
-                    }
-                    if (hTotalMin > hTotal)
-                        hTotalMin = hTotal;
-                    if (hTotalMax < hTotal)
-                        hTotalMax = hTotal;
-                }
-            }
-            hTotalEnd = i;
-
-            // End-of-line message processing
-            if (hLastErrorLine == hLineNumber) {
-                fprintf(fpVScope, ", RGB[");
-                PrintScopePixels(hActiveStart, 2);
-                fprintf(fpVScope, "]..[");
-                PrintScopePixels(hActiveEnd-1, 3);
-                fprintf(fpVScope, "]\n");
-                if (++hMsgNumber >= MAX_SCOPE_HMSGS)
-                    enableHMessages = 0;
-            }
-            if (hLineNumber < 4) { // Just so we can get some baseline video data
-                fprintf(fpVScope, "Line %d RGB[", hLineNumber);
-                PrintScopePixels(hActiveStart, 2);
-                fprintf(fpVScope, "]..[");
-                PrintScopePixels(hActiveEnd-1, 3);
-                fprintf(fpVScope, "]\n");
-            }
 
-            // Print out one complete line if we're writing to a file
-            if (toFile && hLineNumber == 8) {
-                for (j = hActiveStart; j <= hActiveEnd; j += 2) {
-                    fprintf(fpVScope, "2clk[%d]=[", j-hActiveStart);
-                    PrintScopePixels(j, 2);
-                    fprintf(fpVScope, "]\n");
-                }
-             }
-
-            // A quick self-test to see if video line readback works.
-            if (hLineNumber == 0) {
-                for (j = 0; j < (hActiveEnd-hActiveStart+1)/2; j++) {
-                    k = DPxIsVidDviActiveDual() ? j : j*2+1;
-                    if (scopePixelBuff[hActiveStart+k].redE   != vidLineData[j*8+0] >> 8 ||
-                        scopePixelBuff[hActiveStart+k].greenE != vidLineData[j*8+1] >> 8 ||
-                        scopePixelBuff[hActiveStart+k].blueE  != vidLineData[j*8+2] >> 8 ||
-                        scopePixelBuff[hActiveStart+k].redO   != vidLineData[j*8+4] >> 8 ||
-                        scopePixelBuff[hActiveStart+k].greenO != vidLineData[j*8+5] >> 8 ||
-                        scopePixelBuff[hActiveStart+k].blueO  != vidLineData[j*8+6] >> 8) {
-                        printf("***LineBuff error on frame %d, pixel pair %d***\n", nVFrame, j);
-                        printf("DDR: (%02X,%02X,%02X),(%02X,%02X,%02X)\n", scopePixelBuff[hActiveStart+k].redE, scopePixelBuff[hActiveStart+k].greenE, scopePixelBuff[hActiveStart+k].blueE,
-                                scopePixelBuff[hActiveStart+k].redO, scopePixelBuff[hActiveStart+k].greenO, scopePixelBuff[hActiveStart+k].blueO);
-                        printf("LIN: (%02X,%02X,%02X),(%02X,%02X,%02X)\n", vidLineData[j*8+0] >> 8, vidLineData[j*8+1] >> 8, vidLineData[j*8+2] >> 8, vidLineData[j*8+4] >> 8, vidLineData[j*8+5] >> 8, vidLineData[j*8+6] >> 8);
-                    }
-                }
-            }
+// Start all schedules in schedMask with a single register write, and return the nanosecond start time.
+// Schedules should first be configured with the usual DPxSet*Sched() and DPxSet*Buff() calls;
+// these only modify the local register cache, so they are all written by the same USB message.
+// nanoHigh32/nanoLow32 can be null if the start time is not required.
+void DPxStartSchedGroup(int schedMask, unsigned *nanoHigh32, unsigned *nanoLow32)
+{
+	DPxStartSchedGroupSync(schedMask, 0, 0, 0, 0, nanoHigh32, nanoLow32);
+}
 
-            // Prep for next line
-            hLineNumber++;
-            yCoord++;
-        }
-    }
 
-    // Print summary stats
-    fprintf(fpVScope, "\n");
-    if (nVFrameErrors == 0)
-        fprintf(fpVScope, "All %d VFRAME=%d\n", nVFrame, timFTotal);
-    else
-        fprintf(fpVScope, "***ERROR: VFRAME[nom=%d] range=%d-%d, avg=%.3f, %d/%d errors\n", timFTotal, vFrameMin, vFrameMax, vFrameSum/nVFrame, nVFrameErrors, nVFrame);
+// Like DPxStartSchedGroup(), but the group starts on the leading edge of the next vertical sync pulse
+void DPxStartSchedGroupAfterVideoSync(int schedMask, unsigned *nanoHigh32, unsigned *nanoLow32)
+{
+	DPxStartSchedGroupSync(schedMask, 1, 0, 0, 0, nanoHigh32, nanoLow32);
+}
 
-    if (nHActiveErrors == 0)
-        fprintf(fpVScope, "All %d HACTIVE=%d\n", nHActive, timHActive);
-    else
-        fprintf(fpVScope, "***ERROR: HACTIVE[nom=%d] range=%d-%d, avg=%.3f, %d/%d errors\n", timHActive, hActiveMin, hActiveMax, hActiveSum/nHActive, nHActiveErrors, nHActive);
-    if (nHActive != N_SCOPE_TEST_FRAMES*timVActive)
-        fprintf(fpVScope, "***ERROR: Expected %d HACTIVE, but recorded %d\n", N_SCOPE_TEST_FRAMES*timVActive, nHActive);
 
-    if (nHFPErrors == 0)
-        fprintf(fpVScope, "All %d HFP=%d\n", nHFP, timHFp);
-    else
-        fprintf(fpVScope, "***ERROR: HFP[nom=%d] range=%d-%d, avg=%.3f, %d/%d errors\n", timHFp, hFPMin, hFPMax, hFPSum/nHFP, nHFPErrors, nHFP);
-    if (nHFP != N_SCOPE_TEST_FRAMES*timVActive)
-        fprintf(fpVScope, "***ERROR: Expected %d HFP, but recorded %d\n", N_SCOPE_TEST_FRAMES*timVActive, nHFP);
+// Like DPxStartSchedGroup(), but the group starts when the specified pixel sync sequence has been displayed.
+// See DPxWriteRegCacheAfterPixelSync() for a description of the pixel sync arguments.
+void DPxStartSchedGroupAfterPixelSync(int schedMask, int nPixels, unsigned char* pixelData, int timeout, unsigned *nanoHigh32, unsigned *nanoLow32)
+{
+	DPxStartSchedGroupSync(schedMask, 2, nPixels, pixelData, timeout, nanoHigh32, nanoLow32);
+}
 
-    if (nHSyncErrors == 0)
-        fprintf(fpVScope, "All %d HSYNC=%d\n", nHSync, timHSync);
-    else
-        fprintf(fpVScope, "***ERROR: HSYNC[nom=%d] range=%d-%d, avg=%.3f, %d/%d errors\n", timHSync, hSyncMin, hSyncMax, hSyncSum/nHSync, nHSyncErrors, nHSync);
-    if (nHSync != N_SCOPE_TEST_FRAMES*timVTotal)
-        fprintf(fpVScope, "***ERROR: Expected %d HSYNC, but recorded %d\n", N_SCOPE_TEST_FRAMES*timVTotal, nHSync);
 
-    if (nHBPErrors == 0)
-        fprintf(fpVScope, "All %d HBP=%d\n", nHBP, timHBp);
-    else
-        fprintf(fpVScope, "***ERROR: HBP[nom=%d] range=%d-%d, avg=%.3f, %d/%d errors\n", timHBp, hBPMin, hBPMax, hBPSum/nHBP, nHBPErrors, nHBP);
-    if (nHBP != N_SCOPE_TEST_FRAMES*timVActive)
-        fprintf(fpVScope, "***ERROR: Expected %d HBP, but recorded %d\n", N_SCOPE_TEST_FRAMES*timVActive, nHBP);
+/********************************************************************************/
+/*																				*/
+/*	RAM region allocator														*/
+/*																				*/
+/********************************************************************************/
 
-    if (nHTotalErrors == 0)
-        fprintf(fpVScope, "All %d HTOTAL=%d\n", nHTotal, timHTotal);
-    else
-        fprintf(fpVScope, "***ERROR: HTOTAL[nom=%d] range=%d-%d, avg=%.3f, %d/%d errors\n", timHTotal, hTotalMin, hTotalMax, hTotalSum/nHTotal, nHTotalErrors, nHTotal);
-    if (nHTotal != N_SCOPE_TEST_FRAMES*(timVActive-1)) // VBL scraps one of our HTOTAL data
-        fprintf(fpVScope, "***ERROR: Expected %d HTOTAL, but recorded %d\n", N_SCOPE_TEST_FRAMES*(timVActive-1), nHTotal);
-
-    fprintf(fpVScope, "VFP range=%d-%d\n", vertFpMin, vertFpMax);
-    fprintf(fpVScope, "VSYNC range=%d-%d\n", vertSyncMin, vertSyncMax);
-    fprintf(fpVScope, "VBP range=%d-%d\n", vertBpMin, vertBpMax);
-    fprintf(fpVScope, "VSYNC start phase range=%d-%d\n", vSyncStartPhaseMin, vSyncStartPhaseMax);
-    fprintf(fpVScope, "VSYNC end phase range=%d-%d\n", vSyncEndPhaseMin, vSyncEndPhaseMax);
-    
-    if (hiddenRed > 0 || hiddenGrn > 0 || hiddenBlu > 0)
-        fprintf(fpVScope, "***Hidden (R,G,B) = (%g,%g,%g)\n", hiddenRed, hiddenGrn, hiddenBlu);
 
-end:
-    if (fpVScope != stdout)
-        fclose(fpVScope);
+// One named block of DATAPixx RAM.
+// The table is kept sorted by address, so the gaps between neighbouring entries are the free space.
+typedef struct {
+	char		name[DPX_RAM_REGION_NAME_MAX+1];
+	unsigned	addr;
+	unsigned	size;
+	unsigned	alignment;
+	int			sched;
+} DPxRamRegion;
+
+static DPxRamRegion dpxRamRegions[DPX_RAM_REGION_MAX];
+static int dpxNumRamRegions = 0;
+
+
+// The RAM buffer registers of one schedule.
+// addr is the read pointer for output schedules, and the write pointer for input schedules.
+typedef struct {
+	int			sched;
+	unsigned	(*getBaseAddr)(void);
+	void		(*setBaseAddr)(unsigned);
+	unsigned	(*getAddr)(void);
+	void		(*setAddr)(unsigned);
+	void		(*setBuff)(unsigned, unsigned);
+	int			(*isBusy)(void);
+} DPxRamSchedBuff;
+
+
+// DIN buffer also receives logged transitions when no DIN schedule is running
+static int DPxIsDinBuffBusy(void)
+{
+	return DPxIsDinSchedRunning() || DPxIsDinLogEvents();
 }
 
 
-void PrintScopePixels(int inBuffIndex, int nPixels)
+static const DPxRamSchedBuff dpxRamSchedBuffs[] = {
+	{ DPX_SCHED_GROUP_DAC,  DPxGetDacBuffBaseAddr,  DPxSetDacBuffBaseAddr,  DPxGetDacBuffReadAddr,  DPxSetDacBuffReadAddr,  DPxSetDacBuff,  DPxIsDacSchedRunning },
+	{ DPX_SCHED_GROUP_ADC,  DPxGetAdcBuffBaseAddr,  DPxSetAdcBuffBaseAddr,  DPxGetAdcBuffWriteAddr, DPxSetAdcBuffWriteAddr, DPxSetAdcBuff,  DPxIsAdcSchedRunning },
+	{ DPX_SCHED_GROUP_DOUT, DPxGetDoutBuffBaseAddr, DPxSetDoutBuffBaseAddr, DPxGetDoutBuffReadAddr, DPxSetDoutBuffReadAddr, DPxSetDoutBuff, DPxIsDoutSchedRunning },
+	{ DPX_SCHED_GROUP_DIN,  DPxGetDinBuffBaseAddr,  DPxSetDinBuffBaseAddr,  DPxGetDinBuffWriteAddr, DPxSetDinBuffWriteAddr, DPxSetDinBuff,  DPxIsDinBuffBusy },
+	{ DPX_SCHED_GROUP_AUD,  DPxGetAudBuffBaseAddr,  DPxSetAudBuffBaseAddr,  DPxGetAudBuffReadAddr,  DPxSetAudBuffReadAddr,  DPxSetAudBuff,  DPxIsAudSchedRunning },
+	{ DPX_SCHED_GROUP_AUX,  DPxGetAuxBuffBaseAddr,  DPxSetAuxBuffBaseAddr,  DPxGetAuxBuffReadAddr,  DPxSetAuxBuffReadAddr,  DPxSetAuxBuff,  DPxIsAuxSchedRunning },
+	{ DPX_SCHED_GROUP_MIC,  DPxGetMicBuffBaseAddr,  DPxSetMicBuffBaseAddr,  DPxGetMicBuffWriteAddr, DPxSetMicBuffWriteAddr, DPxSetMicBuff,  DPxIsMicSchedRunning },
+};
+#define DPX_RAM_N_SCHED_BUFFS	(int)(sizeof(dpxRamSchedBuffs) / sizeof(dpxRamSchedBuffs[0]))
+
+
+// Round addr up to the next multiple of alignment, which is a power of 2
+static unsigned DPxRamAlignUp(unsigned addr, unsigned alignment)
 {
-    int i;
-    
-    for (i = inBuffIndex; i < inBuffIndex+nPixels; i++) {
-        if (i > inBuffIndex)
-            fprintf(fpVScope, ",");
-        fprintf(fpVScope, "(%02X,%02X,%02X),(%02X,%02X,%02X)", scopePixelBuff[i].redE, scopePixelBuff[i].greenE, scopePixelBuff[i].blueE,
-                                                      scopePixelBuff[i].redO, scopePixelBuff[i].greenO, scopePixelBuff[i].blueO);
-    }
+	return (addr + alignment - 1) & ~(alignment - 1);
+}
+
+
+// Index of the region called name, or -1 if there is no such region
+static int DPxFindRamRegion(const char* name)
+{
+	int iRegion;
+
+	if (!name)
+		return -1;
+	for (iRegion = 0; iRegion < dpxNumRamRegions; iRegion++)
+		if (!strcmp(dpxRamRegions[iRegion].name, name))
+			return iRegion;
+	return -1;
+}
+
+
+// Like DPxFindRamRegion(), but sets DPX_ERR_RAM_REGION_UNKNOWN if the region doesn't exist
+static int DPxLookupRamRegion(const char* name, const char* caller)
+{
+	int iRegion = DPxFindRamRegion(name);
+
+	if (iRegion < 0) {
+		DPxDebugPrint2("ERROR: %s() has no RAM region named \"%s\"\n", caller, name ? name : "(null)");
+		DPxSetError(DPX_ERR_RAM_REGION_UNKNOWN);
+	}
+	return iRegion;
+}
+
+
+// Allocate a named block of DATAPixx RAM, and return its start address.
+// size must be even.  alignment must be an even power of 2, or 0 for the minimum (2 byte) alignment.
+// sched is 0 for a scratch region, or one DPX_SCHED_GROUP_* flag.
+// When sched is specified, the schedule's RAM buffer is assigned to the new region in the local register cache,
+// as if DPxSet*Buff() had been called.
+// Regions are allocated first-fit, from the lowest address upwards.
+// On failure, the return value is DPX_RAM_ADDR_INVALID and the global error code is set.
+// 0 is a valid address, so callers must compare against DPX_RAM_ADDR_INVALID rather than test for 0.
+unsigned DPxAllocRam(char* name, unsigned size, unsigned alignment, int sched)
+{
+	unsigned ramSize, gapStart, gapEnd, addr;
+	int iRegion, iSched;
+
+	// Validate args
+	if (!name || !name[0] || strlen(name) > DPX_RAM_REGION_NAME_MAX) {
+		DPxDebugPrint1("ERROR: DPxAllocRam() region name must have 1 to %d characters\n", DPX_RAM_REGION_NAME_MAX);
+		DPxSetError(DPX_ERR_RAM_ALLOC_BAD_NAME);
+		return DPX_RAM_ADDR_INVALID;
+	}
+	if (DPxFindRamRegion(name) >= 0) {
+		DPxDebugPrint1("ERROR: DPxAllocRam() RAM region \"%s\" already exists\n", name);
+		DPxSetError(DPX_ERR_RAM_ALLOC_NAME_EXISTS);
+		return DPX_RAM_ADDR_INVALID;
+	}
+	if (!size || (size & 1)) {
+		DPxDebugPrint1("ERROR: DPxAllocRam() argument size 0x%x must be a non-0 even number\n", size);
+		DPxSetError(DPX_ERR_RAM_ALLOC_BAD_SIZE);
+		return DPX_RAM_ADDR_INVALID;
+	}
+	if (!alignment)
+		alignment = 2;
+	if (alignment < 2 || (alignment & (alignment - 1))) {
+		DPxDebugPrint1("ERROR: DPxAllocRam() argument alignment 0x%x must be an even power of 2\n", alignment);
+		DPxSetError(DPX_ERR_RAM_ALLOC_BAD_ALIGN);
+		return DPX_RAM_ADDR_INVALID;
+	}
+	if (sched && ((sched & ~DPX_SCHED_GROUP_ALL) || (sched & (sched - 1)))) {
+		DPxDebugPrint1("ERROR: DPxAllocRam() argument sched 0x%x must be 0 or a single DPX_SCHED_GROUP_* flag\n", sched);
+		DPxSetError(DPX_ERR_RAM_ALLOC_BAD_SCHED);
+		return DPX_RAM_ADDR_INVALID;
+	}
+	if (dpxNumRamRegions == DPX_RAM_REGION_MAX) {
+		DPxDebugPrint1("ERROR: DPxAllocRam() cannot allocate more than %d RAM regions\n", DPX_RAM_REGION_MAX);
+		DPxSetError(DPX_ERR_RAM_ALLOC_TOO_MANY);
+		return DPX_RAM_ADDR_INVALID;
+	}
+	ramSize = DPxGetRamSize();
+	if (!ramSize)
+		return DPX_RAM_ADDR_INVALID;
+
+	// First fit.  The gap before region iRegion runs from the end of the previous region to the start of iRegion.
+	gapStart = 0;
+	for (iRegion = 0; iRegion <= dpxNumRamRegions; iRegion++) {
+		gapEnd = iRegion < dpxNumRamRegions ? dpxRamRegions[iRegion].addr : ramSize;
+		addr = DPxRamAlignUp(gapStart, alignment);
+		if (addr >= gapStart && addr <= gapEnd && size <= gapEnd - addr)
+			break;
+		if (iRegion < dpxNumRamRegions)
+			gapStart = dpxRamRegions[iRegion].addr + dpxRamRegions[iRegion].size;
+	}
+	if (iRegion > dpxNumRamRegions) {
+		DPxDebugPrint2("ERROR: DPxAllocRam() no free block of 0x%x bytes with alignment 0x%x\n", size, alignment);
+		DPxSetError(DPX_ERR_RAM_ALLOC_NO_SPACE);
+		return DPX_RAM_ADDR_INVALID;
+	}
+
+	// Insert the new region at iRegion, to keep the table sorted by address
+	memmove(&dpxRamRegions[iRegion+1], &dpxRamRegions[iRegion], (dpxNumRamRegions - iRegion) * sizeof(DPxRamRegion));
+	strcpy(dpxRamRegions[iRegion].name, name);
+	dpxRamRegions[iRegion].addr = addr;
+	dpxRamRegions[iRegion].size = size;
+	dpxRamRegions[iRegion].alignment = alignment;
+	dpxRamRegions[iRegion].sched = sched;
+	dpxNumRamRegions++;
+
+	if (sched)
+		for (iSched = 0; iSched < DPX_RAM_N_SCHED_BUFFS; iSched++)
+			if (dpxRamSchedBuffs[iSched].sched == sched)
+				dpxRamSchedBuffs[iSched].setBuff(addr, size);
+	return addr;
+}
+
+
+// Insert a region at a fixed address, if no other region overlaps it.
+// Returns the index of the new region, or -1 if the range is not free.
+static int DPxReserveRam(const char* name, unsigned addr, unsigned size)
+{
+	int iRegion;
+
+	if (dpxNumRamRegions == DPX_RAM_REGION_MAX || DPxFindRamRegion(name) >= 0)
+		return -1;
+	for (iRegion = 0; iRegion < dpxNumRamRegions && dpxRamRegions[iRegion].addr < addr + size; iRegion++)
+		if (dpxRamRegions[iRegion].addr + dpxRamRegions[iRegion].size > addr)
+			return -1;
+
+	memmove(&dpxRamRegions[iRegion+1], &dpxRamRegions[iRegion], (dpxNumRamRegions - iRegion) * sizeof(DPxRamRegion));
+	strcpy(dpxRamRegions[iRegion].name, name);
+	dpxRamRegions[iRegion].addr = addr;
+	dpxRamRegions[iRegion].size = size;
+	dpxRamRegions[iRegion].alignment = 2;
+	dpxRamRegions[iRegion].sched = 0;
+	dpxNumRamRegions++;
+	return iRegion;
+}
+
+
+// Release a RAM region.  The device RAM contents are not modified.
+void DPxFreeRam(char* name)
+{
+	int iRegion = DPxLookupRamRegion(name, "DPxFreeRam");
+
+	if (iRegion < 0)
+		return;
+	dpxNumRamRegions--;
+	memmove(&dpxRamRegions[iRegion], &dpxRamRegions[iRegion+1], (dpxNumRamRegions - iRegion) * sizeof(DPxRamRegion));
+}
+
+
+// Release all RAM regions
+void DPxFreeAllRam()
+{
+	dpxNumRamRegions = 0;
+}
+
+
+// Get the start address of a RAM region, or DPX_RAM_ADDR_INVALID if there is no such region
+unsigned DPxGetRamRegionAddr(char* name)
+{
+	int iRegion = DPxLookupRamRegion(name, "DPxGetRamRegionAddr");
+
+	return iRegion < 0 ? DPX_RAM_ADDR_INVALID : dpxRamRegions[iRegion].addr;
+}
+
+
+// Get the number of bytes in a RAM region
+unsigned DPxGetRamRegionSize(char* name)
+{
+	int iRegion = DPxLookupRamRegion(name, "DPxGetRamRegionSize");
+
+	return iRegion < 0 ? 0 : dpxRamRegions[iRegion].size;
+}
+
+
+// Get the DPX_SCHED_GROUP_* flag passed to DPxAllocRam(), or 0 for a scratch region
+int DPxGetRamRegionSched(char* name)
+{
+	int iRegion = DPxLookupRamRegion(name, "DPxGetRamRegionSched");
+
+	return iRegion < 0 ? 0 : dpxRamRegions[iRegion].sched;
+}
+
+
+// Get the number of allocated RAM regions
+int DPxGetNumRamRegions()
+{
+	return dpxNumRamRegions;
+}
+
+
+// Copy the name of a RAM region into a buffer of at least DPX_RAM_REGION_NAME_MAX+1 chars.
+// Regions are indexed in address order, from 0 to DPxGetNumRamRegions()-1.
+void DPxGetRamRegionName(int index, char* name)
+{
+	if (index < 0 || index >= dpxNumRamRegions) {
+		DPxDebugPrint1("ERROR: DPxGetRamRegionName() argument index %d is out of range\n", index);
+		DPxSetError(DPX_ERR_RAM_REGION_UNKNOWN);
+		return;
+	}
+	if (name)
+		strcpy(name, dpxRamRegions[index].name);
+}
+
+
+// Get the total number of unallocated bytes of DATAPixx RAM
+unsigned DPxGetRamFreeSize()
+{
+	unsigned ramSize = DPxGetRamSize();
+	int iRegion;
+
+	for (iRegion = 0; iRegion < dpxNumRamRegions; iRegion++)
+		ramSize -= dpxRamRegions[iRegion].size;
+	return ramSize;
+}
+
+
+// Get the size of the largest contiguous block of unallocated DATAPixx RAM.
+// DPxDefragRam() can make this equal to DPxGetRamFreeSize(), except for alignment padding.
+unsigned DPxGetRamLargestFreeSize()
+{
+	unsigned ramSize = DPxGetRamSize();
+	unsigned gapStart = 0, gapEnd, largest = 0;
+	int iRegion;
+
+	for (iRegion = 0; iRegion <= dpxNumRamRegions; iRegion++) {
+		gapEnd = iRegion < dpxNumRamRegions ? dpxRamRegions[iRegion].addr : ramSize;
+		if (gapEnd - gapStart > largest)
+			largest = gapEnd - gapStart;
+		if (iRegion < dpxNumRamRegions)
+			gapStart = dpxRamRegions[iRegion].addr + dpxRamRegions[iRegion].size;
+	}
+	return largest;
+}
+
+
+// Copy length bytes of DATAPixx RAM from srcAddr down to dstAddr.
+// Since dstAddr < srcAddr, copying in ascending blocks never overwrites source data which has not been copied yet.
+static void DPxMoveRamDown(unsigned dstAddr, unsigned srcAddr, unsigned length)
+{
+	void* buffer = (void*)DPxGetReadRamBuffAddr();
+	unsigned blockLength;
+
+	while (length && DPxGetError() == DPX_SUCCESS) {
+		blockLength = length > DPX_RWRAM_BLOCK_SIZE ? DPX_RWRAM_BLOCK_SIZE : length;
+		DPxReadRam(srcAddr, blockLength, buffer);
+		if (DPxGetError() == DPX_SUCCESS)
+			DPxWriteRam(dstAddr, blockLength, buffer);
+		srcAddr += blockLength;
+		dstAddr += blockLength;
+		length  -= blockLength;
+	}
+}
+
+
+// Pack all RAM regions down towards address 0, so that the free RAM becomes one contiguous block.
+// Region contents are moved in device RAM.
+// Any schedule whose RAM buffer lies inside a moved region has its buffer base and read/write addresses moved too.
+// Addresses previously returned by DPxAllocRam() are no longer valid; use DPxGetRamRegionAddr() to get the new ones.
+// Can only be called when no schedule is running and DIN logging is disabled.
+void DPxDefragRam()
+{
+	unsigned nextAddr, newAddr, oldAddr, baseAddr;
+	int iRegion, iSched;
+
+	// Get the current schedule states from the device
+	DPxClearError();
+	DPxUpdateRegCache();
+	if (DPxGetError() != DPX_SUCCESS)
+		return;
+	for (iSched = 0; iSched < DPX_RAM_N_SCHED_BUFFS; iSched++) {
+		if (dpxRamSchedBuffs[iSched].isBusy()) {
+			DPxDebugPrint1("ERROR: DPxDefragRam() cannot move RAM while schedule 0x%x is running\n", dpxRamSchedBuffs[iSched].sched);
+			DPxSetError(DPX_ERR_RAM_DEFRAG_BUSY);
+			return;
+		}
+	}
+
+	nextAddr = 0;
+	for (iRegion = 0; iRegion < dpxNumRamRegions; iRegion++) {
+		oldAddr = dpxRamRegions[iRegion].addr;
+		newAddr = DPxRamAlignUp(nextAddr, dpxRamRegions[iRegion].alignment);
+		if (newAddr < oldAddr) {
+			DPxMoveRamDown(newAddr, oldAddr, dpxRamRegions[iRegion].size);
+			if (DPxGetError() != DPX_SUCCESS) {
+				DPxDebugPrint1("ERROR: DPxDefragRam() failed to move RAM region \"%s\"\n", dpxRamRegions[iRegion].name);
+				break;
+			}
+			for (iSched = 0; iSched < DPX_RAM_N_SCHED_BUFFS; iSched++) {
+				baseAddr = dpxRamSchedBuffs[iSched].getBaseAddr();
+				if (baseAddr >= oldAddr && baseAddr < oldAddr + dpxRamRegions[iRegion].size) {
+					dpxRamSchedBuffs[iSched].setBaseAddr(baseAddr - (oldAddr - newAddr));
+					dpxRamSchedBuffs[iSched].setAddr(dpxRamSchedBuffs[iSched].getAddr() - (oldAddr - newAddr));
+				}
+			}
+			dpxRamRegions[iRegion].addr = newAddr;
+		}
+		nextAddr = dpxRamRegions[iRegion].addr + dpxRamRegions[iRegion].size;
+	}
+
+	// Download the moved schedule buffer pointers
+	DPxWriteRegCache();
+}
+
+
+typedef struct {
+    UInt16          ctrl;       // 15:Unused, 14:DE, 13:HSync, 12:VSync, 11-8:BlueLSB, 7-4:GreenLSB, 3-0:RedLSB
+    unsigned char   redE;
+    unsigned char   greenE;
+    unsigned char   blueE;
+    unsigned char   redO;
+    unsigned char   greenO;
+    unsigned char   blueO;
+} ScopePixel;
+
+// VScope video timing bit locations
+#define SCOPE_CTRL_DE       0x4000
+#define SCOPE_CTRL_HSYNC    0x2000
+#define SCOPE_CTRL_VSYNC    0x1000
+#define SCOPE_CTRL_TIMING   (SCOPE_CTRL_DE | SCOPE_CTRL_HSYNC | SCOPE_CTRL_VSYNC)
+
+#define SCOPE_BUFF_SIZE ((165000000/120)*(DPX_VID_SCOPE_FRAMES+2))      // Make sure we read in enough data to get all the frames we need, even under bizarre video format problems.
+ScopePixel scopePixelBuff[SCOPE_BUFF_SIZE]; 
+
+
+// Index of the first scope sample in [i, nSamples) whose timing bits differ from those of the previous sample, or nSamples if there is none.
+// i must be > 0.  Within a line the timing bits are constant for hundreds of samples, so we compare several samples per step.
+static int DPxScopeNextEdge(const ScopePixel* buff, int i, int nSamples)
+{
+#if defined(__AVX2__)
+	const __m256i timingMask = _mm256_set1_epi64x(SCOPE_CTRL_TIMING);
+	__m256i diff;
+	int mask;
+
+	for ( ; i + 4 <= nSamples; i += 4) {
+		diff = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(buff + i)), _mm256_loadu_si256((const __m256i*)(buff + i - 1)));
+		diff = _mm256_cmpeq_epi64(_mm256_and_si256(diff, timingMask), _mm256_setzero_si256());
+		if ((mask = ~_mm256_movemask_pd(_mm256_castsi256_pd(diff)) & 0xF))
+			return i + DPxLowestSetBit(mask);
+	}
+#elif defined(__SSE2__)
+	const __m128i timingMask = _mm_set_epi32(0, SCOPE_CTRL_TIMING, 0, SCOPE_CTRL_TIMING);
+	__m128i diff;
+	int mask;
+
+	for ( ; i + 2 <= nSamples; i += 2) {
+		diff = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(buff + i)), _mm_loadu_si128((const __m128i*)(buff + i - 1)));
+		diff = _mm_cmpeq_epi32(_mm_and_si128(diff, timingMask), _mm_setzero_si128());
+		if ((mask = ~_mm_movemask_ps(_mm_castsi128_ps(diff)) & 0x5))
+			return i + ((mask & 1) ? 0 : 1);
+	}
+#endif
+	for ( ; i < nSamples; i++)
+		if ((buff[i].ctrl ^ buff[i-1].ctrl) & SCOPE_CTRL_TIMING)
+			break;
+	return i;
+}
+
+
+#if defined(__AVX2__) || defined(__SSE2__)
+static int DPxScopePopCount(unsigned bits)
+{
+	int n = 0;
+
+	for ( ; bits; bits &= bits - 1)
+		n++;
+	return n;
+}
+#endif
+
+
+// Add the number of non-0 colour components of the scope samples in [i, end) to the hidden colour counts of a result
+static void DPxScopeCountHidden(const ScopePixel* buff, int i, int end, DPxVideoScopeResult* result)
+{
+	int nRed = 0, nGreen = 0, nBlue = 0;
+
+	// Bytes 2-7 of each sample hold even R,G,B then odd R,G,B
+#if defined(__AVX2__)
+	unsigned nonZero;
+
+	for ( ; i + 4 <= end; i += 4) {
+		nonZero = ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(buff + i)), _mm256_setzero_si256()));
+		nRed   += DPxScopePopCount(nonZero & 0x24242424);
+		nGreen += DPxScopePopCount(nonZero & 0x48484848);
+		nBlue  += DPxScopePopCount(nonZero & 0x90909090);
+	}
+#elif defined(__SSE2__)
+	unsigned nonZero;
+
+	for ( ; i + 2 <= end; i += 2) {
+		nonZero = ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(buff + i)), _mm_setzero_si128()));
+		nRed   += DPxScopePopCount(nonZero & 0x2424);
+		nGreen += DPxScopePopCount(nonZero & 0x4848);
+		nBlue  += DPxScopePopCount(nonZero & 0x9090);
+	}
+#endif
+	for ( ; i < end; i++) {
+		nRed   += (buff[i].redE != 0) + (buff[i].redO != 0);
+		nGreen += (buff[i].greenE != 0) + (buff[i].greenO != 0);
+		nBlue  += (buff[i].blueE != 0) + (buff[i].blueO != 0);
+	}
+
+	result->hiddenRed   += nRed;
+	result->hiddenGreen += nGreen;
+	result->hiddenBlue  += nBlue;
+}
+
+
+static void DPxScopeSegmentInit(DPxVideoScopeSegment* segment, int nominal)
+{
+	segment->nominal = nominal;
+	segment->count = 0;
+	segment->errors = 0;
+	segment->min = 0x7FFFFFFF;
+	segment->max = -1;
+	segment->mean = 0;
+}
+
+
+static void DPxScopeSegmentAdd(DPxVideoScopeSegment* segment, int length)
+{
+	if (segment->nominal < 0)		// Unknown timing, so check that all segments match the first one
+		segment->nominal = length;
+	if (length != segment->nominal)
+		segment->errors++;
+	if (segment->min > length)
+		segment->min = length;
+	if (segment->max < length)
+		segment->max = length;
+	segment->count++;
+	segment->mean += (length - segment->mean) / segment->count;
+}
+
+
+static void DPxScopeSegmentDone(DPxVideoScopeSegment* segment)
+{
+	if (!segment->count)
+		segment->min = -1;
+}
+
+
+// Get the video timing which scope samples should have, from the timing the device measures on its video input.
+// Each scope sample holds one pixel pair, so horizontal lengths are half the pixel counts.
+// The device does not measure porch and sync lengths, so these are -1.
+void DPxGetVideoScopeTiming(DPxVideoScopeTiming* timing)
+{
+	timing->hActive		= DPxGetVidHActive() / 2;
+	timing->hFrontPorch	= -1;
+	timing->hSync		= -1;
+	timing->hBackPorch	= -1;
+	timing->hTotal		= DPxGetVidHTotal() / 2;
+	timing->vActive		= DPxGetVidVActive();
+	timing->vFrontPorch	= -1;
+	timing->vSync		= -1;
+	timing->vBackPorch	= -1;
+	timing->vTotal		= DPxGetVidVTotal();
+}
+
+
+// Analyze nFrames frames of video scope samples which are already on the host.
+// We use the convention that the first active pixel after vertical sync is the start of a video frame.
+// Rather than stepping through every sample, we jump from one edge of DE/HSYNC/VSYNC to the next, and measure segments between edges.
+// Returns result->status, which is DPX_SUCCESS once nFrames complete frames have been analyzed.
+int DPxAnalyzeVideoScopeBuff(void* buffer, int nSamples, DPxVideoScopeTiming* timing, int nFrames, DPxVideoScopeResult* result)
+{
+	const ScopePixel* buff = (const ScopePixel*)buffer;
+	int i, ctrl, changed, phase;
+	int frameStart = -1;							// First active sample of the current frame, -1 until the first frame starts
+	int deRise = -1, deFall = -1, hsRise = -1, hsFall = -1;	// Latest edges of DE and HSYNC
+	int hsRisesSinceDeRise = 0;
+	int vsSeen = 0;									// VSYNC seen since the current frame started
+	int lineActive = 0, lineVSync = 0;				// DE or VSYNC seen since the latest HSYNC leading edge
+	int vertState = 0, vertFp = 0, vertSync = 0, vertBp = 0;
+
+	memset(result, 0, sizeof(*result));
+	result->firstFrameSample = -1;
+	result->lineBuffErrors = -1;
+	if (!buff || !timing || nSamples < 2 || nFrames < 1) {
+		result->status = DPX_ERR_VID_SCOPE_BAD_ARGS;
+		DPxSetError(result->status);
+		return result->status;
+	}
+
+	DPxScopeSegmentInit(&result->frame, timing->hTotal > 0 && timing->vTotal > 0 ? timing->hTotal * timing->vTotal : -1);
+	DPxScopeSegmentInit(&result->hActive, timing->hActive);
+	DPxScopeSegmentInit(&result->hFrontPorch, timing->hFrontPorch);
+	DPxScopeSegmentInit(&result->hSync, timing->hSync);
+	DPxScopeSegmentInit(&result->hBackPorch, timing->hBackPorch);
+	DPxScopeSegmentInit(&result->hTotal, timing->hTotal);
+	DPxScopeSegmentInit(&result->vFrontPorch, timing->vFrontPorch);
+	DPxScopeSegmentInit(&result->vSync, timing->vSync);
+	DPxScopeSegmentInit(&result->vBackPorch, timing->vBackPorch);
+	result->vSyncStartPhaseMin = 0x7FFFFFFF;
+	result->vSyncStartPhaseMax = -1;
+	result->vSyncEndPhaseMin = 0x7FFFFFFF;
+	result->vSyncEndPhaseMax = -1;
+
+	for (i = DPxScopeNextEdge(buff, 1, nSamples); i < nSamples; i = DPxScopeNextEdge(buff, i + 1, nSamples)) {
+		ctrl = buff[i].ctrl;
+		changed = (ctrl ^ buff[i-1].ctrl) & SCOPE_CTRL_TIMING;
+		if ((ctrl | buff[i-1].ctrl) & SCOPE_CTRL_VSYNC)
+			vsSeen = 1;
+
+		// Trailing edge of DE: end of horizontal active
+		if ((changed & SCOPE_CTRL_DE) && !(ctrl & SCOPE_CTRL_DE)) {
+			if (frameStart >= 0 && deRise >= 0)
+				DPxScopeSegmentAdd(&result->hActive, i - deRise);
+			deFall = i;
+		}
+
+		// Leading edge of HSYNC: end of horizontal front porch, and of the line
+		if ((changed & SCOPE_CTRL_HSYNC) && (ctrl & SCOPE_CTRL_HSYNC)) {
+			if (frameStart >= 0 && deFall > hsRise)		// Ignore vertical blank lines
+				DPxScopeSegmentAdd(&result->hFrontPorch, i - deFall);
+			hsRise = i;
+			hsRisesSinceDeRise++;
+
+			// Vertical timing, from the line which just ended
+			if (lineActive) {
+				if (vertState == 3 || vertState == 4) {
+					if (frameStart >= 0) {
+						DPxScopeSegmentAdd(&result->vFrontPorch, vertFp);
+						DPxScopeSegmentAdd(&result->vSync, vertSync);
+						DPxScopeSegmentAdd(&result->vBackPorch, vertState == 4 ? vertBp : 0);
+					}
+				}
+				vertState = 1;
+			}
+			else if (lineVSync) {
+				if (vertState == 1)			// No front porch
+					vertFp = 0;
+				if (vertState == 1 || vertState == 2) {
+					vertState = 3;
+					vertSync = 0;
+				}
+				if (vertState == 3)
+					vertSync++;
+			}
+			else {
+				if (vertState == 1) {
+					vertState = 2;
+					vertFp = 0;
+				}
+				else if (vertState == 3) {
+					vertState = 4;
+					vertBp = 0;
+				}
+				if (vertState == 2)
+					vertFp++;
+				else if (vertState == 4)
+					vertBp++;
+			}
+			lineActive = 0;
+			lineVSync = (ctrl & SCOPE_CTRL_VSYNC) != 0;
+		}
+
+		// Trailing edge of HSYNC: end of horizontal sync
+		if ((changed & SCOPE_CTRL_HSYNC) && !(ctrl & SCOPE_CTRL_HSYNC)) {
+			if (frameStart >= 0 && hsRise >= 0)
+				DPxScopeSegmentAdd(&result->hSync, i - hsRise);
+			hsFall = i;
+		}
+
+		// Edges of VSYNC, and their phase relative to the latest leading edge of HSYNC
+		if (changed & SCOPE_CTRL_VSYNC) {
+			if (ctrl & SCOPE_CTRL_VSYNC)
+				lineVSync = 1;
+			if (frameStart >= 0 && hsRise >= 0) {
+				phase = i - hsRise;
+				if (ctrl & SCOPE_CTRL_VSYNC) {
+					if (result->vSyncStartPhaseMin > phase)
+						result->vSyncStartPhaseMin = phase;
+					if (result->vSyncStartPhaseMax < phase)
+						result->vSyncStartPhaseMax = phase;
+				}
+				else {
+					if (result->vSyncEndPhaseMin > phase)
+						result->vSyncEndPhaseMin = phase;
+					if (result->vSyncEndPhaseMax < phase)
+						result->vSyncEndPhaseMax = phase;
+				}
+			}
+		}
+
+		// Leading edge of DE: end of horizontal back porch, and maybe the start of a new frame
+		if ((changed & SCOPE_CTRL_DE) && (ctrl & SCOPE_CTRL_DE)) {
+			if (frameStart >= 0 && deFall >= frameStart)
+				DPxScopeCountHidden(buff, deFall, i, result);
+
+			if (vsSeen) {
+				if (frameStart < 0)
+					result->firstFrameSample = i;
+				else {
+					DPxScopeSegmentAdd(&result->frame, i - frameStart);
+					if (++result->nFrames == nFrames)
+						break;
+				}
+				frameStart = i;
+				vsSeen = 0;
+			}
+
+			if (frameStart >= 0) {
+				if (hsFall > deFall)
+					DPxScopeSegmentAdd(&result->hBackPorch, i - hsFall);
+				if (deRise >= 0 && hsRisesSinceDeRise == 1)		// Ignore vertical blanking
+					DPxScopeSegmentAdd(&result->hTotal, i - deRise);
+			}
+			deRise = i;
+			hsRisesSinceDeRise = 0;
+			lineActive = 1;
+		}
+	}
+
+	DPxScopeSegmentDone(&result->frame);
+	DPxScopeSegmentDone(&result->hActive);
+	DPxScopeSegmentDone(&result->hFrontPorch);
+	DPxScopeSegmentDone(&result->hSync);
+	DPxScopeSegmentDone(&result->hBackPorch);
+	DPxScopeSegmentDone(&result->hTotal);
+	DPxScopeSegmentDone(&result->vFrontPorch);
+	DPxScopeSegmentDone(&result->vSync);
+	DPxScopeSegmentDone(&result->vBackPorch);
+	if (result->vSyncStartPhaseMax < 0)
+		result->vSyncStartPhaseMin = -1;
+	if (result->vSyncEndPhaseMax < 0)
+		result->vSyncEndPhaseMin = -1;
+
+	if (result->nFrames < nFrames) {
+		result->status = frameStart < 0 ? DPX_ERR_VID_SCOPE_NO_FRAME : DPX_ERR_VID_SCOPE_TOO_FEW_FRAMES;
+		DPxSetError(result->status);
+	}
+	return result->status;
+}
+
+
+// Empty result of a video scope grab which failed with the current global error code
+static int DPxScopeFail(DPxVideoScopeResult* result)
+{
+	memset(result, 0, sizeof(*result));
+	result->firstFrameSample = -1;
+	result->lineBuffErrors = -1;
+	result->status = DPxGetError();
+	return result->status;
+}
+
+
+// Grab DPX_VID_SCOPE_FRAMES frames of incoming video, and analyze them against the video timing measured by the device.
+// Also checks that the first analyzed line matches the video line buffer.
+// The grab overwrites DATAPixx RAM from address 0, so it is reserved as RAM region DPX_VID_SCOPE_REGION while it runs,
+// and refused with DPX_ERR_VID_SCOPE_RAM_IN_USE if an allocated region overlaps it.
+// Returns result->status.
+int DPxAnalyzeVideoScope(DPxVideoScopeResult* result)
+{
+	DPxVideoScopeTiming timing;
+	const ScopePixel* pixel;
+	UInt16* vidLineData;
+	int regVidCtrl2, readError, j, k;
+
+	DPxClearError();
+	if (DPxReserveRam(DPX_VID_SCOPE_REGION, 0, sizeof(scopePixelBuff)) < 0) {
+		DPxDebugPrint0("ERROR: DPxAnalyzeVideoScope() video scope RAM overlaps an allocated RAM region\n");
+		DPxSetError(DPX_ERR_VID_SCOPE_RAM_IN_USE);
+		return DPxScopeFail(result);
+	}
+
+	DPxUpdateRegCache();
+	DPxGetVideoScopeTiming(&timing);
+
+	// Pixel drive will clobber VScope, so turn it off
+	regVidCtrl2 = DPxGetReg16(DPXREG_VID_CTRL2);
+	DPxSetReg16(DPXREG_VID_CTRL2, regVidCtrl2 & ~(DPXREG_VID_CTRL2_PIXELDRIVE | DPXREG_VID_CTRL2_PIXELDRIVE_ACCUM));
+	DPxUpdateRegCache();
+
+	// Initiate frame grab
+	DPxSetReg16(DPXREG_VID_SCOPE, 1);
+	DPxUpdateRegCache();
+
+	// Wait until frame grab done
+	do {
+		DPxUpdateRegCache();
+	} while (DPxGetReg16(DPXREG_VID_SCOPE) && DPxGetError() == DPX_SUCCESS);
+
+	// The grab overwrote RAM behind the back of the RAM shadow
+	DPxInvalidateRamShadow(0, sizeof(scopePixelBuff));
+
+	// Get buffer
+	DPxReadRam(0, sizeof(scopePixelBuff), scopePixelBuff);
+	readError = DPxGetError();
+	DPxFreeRam(DPX_VID_SCOPE_REGION);
+
+	// Restore normal operation
+	DPxSetReg16(DPXREG_VID_CTRL2, regVidCtrl2);
+	DPxUpdateRegCache();
+
+	if (readError != DPX_SUCCESS) {
+		DPxDebugPrint1("ERROR: DPxAnalyzeVideoScope() video scope grab failed with error %d\n", readError);
+		DPxSetError(readError);
+		return DPxScopeFail(result);
+	}
+
+	// Get first video line from line grabber
+	vidLineData = DPxGetVidLine();
+
+	if (DPxAnalyzeVideoScopeBuff(scopePixelBuff, SCOPE_BUFF_SIZE, &timing, DPX_VID_SCOPE_FRAMES, result) != DPX_SUCCESS || !vidLineData)
+		return result->status;
+
+	// A quick self-test to see if video line readback works
+	pixel = scopePixelBuff + result->firstFrameSample;
+	result->lineBuffErrors = 0;
+	for (j = 0; j < timing.hActive / 2; j++) {
+		k = DPxIsVidDviActiveDual() ? j : j*2+1;
+		if (pixel[k].redE   != vidLineData[j*8+0] >> 8 ||
+			pixel[k].greenE != vidLineData[j*8+1] >> 8 ||
+			pixel[k].blueE  != vidLineData[j*8+2] >> 8 ||
+			pixel[k].redO   != vidLineData[j*8+4] >> 8 ||
+			pixel[k].greenO != vidLineData[j*8+5] >> 8 ||
+			pixel[k].blueO  != vidLineData[j*8+6] >> 8)
+			result->lineBuffErrors++;
+	}
+	return result->status;
+}
+
+
+static void PrintScopeSegment(FILE* fp, const char* name, DPxVideoScopeSegment* segment)
+{
+	if (segment->errors == 0)
+		fprintf(fp, "All %d %s=%d\n", segment->count, name, segment->nominal);
+	else
+		fprintf(fp, "***ERROR: %s[nom=%d] range=%d-%d, avg=%.3f, %d/%d errors\n", name, segment->nominal, segment->min, segment->max, segment->mean, segment->errors, segment->count);
+}
+
+
+// Print a video scope result to stdout, or to listing.txt if toFile is non-0
+void DPxPrintVideoScopeResult(DPxVideoScopeResult* result, int toFile)
+{
+	FILE* fp = toFile ? fopen("listing.txt", "wt") : stdout;
+
+	if (!fp)
+		return;
+
+	if (result->status == DPX_ERR_VID_SCOPE_NO_FRAME)
+		fprintf(fp, "***ERROR: No VSYNC followed by active video found.  Is the display connected to a video source?\n");
+	else if (result->status == DPX_ERR_VID_SCOPE_TOO_FEW_FRAMES)
+		fprintf(fp, "***ERROR: Only %d of %d frames found in buffer.\n", result->nFrames, DPX_VID_SCOPE_FRAMES);
+	else if (result->status != DPX_SUCCESS)
+		fprintf(fp, "***ERROR: Video scope analysis failed with error %d\n", result->status);
+
+	if (result->firstFrameSample >= 0) {
+		fprintf(fp, "First frame starts at address 0x%x\n", (unsigned int)(result->firstFrameSample*sizeof(ScopePixel)));
+		PrintScopeSegment(fp, "VFRAME", &result->frame);
+		PrintScopeSegment(fp, "HACTIVE", &result->hActive);
+		PrintScopeSegment(fp, "HFP", &result->hFrontPorch);
+		PrintScopeSegment(fp, "HSYNC", &result->hSync);
+		PrintScopeSegment(fp, "HBP", &result->hBackPorch);
+		PrintScopeSegment(fp, "HTOTAL", &result->hTotal);
+		fprintf(fp, "VFP range=%d-%d\n", result->vFrontPorch.min, result->vFrontPorch.max);
+		fprintf(fp, "VSYNC range=%d-%d\n", result->vSync.min, result->vSync.max);
+		fprintf(fp, "VBP range=%d-%d\n", result->vBackPorch.min, result->vBackPorch.max);
+		fprintf(fp, "VSYNC start phase range=%d-%d\n", result->vSyncStartPhaseMin, result->vSyncStartPhaseMax);
+		fprintf(fp, "VSYNC end phase range=%d-%d\n", result->vSyncEndPhaseMin, result->vSyncEndPhaseMax);
+		if (result->hiddenRed > 0 || result->hiddenGreen > 0 || result->hiddenBlue > 0)
+			fprintf(fp, "***Hidden (R,G,B) = (%g,%g,%g)\n", result->hiddenRed, result->hiddenGreen, result->hiddenBlue);
+		if (result->lineBuffErrors > 0)
+			fprintf(fp, "***LineBuff errors on %d pixel pairs\n", result->lineBuffErrors);
+	}
+
+	if (fp != stdout)
+		fclose(fp);
+}
+
+
+// VIEWPixx video source analysis, printed to stdout, or to listing.txt if toFile is non-0
+void DPxVideoScope(int toFile)
+{
+	DPxVideoScopeResult result;
+
+	DPxAnalyzeVideoScope(&result);
+	DPxPrintVideoScopeResult(&result, toFile);
 }
 
@@ -44,6 +44,19 @@ int			DPxGetReadRamBuffSize(void);									// Number of bytes in internal read R
 size_t		DPxGetWriteRamBuffAddr(void);									// Address of API internal write RAM buffer
 int			DPxGetWriteRamBuffSize(void);									// Number of bytes in internal write RAM buffer
 
+//	RAM shadow
+//	When enabled, the API keeps a content hash of each DATAPixx RAM page written by DPxWriteRam().
+//	Full pages which would be rewritten with identical data are skipped, and only the changed spans are transmitted.
+//	Buffers which the ADC, DIN and MIC subsystems write into are invalidated whenever those schedules are started or running.
+//	Call DPxInvalidateRamShadow() if RAM could have been modified some other way (eg: by another application).
+void		DPxEnableRamShadow(void);										// Start skipping uploads of RAM pages which already hold the same data
+void		DPxDisableRamShadow(void);										// Transmit every byte passed to DPxWriteRam()
+int			DPxIsRamShadow(void);											// Returns non-0 if RAM shadow is enabled
+void		DPxInvalidateRamShadow(unsigned address, unsigned length);		// Forget the shadow of a block of DATAPixx RAM, so the next upload is transmitted
+double		DPxGetRamShadowBytesSent(void);									// Number of bytes transmitted by DPxWriteRam() since DPxEnableRamShadow()
+double		DPxGetRamShadowBytesSkipped(void);								// Number of bytes skipped by DPxWriteRam() since DPxEnableRamShadow()
+#define DPX_RAM_SHADOW_PAGE_SIZE	4096										// Granularity of RAM shadow hashes, in bytes
+
 //	The DPxSet*() DPxEnable*(), and DPxDisable*() functions write new register values to a local cache, then flag these registers as "modified".
 //	DPxWriteRegCache() downloads modified registers in the local cache back to the DATAPixx.
 //	Averages about 125 microseconds (probably one 125us USB microframe) on a Mac Pro.
@@ -209,6 +222,34 @@ int			DPxIsAdcSchedRunning(void);								// Returns non-0 if ADC schedule is cur
 void		DPxEnableAdcLogTimetags(void);							// Each buffered ADC sample is preceeded with a 64-bit nanosecond timetag
 void		DPxDisableAdcLogTimetags(void);							// Buffered data has no timetags
 int			DPxIsAdcLogTimetags(void);								// Returns non-0 if buffered datasets are preceeded with nanosecond timetag
+void		DPxDecodeAdcBuff(void* buffer, int nFrames, int nChans, int* channels, int timetagged, double* timeSecs, float* volts);	// Convert ADC RAM buffer data read with DPxReadRam() into arrays of timetag seconds, and of volts for each channel
+
+//	ADC event detection
+//	Each buffered ADC channel (0-15) can have a threshold trigger, on either its voltage or its slope in volts per second.
+//	Triggers have hysteresis: they switch high at threshold+hysteresis/2, and switch low at threshold-hysteresis/2.
+//	Events are queued with device timestamps interpolated between the two samples which bracket the crossing.
+//	Typical usage steps are:
+//		-Configure an ADC schedule with DPxEnableAdcLogTimetags(), and DPxSetAdcEventTrigger() for each channel of interest
+//		-DPxResetAdcEvents(), then start the ADC schedule
+//		-Call DPxPollAdcEvents() regularly while the schedule runs, and consume events with DPxGetAdcEvent()
+//		-Alternatively, pass blocks of previously read buffer data to DPxProcessAdcEvents()
+//
+void		DPxSetAdcEventTrigger(int channel, int mode, int edge, double threshold, double hysteresis);	// Set the event trigger for one ADC channel
+																	// mode is one of the following predefined constants:
+#define DPX_ADC_EVENT_LEVEL		0									//		Trigger on the channel voltage
+#define DPX_ADC_EVENT_SLOPE		1									//		Trigger on the channel slope, in volts per second
+																	// edge is an OR of the following predefined constants:
+#define DPX_ADC_EVENT_RISING	1									//		Signal rises through threshold+hysteresis/2
+#define DPX_ADC_EVENT_FALLING	2									//		Signal falls through threshold-hysteresis/2
+#define DPX_ADC_EVENT_BOTH		3									//		Both of the above
+void		DPxClearAdcEventTrigger(int channel);					// Remove the event trigger from one ADC channel
+void		DPxResetAdcEvents(void);								// Flush event queue and trigger states, and restart polling at ADC buffer start
+int			DPxProcessAdcEvents(void* buffer, int nFrames, int nChans, int* channels);	// Run triggers over timetagged buffer data already read by host.  Returns number of new events.
+int			DPxPollAdcEvents(void);									// Read new data from running ADC schedule, and run triggers over it.  Returns number of new events.
+int			DPxGetNumAdcEvents(void);								// Get number of events waiting in the queue
+int			DPxGetAdcEvent(int* channel, int* edge, double* timeSecs);	// Remove oldest event from queue.  Returns 0 if queue is empty.
+unsigned	DPxGetAdcEventsDropped(void);							// Get number of events dropped because the queue was full
+#define DPX_ADC_EVENT_QUEUE_SIZE	1024							// Maximum number of queued events
 
 //	DOUT (Digital Output) subsystem
 //	The DATAPixx has 24 TTL outputs.
@@ -304,6 +345,7 @@ int			DPxIsDinLogTimetags(void);								// Returns non-0 if buffered datasets ar
 void		DPxEnableDinLogEvents(void);							// Each DIN transition is automatically logged (no schedule is required.  Best way to log response buttons)
 void		DPxDisableDinLogEvents(void);							// Disable automatic logging of DIN transitions
 int			DPxIsDinLogEvents(void);								// Returns non-0 if DIN transitions are being logged to RAM buffer
+void		DPxDecodeDinBuff(void* buffer, int nFrames, int timetagged, double* timeSecs, UInt16* dinValues);	// Convert DIN RAM buffer data read with DPxReadRam() into arrays of timetag seconds and DIN values
 
 //	TOUCHPixx Subsystem	
 
@@ -517,6 +559,7 @@ int			DPxGetVidMode(void);									// Get the video processing mode
 void		DPxSetVidClut(UInt16* clutData);						// Pass 256*3 (=768) 16-bit video DAC data, in order R0,G0,B0,R1,G1,B1...
 																	// DPxSetVidClut() returns immediately, and CLUT is implemented at next vertical blanking interval.
 void		DPxSetVidCluts(UInt16* clutData);						// Pass 512*3 (=1536) 16-bit video DAC data to fill 2 channel CLUTs with independent data, in order R0,G0,B0,R1,G1,B1...
+int			DPxPlayVidClutSequence(UInt16* clutData, int nFrames, int nEntries, double* frameTimes, int* frameSlips);	// Write a sequence of nFrames 256/512-entry CLUTs, one per video frame.  Returns number of late CLUTs.
 void		DPxEnableVidHorizSplit(void);							// VGA 1 shows left half of video image, VGA 2 shows right half of video image.  The two VGA outputs are perfectly synchronized.
 void		DPxDisableVidHorizSplit(void);							// VGA 1 and VGA 2 both show entire video image (hardware video mirroring)
 void		DPxAutoVidHorizSplit(void);								// DATAPixx will automatically split video across the two VGA outputs if the horizontal resolution is at least twice the vertical resolution (default mode)
@@ -532,7 +575,8 @@ void		DPxDisableVidHorizOverlay(void);						// Horizontal overlay is disabled
 int			DPxIsVidHorizOverlay(void);								// Returns non-0 if the left/right halves of the video image are being overlayed
 void		DPxSetVidHorizOverlayBounds(int X1, int Y1, int X2, int Y2); // Set bounding rectangle within left half image whose contents are composited with right half image
 void		DPxGetVidHorizOverlayBounds(int* X1, int* Y1, int* X2, int* Y2); // Get bounding rectangle of horizontal overlay window
-void		DPxSetVidHorizOverlayAlpha(UInt16* alphaData);			// Set 1024 16-bit video horizontal overlay alpha values, in order X0,X1..X511,Y0,Y1...Y511
+void		DPxSetVidHorizOverlayAlpha(UInt16* alphaData);			// Set 1024 16-bit video horizontal overlay alpha values, in order X0,X1..X511,Y0,Y1...Y511.  Not re-sent if unchanged.
+int			DPxWriteVidHorizOverlayAfterVideoSync(UInt16* alphaData);	// Write modified registers (eg: overlay bounds) and changed alpha values together on next vertical sync.  Returns immediately.  Returns non-0 if alpha values were sent.
 int			DPxGetVidHTotal(void);									// Get number of video dot times in one horizontal scan line (includes horizontal blanking interval)
 int			DPxGetVidVTotal(void);									// Get number of video lines in one vertical frame (includes vertical blanking interval)
 int			DPxGetVidHActive(void);									// Get number of visible pixels in one horizontal scan line
@@ -581,7 +625,53 @@ int         DPxGetVidSource(void);                                  // Get sourc
 void        DPxEnableVidScanningBacklight(void);                    // Enable VIEWPixx scanning backlight
 void        DPxDisableVidScanningBacklight(void);                   // Disable VIEWPixx scanning backlight
 int         DPxIsVidScanningBacklight(void);                        // Returns non-0 if VIEWPixx scanning backlight is enabled
-void        DPxVideoScope(int toFile);                              // VIEWPixx video source analysis
+
+//	Video scope
+//	The VIEWPixx can grab its raw video input, including blanking and sync signals, into DATAPixx RAM.
+//	Each scope sample holds one pixel pair, so horizontal lengths are in pixel pairs, and vertical lengths are in lines.
+//	DPxAnalyzeVideoScope() grabs DPX_VID_SCOPE_FRAMES frames, and checks them against the video timing which the device measures.
+//	The result can be checked by software, instead of parsing the text printed by DPxVideoScope().
+//
+typedef struct {
+	int			nominal;			// Expected length, or the first measured length if the expected length is unknown
+	int			count;				// Number of measured segments
+	int			errors;				// Number of segments whose length differs from nominal
+	int			min;				// Shortest measured length, or -1 if count is 0
+	int			max;				// Longest measured length, or -1 if count is 0
+	double		mean;				// Mean measured length
+} DPxVideoScopeSegment;
+
+typedef struct {
+	int			hActive, hFrontPorch, hSync, hBackPorch, hTotal;	// Expected horizontal lengths in pixel pairs, or -1 if unknown
+	int			vActive, vFrontPorch, vSync, vBackPorch, vTotal;	// Expected vertical lengths in lines, or -1 if unknown
+} DPxVideoScopeTiming;
+
+typedef struct {
+	int						status;				// DPX_SUCCESS, or a DPX_ERR_VID_SCOPE_* error
+	int						nFrames;			// Number of complete frames analyzed
+	int						firstFrameSample;	// Index of the first sample of the first analyzed frame, or -1 if none was found
+	DPxVideoScopeSegment	frame;				// Frame lengths in samples
+	DPxVideoScopeSegment	hActive;			// Horizontal lengths in samples
+	DPxVideoScopeSegment	hFrontPorch;
+	DPxVideoScopeSegment	hSync;
+	DPxVideoScopeSegment	hBackPorch;
+	DPxVideoScopeSegment	hTotal;
+	DPxVideoScopeSegment	vFrontPorch;		// Vertical lengths in lines
+	DPxVideoScopeSegment	vSync;
+	DPxVideoScopeSegment	vBackPorch;
+	int						vSyncStartPhaseMin, vSyncStartPhaseMax;	// Samples from the latest HSYNC leading edge to VSYNC leading edges
+	int						vSyncEndPhaseMin, vSyncEndPhaseMax;		// Samples from the latest HSYNC leading edge to VSYNC trailing edges
+	double					hiddenRed, hiddenGreen, hiddenBlue;		// Number of non-0 colour components received during blanking
+	int						lineBuffErrors;		// Number of pixel pairs of the first line which differ from DPxGetVidLine, or -1 if not checked
+} DPxVideoScopeResult;
+
+#define DPX_VID_SCOPE_FRAMES	10									// Number of frames analyzed by DPxAnalyzeVideoScope()
+#define DPX_VID_SCOPE_REGION	"vidScope"							// RAM region reserved from address 0 while DPxAnalyzeVideoScope() grabs frames
+void		DPxGetVideoScopeTiming(DPxVideoScopeTiming* timing);	// Get the expected scope timing from the video timing measured by the device.  Porch and sync lengths are -1.
+int			DPxAnalyzeVideoScopeBuff(void* buffer, int nSamples, DPxVideoScopeTiming* timing, int nFrames, DPxVideoScopeResult* result);	// Analyze nFrames frames of scope samples already on the host.  Returns result->status.
+int			DPxAnalyzeVideoScope(DPxVideoScopeResult* result);		// Grab and analyze DPX_VID_SCOPE_FRAMES frames of video input.  Returns result->status.
+void		DPxPrintVideoScopeResult(DPxVideoScopeResult* result, int toFile);	// Print a video scope result to stdout, or to listing.txt if toFile is non-0
+void        DPxVideoScope(int toFile);                              // VIEWPixx video source analysis, printed to stdout or listing.txt
 
 //	-If an API function detects an error, it will assign a unique error code to a global error variable.
 //	This strategy permits DPxGet*() functions to conveniently return requested values directly,
@@ -610,6 +700,56 @@ void		DPxRestoreRegs(void);									// Write the local copy back to the DATAPixx
 void		DPxStopAllScheds(void);									// Shortcut to stop running all DAC/ADC/DOUT/DIN/AUD/AUX/MIC schedules
 
 
+//	Schedule groups
+//	Each DPxStart*Sched() / DPxStop*Sched() sets bits in the one-shot DPXREG_SCHED_STARTSTOP register.
+//	A schedule group starts several schedules with a single write of that register,
+//	so that all of them start on the same clock tick.
+//	Typical usage steps are:
+//		-Configure each schedule as usual with DPxSet*Buff() and DPxSet*Sched(); these only modify the local register cache
+//		-DPxStartSchedGroup() with an OR of DPX_SCHED_GROUP_* flags, optionally gated on vertical sync or pixel sync
+//		-The returned nanosecond time is latched by the same USB message which starts the group
+//
+void		DPxSetSchedGroupStart(int schedMask);					// Set start bits for all schedules in schedMask.  Written by the next register write.
+void		DPxSetSchedGroupStop(int schedMask);					// Set stop bits for all schedules in schedMask.  Written by the next register write.
+void		DPxStartSchedGroup(int schedMask, unsigned *nanoHigh32, unsigned *nanoLow32);	// Start all schedules in schedMask now, and get the nanosecond start time
+void		DPxStartSchedGroupAfterVideoSync(int schedMask, unsigned *nanoHigh32, unsigned *nanoLow32);	// Like DPxStartSchedGroup, but starts on leading edge of next vertical sync pulse
+void		DPxStartSchedGroupAfterPixelSync(int schedMask, int nPixels, unsigned char* pixelData, int timeout, unsigned *nanoHigh32, unsigned *nanoLow32);	// Like DPxStartSchedGroup, but waits for a pixel sync sequence
+																	// schedMask is an OR of the following predefined constants:
+#define DPX_SCHED_GROUP_DAC		0x0001								//		DAC schedule
+#define DPX_SCHED_GROUP_ADC		0x0002								//		ADC schedule
+#define DPX_SCHED_GROUP_DOUT	0x0004								//		DOUT schedule
+#define DPX_SCHED_GROUP_DIN		0x0008								//		DIN schedule
+#define DPX_SCHED_GROUP_AUD		0x0010								//		AUD schedule
+#define DPX_SCHED_GROUP_AUX		0x0020								//		AUX schedule
+#define DPX_SCHED_GROUP_MIC		0x0040								//		MIC schedule
+#define DPX_SCHED_GROUP_ALL		0x007F								//		All of the above
+
+
+//	RAM region allocator
+//	Hands out named, non-overlapping blocks of DATAPixx RAM, so that DAC, ADC, DIN, AUD and scratch buffers can't collide,
+//	and several stimulus sets can stay resident in RAM at the same time.
+//	The region table lives on the host; it is not cleared by DPxOpen()/DPxClose().
+//	Typical usage steps are:
+//		-DPxAllocRam("dacStim", nBytes, 0, DPX_SCHED_GROUP_DAC) allocates a region and assigns it to the DAC schedule buffer
+//		-DPxAllocRam("stimB", nBytes, 0, 0) allocates a scratch region; use DPxGetRamRegionAddr("stimB") with DPxWriteRam() and DPxSet*Buff()
+//		-DPxFreeRam() releases a region, and DPxDefragRam() packs the remaining regions together once all schedules have stopped
+//
+unsigned	DPxAllocRam(char* name, unsigned size, unsigned alignment, int sched);	// Allocate a named RAM region, and return its address, or DPX_RAM_ADDR_INVALID on failure.  sched is 0 or one DPX_SCHED_GROUP_* flag.
+void		DPxFreeRam(char* name);									// Release a RAM region
+void		DPxFreeAllRam(void);									// Release all RAM regions
+unsigned	DPxGetRamRegionAddr(char* name);						// Get start address of a RAM region, or DPX_RAM_ADDR_INVALID if there is no such region
+unsigned	DPxGetRamRegionSize(char* name);						// Get number of bytes in a RAM region
+int			DPxGetRamRegionSched(char* name);						// Get DPX_SCHED_GROUP_* flag of a RAM region, or 0 for a scratch region
+int			DPxGetNumRamRegions(void);								// Get number of allocated RAM regions
+void		DPxGetRamRegionName(int index, char* name);				// Copy name of a RAM region into a DPX_RAM_REGION_NAME_MAX+1 char buffer.  Regions are indexed in address order.
+unsigned	DPxGetRamFreeSize(void);								// Get total number of unallocated RAM bytes
+unsigned	DPxGetRamLargestFreeSize(void);							// Get size of largest contiguous block of unallocated RAM
+void		DPxDefragRam(void);										// Move all RAM regions down to address 0, and rebind schedule buffers.  All schedules must be stopped.
+#define DPX_RAM_REGION_MAX		64									// Maximum number of RAM regions
+#define DPX_RAM_REGION_NAME_MAX	31									// Maximum number of characters in a RAM region name
+#define DPX_RAM_ADDR_INVALID	0xFFFFFFFF							// Returned instead of an address when there is no RAM region.  0 is a valid address.
+
+
 //	-API global error codes
 //	Pretty much each API function usage error sets a unique global error code for easier debugging of user apps
 #define DPX_SUCCESS								0		// Function executed successfully
@@ -660,6 +800,15 @@ void		DPxStopAllScheds(void);									// Shortcut to stop running all DAC/ADC/DO
 #define DPX_ERR_RAM_READ_TOO_HIGH				-1409	// RAM read block exceeds end of DATAPixx memory
 #define DPX_ERR_RAM_READ_BUFFER_NULL			-1410	// RAM read destination buffer pointer is null
 #define DPX_ERR_RAM_READ_USB_ERROR				-1411	// A USB error occurred while reading the RAM buffer
+#define DPX_ERR_RAM_ALLOC_BAD_NAME				-1412	// RAM region name is null, empty, or too long
+#define DPX_ERR_RAM_ALLOC_NAME_EXISTS			-1413	// A RAM region with the same name has already been allocated
+#define DPX_ERR_RAM_ALLOC_BAD_SIZE				-1414	// RAM region size must be a non-0 even number
+#define DPX_ERR_RAM_ALLOC_BAD_ALIGN				-1415	// RAM region alignment must be an even power of 2
+#define DPX_ERR_RAM_ALLOC_BAD_SCHED				-1416	// RAM region sched must be 0 or a single DPX_SCHED_GROUP_* flag
+#define DPX_ERR_RAM_ALLOC_TOO_MANY				-1417	// DPX_RAM_REGION_MAX regions have already been allocated
+#define DPX_ERR_RAM_ALLOC_NO_SPACE				-1418	// There is no free block of RAM large enough for the region
+#define DPX_ERR_RAM_REGION_UNKNOWN				-1419	// No RAM region has the requested name or index
+#define DPX_ERR_RAM_DEFRAG_BUSY					-1420	// RAM regions cannot be moved while a schedule is running
 
 #define DPX_ERR_DAC_SET_BAD_CHANNEL				-1500	// Valid channels are 0-3
 #define DPX_ERR_DAC_SET_BAD_VALUE				-1501	// Value falls outside DAC's output range
@@ -694,6 +843,12 @@ void		DPxStopAllScheds(void);									// Shortcut to stop running all DAC/ADC/DO
 #define DPX_ERR_ADC_BUFF_TOO_BIG				-1613	// The requested buffer is larger than the DATAPixx RAM
 #define DPX_ERR_ADC_SCHED_TOO_FAST				-1614	// The requested schedule rate is too fast
 #define DPX_ERR_ADC_SCHED_BAD_RATE_UNITS		-1615	// Unnrecognized schedule rate units parameter
+#define DPX_ERR_ADC_DECODE_BAD_ARGS				-1616	// nFrames must not be negative, and nChans must be 1-16
+#define DPX_ERR_ADC_DECODE_NULL_PTR				-1617	// The buffer to decode is null
+#define DPX_ERR_ADC_EVENT_BAD_CHANNEL			-1618	// Valid event trigger channels are 0-15
+#define DPX_ERR_ADC_EVENT_BAD_MODE				-1619	// Unrecognized event trigger mode
+#define DPX_ERR_ADC_EVENT_BAD_EDGE				-1620	// Unrecognized event trigger edge, or negative hysteresis
+#define DPX_ERR_ADC_EVENT_NO_TIMETAGS			-1621	// Event polling requires ADC timetag logging
 
 #define DPX_ERR_DOUT_SET_BAD_MASK				-1700	// Valid masks set bits 23 downto 0
 #define DPX_ERR_DOUT_BUFF_ODD_BASEADDR			-1701	// An odd buffer base was requested
@@ -719,6 +874,8 @@ void		DPxStopAllScheds(void);									// Shortcut to stop running all DAC/ADC/DO
 #define DPX_ERR_DIN_SCHED_TOO_FAST				-1809	// The requested schedule rate is too fast
 #define DPX_ERR_DIN_SCHED_BAD_RATE_UNITS		-1810	// Unnrecognized schedule rate units parameter
 #define DPX_ERR_DIN_BAD_STRENGTH				-1811	// Strength is in the range 0-1
+#define DPX_ERR_DIN_DECODE_BAD_ARGS				-1812	// nFrames must not be negative
+#define DPX_ERR_DIN_DECODE_NULL_PTR				-1813	// The buffer to decode is null
 
 #define DPX_ERR_AUD_SET_BAD_VALUE				-1900	// Value falls outside AUD's output range
 #define DPX_ERR_AUD_SET_BAD_VOLUME				-1901	// Valid volumes are in the range 0-1
@@ -771,6 +928,13 @@ void		DPxStopAllScheds(void);									// Shortcut to stop running all DAC/ADC/DO
 #define DPX_ERR_VID_BASEADDR_ALIGN_ERROR		-2109	// The requested base address was not aligned on a 64kB boundary
 #define DPX_ERR_VID_BASEADDR_TOO_HIGH           -2110	// The requested base address exceeds the DATAPixx RAM
 #define DPX_ERR_VID_VSYNC_WITHOUT_VIDEO         -2111   // The API was told to block until VSYNC; but DATAPixx is not receiving any video
+#define DPX_ERR_VID_CLUT_SEQ_BAD_ARGS			-2112	// CLUT sequence is null, or nFrames < 1, or nEntries is not 256 or 512
+#define DPX_ERR_VID_SCOPE_BAD_ARGS				-2113	// Video scope buffer or timing is null, nSamples < 2, or nFrames < 1
+#define DPX_ERR_VID_SCOPE_NO_FRAME				-2114	// No VSYNC followed by active video was found in the video scope buffer
+#define DPX_ERR_VID_SCOPE_TOO_FEW_FRAMES		-2115	// The video scope buffer ended before the requested number of frames
+#define DPX_ERR_VID_SCOPE_RAM_IN_USE			-2116	// The video scope grab would overwrite an allocated RAM region
+
+#define DPX_ERR_SCHED_GROUP_BAD_MASK			-2200	// Schedule group mask is empty or contains unrecognized DPX_SCHED_GROUP_* flags
 
 // Convenient target macro.
 // Note that something like "#define TARGET_WINDOWS (defined(_MSC_VER) || defined(WIN_BUILD))" does not work.
@@ -982,6 +982,8 @@ void			DPxBuildUsbMsgWriteRegs(void);					// Append USB message to write modifie
 void			DPxBuildUsbMsgReadRegs(void);					// Append composite USB message to read Datapixx register set
 void			DPxBuildUsbMsgVideoSync(void);					// Append message to freeze Datapixx USB message treatment until vertical sync
 void			DPxBuildUsbMsgPixelSync(int nPixels, unsigned char* pixelData, int timeout); // Append message to freeze USB message treatment until pixel sync
+void			DPxBuildUsbMsgVidClut(UInt16* clutData, int nEntries);	// Append message to write a 256 or 512 entry video CLUT
+void			DPxBuildUsbMsgVidHorizOverlayAlpha(UInt16* alphaData);	// Append message to write 1024 video horizontal overlay alpha values
 void			DPxBuildUsbMsgEnd(void);						// Transmit the composite USB message we just built
 
 void			DPxSetReg16(int regAddr, int regValue);			// Set a 16-bit register's value in dpRegisterCache[]
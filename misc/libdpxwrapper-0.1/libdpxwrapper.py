@@ -8,6 +8,53 @@ elif platform.system() == "Linux":
 else:
     raise Exception("your operating system is currently not supported")
 
+
+class DPxVideoScopeSegment(Structure):
+    _fields_ = [
+        ("nominal", c_int),
+        ("count", c_int),
+        ("errors", c_int),
+        ("min", c_int),
+        ("max", c_int),
+        ("mean", c_double),
+    ]
+
+
+class DPxVideoScopeTiming(Structure):
+    _fields_ = [
+        (name, c_int)
+        for name in (
+            "hActive", "hFrontPorch", "hSync", "hBackPorch", "hTotal",
+            "vActive", "vFrontPorch", "vSync", "vBackPorch", "vTotal",
+        )
+    ]
+
+
+class DPxVideoScopeResult(Structure):
+    _fields_ = [
+        ("status", c_int),
+        ("nFrames", c_int),
+        ("firstFrameSample", c_int),
+        ("frame", DPxVideoScopeSegment),
+        ("hActive", DPxVideoScopeSegment),
+        ("hFrontPorch", DPxVideoScopeSegment),
+        ("hSync", DPxVideoScopeSegment),
+        ("hBackPorch", DPxVideoScopeSegment),
+        ("hTotal", DPxVideoScopeSegment),
+        ("vFrontPorch", DPxVideoScopeSegment),
+        ("vSync", DPxVideoScopeSegment),
+        ("vBackPorch", DPxVideoScopeSegment),
+        ("vSyncStartPhaseMin", c_int),
+        ("vSyncStartPhaseMax", c_int),
+        ("vSyncEndPhaseMin", c_int),
+        ("vSyncEndPhaseMax", c_int),
+        ("hiddenRed", c_double),
+        ("hiddenGreen", c_double),
+        ("hiddenBlue", c_double),
+        ("lineBuffErrors", c_int),
+    ]
+
+
 DPxOpen = lib_handle.DPxOpen
 DPxOpen.restype = None
 DPxOpen.argtypes = []
@@ -35,6 +82,24 @@ DPxGetWriteRamBuffAddr.argtypes = []
 DPxGetWriteRamBuffSize = lib_handle.DPxGetWriteRamBuffSize
 DPxGetWriteRamBuffSize.restype = c_int
 DPxGetWriteRamBuffSize.argtypes = []
+DPxEnableRamShadow = lib_handle.DPxEnableRamShadow
+DPxEnableRamShadow.restype = None
+DPxEnableRamShadow.argtypes = []
+DPxDisableRamShadow = lib_handle.DPxDisableRamShadow
+DPxDisableRamShadow.restype = None
+DPxDisableRamShadow.argtypes = []
+DPxIsRamShadow = lib_handle.DPxIsRamShadow
+DPxIsRamShadow.restype = c_int
+DPxIsRamShadow.argtypes = []
+DPxInvalidateRamShadow = lib_handle.DPxInvalidateRamShadow
+DPxInvalidateRamShadow.restype = None
+DPxInvalidateRamShadow.argtypes = [c_uint, c_uint]
+DPxGetRamShadowBytesSent = lib_handle.DPxGetRamShadowBytesSent
+DPxGetRamShadowBytesSent.restype = c_double
+DPxGetRamShadowBytesSent.argtypes = []
+DPxGetRamShadowBytesSkipped = lib_handle.DPxGetRamShadowBytesSkipped
+DPxGetRamShadowBytesSkipped.restype = c_double
+DPxGetRamShadowBytesSkipped.argtypes = []
 DPxWriteRegCache = lib_handle.DPxWriteRegCache
 DPxWriteRegCache.restype = None
 DPxWriteRegCache.argtypes = []
@@ -347,6 +412,33 @@ DPxDisableAdcLogTimetags.argtypes = []
 DPxIsAdcLogTimetags = lib_handle.DPxIsAdcLogTimetags
 DPxIsAdcLogTimetags.restype = c_int
 DPxIsAdcLogTimetags.argtypes = []
+DPxDecodeAdcBuff = lib_handle.DPxDecodeAdcBuff
+DPxDecodeAdcBuff.restype = None
+DPxDecodeAdcBuff.argtypes = [c_void_p, c_int, c_int, POINTER(c_int), c_int, POINTER(c_double), POINTER(c_float)]
+DPxSetAdcEventTrigger = lib_handle.DPxSetAdcEventTrigger
+DPxSetAdcEventTrigger.restype = None
+DPxSetAdcEventTrigger.argtypes = [c_int, c_int, c_int, c_double, c_double]
+DPxClearAdcEventTrigger = lib_handle.DPxClearAdcEventTrigger
+DPxClearAdcEventTrigger.restype = None
+DPxClearAdcEventTrigger.argtypes = [c_int]
+DPxResetAdcEvents = lib_handle.DPxResetAdcEvents
+DPxResetAdcEvents.restype = None
+DPxResetAdcEvents.argtypes = []
+DPxProcessAdcEvents = lib_handle.DPxProcessAdcEvents
+DPxProcessAdcEvents.restype = c_int
+DPxProcessAdcEvents.argtypes = [c_void_p, c_int, c_int, POINTER(c_int)]
+DPxPollAdcEvents = lib_handle.DPxPollAdcEvents
+DPxPollAdcEvents.restype = c_int
+DPxPollAdcEvents.argtypes = []
+DPxGetNumAdcEvents = lib_handle.DPxGetNumAdcEvents
+DPxGetNumAdcEvents.restype = c_int
+DPxGetNumAdcEvents.argtypes = []
+DPxGetAdcEvent = lib_handle.DPxGetAdcEvent
+DPxGetAdcEvent.restype = c_int
+DPxGetAdcEvent.argtypes = [POINTER(c_int), POINTER(c_int), POINTER(c_double)]
+DPxGetAdcEventsDropped = lib_handle.DPxGetAdcEventsDropped
+DPxGetAdcEventsDropped.restype = c_uint
+DPxGetAdcEventsDropped.argtypes = []
 DPxGetDoutNumBits = lib_handle.DPxGetDoutNumBits
 DPxGetDoutNumBits.restype = c_int
 DPxGetDoutNumBits.argtypes = []
@@ -554,6 +646,9 @@ DPxDisableDinLogEvents.argtypes = []
 DPxIsDinLogEvents = lib_handle.DPxIsDinLogEvents
 DPxIsDinLogEvents.restype = c_int
 DPxIsDinLogEvents.argtypes = []
+DPxDecodeDinBuff = lib_handle.DPxDecodeDinBuff
+DPxDecodeDinBuff.restype = None
+DPxDecodeDinBuff.argtypes = [c_void_p, c_int, c_int, POINTER(c_double), POINTER(c_uint16)]
 DPxIsTouchpixx = lib_handle.DPxIsTouchpixx
 DPxIsTouchpixx.restype = c_int
 DPxIsTouchpixx.argtypes = []
@@ -893,6 +988,9 @@ DPxSetVidClut.argtypes = [POINTER(c_uint16)]
 DPxSetVidCluts = lib_handle.DPxSetVidCluts
 DPxSetVidCluts.restype = None
 DPxSetVidCluts.argtypes = [POINTER(c_uint16)]
+DPxPlayVidClutSequence = lib_handle.DPxPlayVidClutSequence
+DPxPlayVidClutSequence.restype = c_int
+DPxPlayVidClutSequence.argtypes = [POINTER(c_uint16), c_int, c_int, POINTER(c_double), POINTER(c_int)]
 DPxEnableVidHorizSplit = lib_handle.DPxEnableVidHorizSplit
 DPxEnableVidHorizSplit.restype = None
 DPxEnableVidHorizSplit.argtypes = []
@@ -940,6 +1038,9 @@ DPxGetVidHorizOverlayBounds.argtypes = [
 DPxSetVidHorizOverlayAlpha = lib_handle.DPxSetVidHorizOverlayAlpha
 DPxSetVidHorizOverlayAlpha.restype = None
 DPxSetVidHorizOverlayAlpha.argtypes = [POINTER(c_uint16)]
+DPxWriteVidHorizOverlayAfterVideoSync = lib_handle.DPxWriteVidHorizOverlayAfterVideoSync
+DPxWriteVidHorizOverlayAfterVideoSync.restype = c_int
+DPxWriteVidHorizOverlayAfterVideoSync.argtypes = [POINTER(c_uint16)]
 DPxGetVidHTotal = lib_handle.DPxGetVidHTotal
 DPxGetVidHTotal.restype = c_int
 DPxGetVidHTotal.argtypes = []
@@ -1045,6 +1146,18 @@ DPxDisableVidScanningBacklight.argtypes = []
 DPxIsVidScanningBacklight = lib_handle.DPxIsVidScanningBacklight
 DPxIsVidScanningBacklight.restype = c_int
 DPxIsVidScanningBacklight.argtypes = []
+DPxGetVideoScopeTiming = lib_handle.DPxGetVideoScopeTiming
+DPxGetVideoScopeTiming.restype = None
+DPxGetVideoScopeTiming.argtypes = [POINTER(DPxVideoScopeTiming)]
+DPxAnalyzeVideoScopeBuff = lib_handle.DPxAnalyzeVideoScopeBuff
+DPxAnalyzeVideoScopeBuff.restype = c_int
+DPxAnalyzeVideoScopeBuff.argtypes = [c_void_p, c_int, POINTER(DPxVideoScopeTiming), c_int, POINTER(DPxVideoScopeResult)]
+DPxAnalyzeVideoScope = lib_handle.DPxAnalyzeVideoScope
+DPxAnalyzeVideoScope.restype = c_int
+DPxAnalyzeVideoScope.argtypes = [POINTER(DPxVideoScopeResult)]
+DPxPrintVideoScopeResult = lib_handle.DPxPrintVideoScopeResult
+DPxPrintVideoScopeResult.restype = None
+DPxPrintVideoScopeResult.argtypes = [POINTER(DPxVideoScopeResult), c_int]
 DPxVideoScope = lib_handle.DPxVideoScope
 DPxVideoScope.restype = None
 DPxVideoScope.argtypes = [c_int]
@@ -1072,6 +1185,74 @@ DPxRestoreRegs.argtypes = []
 DPxStopAllScheds = lib_handle.DPxStopAllScheds
 DPxStopAllScheds.restype = None
 DPxStopAllScheds.argtypes = []
+DPxSetSchedGroupStart = lib_handle.DPxSetSchedGroupStart
+DPxSetSchedGroupStart.restype = None
+DPxSetSchedGroupStart.argtypes = [c_int]
+DPxSetSchedGroupStop = lib_handle.DPxSetSchedGroupStop
+DPxSetSchedGroupStop.restype = None
+DPxSetSchedGroupStop.argtypes = [c_int]
+DPxStartSchedGroup = lib_handle.DPxStartSchedGroup
+DPxStartSchedGroup.restype = None
+DPxStartSchedGroup.argtypes = [c_int, POINTER(c_int), POINTER(c_int)]
+DPxStartSchedGroupAfterVideoSync = lib_handle.DPxStartSchedGroupAfterVideoSync
+DPxStartSchedGroupAfterVideoSync.restype = None
+DPxStartSchedGroupAfterVideoSync.argtypes = [c_int, POINTER(c_int), POINTER(c_int)]
+DPxStartSchedGroupAfterPixelSync = lib_handle.DPxStartSchedGroupAfterPixelSync
+DPxStartSchedGroupAfterPixelSync.restype = None
+DPxStartSchedGroupAfterPixelSync.argtypes = [c_int, c_int, POINTER(c_ubyte), c_int, POINTER(c_int), POINTER(c_int)]
+DPxAllocRam = lib_handle.DPxAllocRam
+DPxAllocRam.restype = c_uint
+DPxAllocRam.argtypes = [c_char_p, c_uint, c_uint, c_int]
+DPxFreeRam = lib_handle.DPxFreeRam
+DPxFreeRam.restype = None
+DPxFreeRam.argtypes = [c_char_p]
+DPxFreeAllRam = lib_handle.DPxFreeAllRam
+DPxFreeAllRam.restype = None
+DPxFreeAllRam.argtypes = []
+DPxGetRamRegionAddr = lib_handle.DPxGetRamRegionAddr
+DPxGetRamRegionAddr.restype = c_uint
+DPxGetRamRegionAddr.argtypes = [c_char_p]
+DPxGetRamRegionSize = lib_handle.DPxGetRamRegionSize
+DPxGetRamRegionSize.restype = c_uint
+DPxGetRamRegionSize.argtypes = [c_char_p]
+DPxGetRamRegionSched = lib_handle.DPxGetRamRegionSched
+DPxGetRamRegionSched.restype = c_int
+DPxGetRamRegionSched.argtypes = [c_char_p]
+DPxGetNumRamRegions = lib_handle.DPxGetNumRamRegions
+DPxGetNumRamRegions.restype = c_int
+DPxGetNumRamRegions.argtypes = []
+DPxGetRamRegionName = lib_handle.DPxGetRamRegionName
+DPxGetRamRegionName.restype = None
+DPxGetRamRegionName.argtypes = [c_int, c_char_p]
+DPxGetRamFreeSize = lib_handle.DPxGetRamFreeSize
+DPxGetRamFreeSize.restype = c_uint
+DPxGetRamFreeSize.argtypes = []
+DPxGetRamLargestFreeSize = lib_handle.DPxGetRamLargestFreeSize
+DPxGetRamLargestFreeSize.restype = c_uint
+DPxGetRamLargestFreeSize.argtypes = []
+DPxDefragRam = lib_handle.DPxDefragRam
+DPxDefragRam.restype = None
+DPxDefragRam.argtypes = []
+DPX_SCHED_GROUP_DAC = 0x0001
+DPX_SCHED_GROUP_ADC = 0x0002
+DPX_SCHED_GROUP_DOUT = 0x0004
+DPX_SCHED_GROUP_DIN = 0x0008
+DPX_SCHED_GROUP_AUD = 0x0010
+DPX_SCHED_GROUP_AUX = 0x0020
+DPX_SCHED_GROUP_MIC = 0x0040
+DPX_SCHED_GROUP_ALL = 0x007F
+DPX_RAM_REGION_MAX = 64
+DPX_RAM_REGION_NAME_MAX = 31
+DPX_RAM_ADDR_INVALID = 0xFFFFFFFF
+DPX_RAM_SHADOW_PAGE_SIZE = 4096
+DPX_ADC_EVENT_LEVEL = 0
+DPX_ADC_EVENT_SLOPE = 1
+DPX_ADC_EVENT_RISING = 1
+DPX_ADC_EVENT_FALLING = 2
+DPX_ADC_EVENT_BOTH = 3
+DPX_ADC_EVENT_QUEUE_SIZE = 1024
+DPX_VID_SCOPE_FRAMES = 10
+DPX_VID_SCOPE_REGION = b"vidScope"
 DPX_SUCCESS = 0
 DPX_FAIL = -1
 DPX_ERR_USB_NO_DATAPIXX = -1000
@@ -1115,6 +1296,15 @@ DPX_ERR_RAM_READ_LEN_ODD = -1408
 DPX_ERR_RAM_READ_TOO_HIGH = -1409
 DPX_ERR_RAM_READ_BUFFER_NULL = -1410
 DPX_ERR_RAM_READ_USB_ERROR = -1411
+DPX_ERR_RAM_ALLOC_BAD_NAME = -1412
+DPX_ERR_RAM_ALLOC_NAME_EXISTS = -1413
+DPX_ERR_RAM_ALLOC_BAD_SIZE = -1414
+DPX_ERR_RAM_ALLOC_BAD_ALIGN = -1415
+DPX_ERR_RAM_ALLOC_BAD_SCHED = -1416
+DPX_ERR_RAM_ALLOC_TOO_MANY = -1417
+DPX_ERR_RAM_ALLOC_NO_SPACE = -1418
+DPX_ERR_RAM_REGION_UNKNOWN = -1419
+DPX_ERR_RAM_DEFRAG_BUSY = -1420
 DPX_ERR_DAC_SET_BAD_CHANNEL = -1500
 DPX_ERR_DAC_SET_BAD_VALUE = -1501
 DPX_ERR_DAC_GET_BAD_CHANNEL = -1502
@@ -1147,6 +1337,12 @@ DPX_ERR_ADC_BUFF_ODD_SIZE = -1612
 DPX_ERR_ADC_BUFF_TOO_BIG = -1613
 DPX_ERR_ADC_SCHED_TOO_FAST = -1614
 DPX_ERR_ADC_SCHED_BAD_RATE_UNITS = -1615
+DPX_ERR_ADC_DECODE_BAD_ARGS = -1616
+DPX_ERR_ADC_DECODE_NULL_PTR = -1617
+DPX_ERR_ADC_EVENT_BAD_CHANNEL = -1618
+DPX_ERR_ADC_EVENT_BAD_MODE = -1619
+DPX_ERR_ADC_EVENT_BAD_EDGE = -1620
+DPX_ERR_ADC_EVENT_NO_TIMETAGS = -1621
 DPX_ERR_DOUT_SET_BAD_MASK = -1700
 DPX_ERR_DOUT_BUFF_ODD_BASEADDR = -1701
 DPX_ERR_DOUT_BUFF_BASEADDR_TOO_HIGH = -1702
@@ -1170,6 +1366,8 @@ DPX_ERR_DIN_BUFF_TOO_BIG = -1808
 DPX_ERR_DIN_SCHED_TOO_FAST = -1809
 DPX_ERR_DIN_SCHED_BAD_RATE_UNITS = -1810
 DPX_ERR_DIN_BAD_STRENGTH = -1811
+DPX_ERR_DIN_DECODE_BAD_ARGS = -1812
+DPX_ERR_DIN_DECODE_NULL_PTR = -1813
 DPX_ERR_AUD_SET_BAD_VALUE = -1900
 DPX_ERR_AUD_SET_BAD_VOLUME = -1901
 DPX_ERR_AUD_SET_BAD_LRMODE = -1902
@@ -1219,6 +1417,12 @@ DPX_ERR_VID_ALPHA_WRITE_USB_ERROR = -2108
 DPX_ERR_VID_BASEADDR_ALIGN_ERROR = -2109
 DPX_ERR_VID_BASEADDR_TOO_HIGH = -2110
 DPX_ERR_VID_VSYNC_WITHOUT_VIDEO = -2111
+DPX_ERR_VID_CLUT_SEQ_BAD_ARGS = -2112
+DPX_ERR_VID_SCOPE_BAD_ARGS = -2113
+DPX_ERR_VID_SCOPE_NO_FRAME = -2114
+DPX_ERR_VID_SCOPE_TOO_FEW_FRAMES = -2115
+DPX_ERR_VID_SCOPE_RAM_IN_USE = -2116
+DPX_ERR_SCHED_GROUP_BAD_MASK = -2200
 TARGET_WINDOWS = 1
 TARGET_WINDOWS = 0
 DPXREG_VID_CTRL_MODE_C24 = 0x0000
@@ -68,11 +68,15 @@ def get_ctypes_typename(return_type):
         "unsigned": "c_uint",
         "size_t": "c_size_t",
         "void*": "c_void_p",
+        "char*": "c_char_p",
         "unsigned char*": "POINTER(c_ubyte)",
         "unsigned*": "POINTER(c_int)",
         "double*": "POINTER(c_double)",
+        "float*": "POINTER(c_float)",
         "int*": "POINTER(c_int)",
         "UInt16*": "POINTER(c_uint16)",
+        "DPxVideoScopeTiming*": "POINTER(DPxVideoScopeTiming)",
+        "DPxVideoScopeResult*": "POINTER(DPxVideoScopeResult)",
     }
     return type_map[return_type]
 
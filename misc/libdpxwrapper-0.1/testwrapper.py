@@ -41,9 +41,8 @@ DPxEnableDinDebounce()
 
 DPxEnableDinLogTimetags()
 DPxEnableDinLogEvents()
-dinBuffAddr = 0x800000
 dinBuffSize = 0x400000
-DPxSetDinBuff(dinBuffAddr, dinBuffSize)
+dinBuffAddr = DPxAllocRam(b"din", dinBuffSize, 0, DPX_SCHED_GROUP_DIN)
 DPxUpdateRegCache()
 
 # get current video frequency
@@ -69,8 +68,16 @@ raw_input("set back->")
 DPxSetVidMode(DPXREG_VID_CTRL_MODE_C24)  # passthrough
 DPxUpdateRegCache()
 
+# check video input timing
+scope = DPxVideoScopeResult()
+if DPxAnalyzeVideoScope(byref(scope)) == DPX_SUCCESS:
+    print("video scope: %d frames, %d HTOTAL errors" % (scope.nFrames, scope.hTotal.errors))
+else:
+    print("video scope failed:", scope.status)
+
 
 # clean up
 DPxStopAllScheds()
+DPxFreeRam(b"din")
 DPxUpdateRegCache()
 DPxClose()
@@ -0,0 +1,116 @@
+"""Tests for the L48 CLUT calibration patch (ClutSquare)."""
+
+import sys
+from types import ModuleType, SimpleNamespace
+
+import numpy as np
+import pytest
+
+import hrl.graphics.texture
+from hrl.calibration.measurement import ClutSquare, intensity_to_uint16
+
+
+class FakeDevice:
+    def __init__(self, mode="M16"):
+        self.mode = mode
+
+    def getVideoMode(self):
+        return self.mode
+
+    def setVideoMode(self, mode):
+        self.mode = mode
+
+    def updateRegisterCache(self):
+        pass
+
+
+class FakeTexture:
+    def __init__(self, byts, wdth, hght, shape):
+        self.byts = byts
+        self.deleted = False
+
+    def draw(self, pos=None, sz=None, rot=0, rotc=None):
+        pass
+
+    def delete(self):
+        self.deleted = True
+
+
+@pytest.fixture
+def fake_hrl(monkeypatch):
+    monkeypatch.setattr(hrl.graphics.texture, "Texture", FakeTexture)
+    graphics = SimpleNamespace(
+        gamma_correct=lambda img: img,
+        background=np.array([[0.5]]),
+        device=FakeDevice(),
+        width=1024,
+        height=768,
+    )
+    return SimpleNamespace(graphics=graphics)
+
+
+@pytest.mark.parametrize("intensity", [0.0, 0.25, 0.5, 1.0 / 3.0, 1.0])
+def test_intensity_to_uint16_matches_m16(intensity, fake_hrl):
+    """16-bit CLUT value uses the same truncation as the M16 encoder."""
+    expected = int(np.asarray(np.array([[intensity]]) * 65535, dtype=np.uint32).squeeze())
+    assert intensity_to_uint16(fake_hrl, intensity) == expected
+
+
+@pytest.fixture
+def dpx(monkeypatch, fake_dpx):
+    """Fake libdpx, imported by ClutSquare from pypixxlib."""
+    dpx = fake_dpx()
+    pypixxlib = ModuleType("pypixxlib")
+    pypixxlib._libdpx = dpx
+    monkeypatch.setitem(sys.modules, "pypixxlib", pypixxlib)
+    return dpx
+
+
+def test_clut_square_background_and_patch(fake_hrl, dpx):
+    """All CLUT entries hold the background, except the patch index."""
+    # Setup
+    square = ClutSquare(fake_hrl)
+    assert fake_hrl.graphics.device.mode == "L48"
+    assert square.texture.byts[0] == square.index
+
+    # Run
+    square(fake_hrl, 0.75)
+    square(fake_hrl, 0.25)
+
+    # Verify: the last table written holds only the last intensity
+    (first,), (last,) = dpx.args("DPxSetVidClut")
+    assert np.array(first)[0, square.index] == intensity_to_uint16(fake_hrl, 0.75)
+    table = np.array(last)
+    assert np.all(table[:, square.index] == intensity_to_uint16(fake_hrl, 0.25))
+    others = np.delete(table, square.index, axis=1)
+    assert np.all(others == intensity_to_uint16(fake_hrl, 0.5))
+
+
+def test_clut_square_set_intensity_writes_device_clut(fake_hrl, dpx):
+    """set_intensity() sends the whole CLUT, one list per colour channel."""
+    square = ClutSquare(fake_hrl)
+
+    square.set_intensity(0.25)
+
+    assert dpx.names() == ["DPxSetVidClut", "DPxUpdateRegCache"]
+    (data,) = dpx.args("DPxSetVidClut")[0]
+    assert len(data) == 3 and all(len(channel) == 256 for channel in data)
+    assert all(isinstance(value, int) for channel in data for value in channel)
+    table = np.array(data)
+    assert np.all(table[:, square.index] == intensity_to_uint16(fake_hrl, 0.25))
+    assert np.all(np.delete(table, square.index, axis=1) == intensity_to_uint16(fake_hrl, 0.5))
+
+
+def test_clut_square_avoids_background_index(fake_hrl):
+    """Patch index moves away from the CLUT index of the background."""
+    fake_hrl.graphics.background = np.array([[1.0]])
+    square = ClutSquare(fake_hrl)
+    assert square.index == 254
+
+
+def test_clut_square_close_restores_mode(fake_hrl):
+    """Closing restores the previous video mode and deletes the texture."""
+    square = ClutSquare(fake_hrl)
+    square.close()
+    assert fake_hrl.graphics.device.mode == "M16"
+    assert square.texture.deleted
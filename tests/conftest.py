@@ -1,3 +1,8 @@
+import ctypes
+import functools
+import re
+from pathlib import Path
+
 import numpy as np
 import pytest
 
@@ -6,6 +11,9 @@ from hrl.luts import create_clut, create_lut
 # Standard gamma exponent for all gamma-related fixtures and tests
 DEFAULT_GAMMA = 2.2
 
+# ctypes bindings of the vendored libdpx, for the signatures of its functions
+LIBDPX_WRAPPER = Path(__file__).parents[1] / "misc" / "libdpxwrapper-0.1" / "libdpxwrapper.py"
+
 
 def pytest_addoption(parser):
     """Add custom command-line options for pytest."""
@@ -120,3 +128,184 @@ def nonlinear_clut():
         ]
     )
     return create_clut(gamma=DEFAULT_GAMMA, dark_chromaticity=dark, color_matrix=color_matrix)
+
+
+# libdpx functions whose pypixxlib bindings take Python lists for what the
+# ctypes bindings declare as POINTER arguments
+LIBDPX_LIST_ARGUMENTS = {"DPxSetVidClut", "DPxSetVidCluts", "DPxUpdateRegCacheAfterPixelSync"}
+
+
+@functools.lru_cache(maxsize=None)
+def libdpx_argtypes(name):
+    """argtypes which libdpxwrapper.py declares for name, or None if it declares none."""
+    match = re.search(rf"^{name}\.argtypes = \[(.*)\]$", LIBDPX_WRAPPER.read_text(), re.MULTILINE)
+    return None if match is None else eval(f"[{match.group(1)}]", vars(ctypes))
+
+
+def check_libdpx_args(name, args):
+    """Check arguments as the ctypes bindings convert them.
+
+    Raises
+    ------
+    ctypes.ArgumentError
+        if an argument does not convert to its argtype, e.g., a list passed
+        for a POINTER(c_uint16), or a float for a c_int
+    TypeError
+        if the number of arguments differs
+    """
+    argtypes = libdpx_argtypes(name)
+    if argtypes is None:
+        return
+    if len(args) != len(argtypes):
+        raise TypeError(f"{name}() takes {len(argtypes)} arguments ({len(args)} given)")
+
+    for number, (argtype, arg) in enumerate(zip(argtypes, args), start=1):
+        if name in LIBDPX_LIST_ARGUMENTS and issubclass(argtype, ctypes._Pointer):
+            if not isinstance(arg, list):
+                raise ctypes.ArgumentError(f"argument {number}: {name}() takes a list, not {type(arg).__name__}")
+            continue
+        try:
+            argtype.from_param(arg)
+        except TypeError as error:
+            raise ctypes.ArgumentError(f"argument {number}: {name}(): {error}") from None
+
+
+class FakeBindings:
+    """Bindings that record their calls, and simulate them with models.
+
+    A function is called on the first model that defines it; functions no
+    model defines return None, and functions a model sets to None are
+    null. Every call is recorded as (name, args) in calls.
+
+    Parameters
+    ----------
+    *models : object
+        simulations of (part of) a device, with methods named as the
+        functions they simulate
+    missing : iterable of str, optional
+        functions the bindings lack, as in older versions
+    """
+
+    prefix = ""
+
+    def __init__(self, *models, missing=()):
+        self.models = models
+        self.missing = set(missing)
+        self.calls = []
+
+    def __getattr__(self, name):
+        if not name.startswith(self.prefix) or name in self.missing:
+            raise AttributeError(name)
+        model = next((model for model in self.models if hasattr(model, name)), None)
+        impl = None if model is None else getattr(model, name)
+        if model is not None and impl is None:
+            # Model lacks the function, as a null function of PyOpenGL
+            return None
+
+        def call(*args):
+            self.check(name, args)
+            self.calls.append((name, args))
+            return None if impl is None else impl(*args)
+
+        return call
+
+    def check(self, name, args):
+        pass
+
+    def names(self):
+        """Names of all called functions, in order."""
+        return [name for name, _ in self.calls]
+
+    def args(self, name):
+        """Arguments of all calls to a function, in order."""
+        return [args for called, args in self.calls if called == name]
+
+
+class FakeDpx(FakeBindings):
+    """libdpx bindings, which check arguments against the ctypes bindings."""
+
+    prefix = "DPx"
+
+    def check(self, name, args):
+        check_libdpx_args(name, args)
+
+
+class FakeGL(FakeBindings):
+    """OpenGL bindings; constants are 0, unless a model defines them."""
+
+    prefix = "gl"
+
+    def __getattr__(self, name):
+        if name.startswith("GL_"):
+            return next((getattr(model, name) for model in self.models if hasattr(model, name)), 0)
+        return super().__getattr__(name)
+
+
+class FakeTexture:
+    def __init__(self, arr):
+        self.arr = arr
+        self._txid = 1
+        self.hght, self.wdth = arr.shape[:2]
+        self.region = (0.0, 0.0, 1.0, 1.0)
+
+
+class FakeBatch:
+    def __init__(self):
+        self.added = []
+        self.draws = 0
+
+    def add(self, texture, pos, sz=None, rot=0, rotc=None):
+        self.added.append((texture, pos))
+
+    def draw(self):
+        self.draws += 1
+
+    def clear(self):
+        self.added = []
+
+
+class FakeGraphics:
+    """Graphics device of a given size, recording textures and batch draws."""
+
+    onset_service = None
+
+    def __init__(self, width=1024, height=768):
+        self.width = width
+        self.height = height
+        self.uploads = []
+        self.batch = FakeBatch()
+
+    def newTexture(self, arr):
+        self.uploads.append(arr)
+        return FakeTexture(arr)
+
+    def newBatch(self):
+        return self.batch
+
+
+@pytest.fixture
+def fake_dpx():
+    """Factory of FakeDpx: fake_dpx(*models, missing=())."""
+    return FakeDpx
+
+
+@pytest.fixture
+def fake_gl(monkeypatch):
+    """Install a FakeGL as the OpenGL bindings of a module.
+
+    fake_gl(module, *models) replaces module.opengl for the test, and
+    returns the FakeGL.
+    """
+
+    def install(module, *models):
+        gl = FakeGL(*models)
+        monkeypatch.setattr(module, "opengl", gl)
+        return gl
+
+    return install
+
+
+@pytest.fixture
+def fake_graphics():
+    """Factory of FakeGraphics: fake_graphics(width=1024, height=768)."""
+    return FakeGraphics
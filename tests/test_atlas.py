@@ -0,0 +1,110 @@
+import numpy as np
+import pytest
+
+import hrl.graphics.atlas
+from hrl.graphics.atlas import ShelfPacker, TextureAtlas
+
+
+def overlaps(a, b):
+    (ax, ay, aw, ah), (bx, by, bw, bh) = a, b
+    return ax < bx + bw and bx < ax + aw and ay < by + bh and by < ay + ah
+
+
+def test_shelf_packer_no_overlap():
+    """Packed rectangles stay on the page and do not overlap."""
+    rng = np.random.default_rng(0)
+    packer = ShelfPacker(256)
+    rects = []
+    for wdth, hght in rng.integers(4, 40, size=(200, 2)):
+        position = packer.insert(wdth, hght)
+        if position is not None:
+            rects.append((*position, wdth, hght))
+
+    assert len(rects) > 20
+    for i, (x, y, w, h) in enumerate(rects):
+        assert 0 <= x and x + w <= 256 and 0 <= y and y + h <= 256
+        for other in rects[:i]:
+            assert not overlaps((x, y, w, h), other)
+
+
+def test_shelf_packer_reuses_best_shelf():
+    """A low rectangle goes onto the lowest shelf that fits it."""
+    packer = ShelfPacker(100)
+    assert packer.insert(50, 30) == (0, 0)
+    assert packer.insert(50, 10) == (50, 0)
+    assert packer.insert(60, 10) == (0, 30)
+    assert packer.insert(30, 8) == (60, 30)
+
+
+def test_shelf_packer_full():
+    packer = ShelfPacker(10)
+    assert packer.insert(11, 1) is None
+    assert packer.insert(10, 10) == (0, 0)
+    assert packer.insert(1, 1) is None
+
+
+class TextureMemory:
+    """GL textures holding the atlas pages."""
+
+    def __init__(self):
+        self.pages = {}
+        self.bound = None
+
+    def load_texture(self, byts, wdth, hght):
+        txid = len(self.pages) + 1
+        self.pages[txid] = np.zeros((hght, wdth, 4), dtype=np.uint8)
+        return txid, wdth, hght
+
+    def glBindTexture(self, target, txid):
+        self.bound = txid
+
+    def glTexSubImage2D(self, target, level, x, y, wdth, hght, fmt, dtype, byts):
+        pixels = np.frombuffer(byts, dtype=np.uint8).reshape(hght, wdth, 4)
+        self.pages[self.bound][y : y + hght, x : x + wdth] = pixels
+
+
+@pytest.fixture
+def memory(fake_gl, monkeypatch):
+    memory = TextureMemory()
+    fake_gl(hrl.graphics.atlas, memory)
+    monkeypatch.setattr(hrl.graphics.atlas, "loadTexture", memory.load_texture)
+    return memory
+
+
+def encode(arr):
+    """Fake 8-bit grey encoder."""
+    value = np.asarray(arr * 255, dtype=np.uint8)
+    return np.stack([value, value, value, np.full_like(value, 255)], axis=-1)
+
+
+def test_atlas_region_holds_encoded_pixels(memory):
+    """Each handle's region holds its encoded image, with padded edges."""
+    atlas = TextureAtlas(encode, size=64, padding=1)
+    rng = np.random.default_rng(1)
+    images = [rng.random((rng.integers(3, 12), rng.integers(3, 12))) for _ in range(20)]
+
+    handles = [atlas.add(img) for img in images]
+
+    assert len(atlas.pages) == 1
+    for img, handle in zip(images, handles):
+        assert (handle.wdth, handle.hght) == (img.shape[1], img.shape[0])
+        u, v, uw, vh = np.array(handle.region) * 64
+        page = memory.pages[handle._txid]
+        np.testing.assert_array_equal(page[int(v) : int(v + vh), int(u) : int(u + uw)], encode(img))
+        np.testing.assert_array_equal(page[int(v) - 1, int(u) : int(u + uw)], encode(img)[0])
+
+
+def test_atlas_opens_new_page(memory):
+    atlas = TextureAtlas(encode, size=16, padding=0)
+
+    first = atlas.add(np.zeros((16, 16)))
+    second = atlas.add(np.zeros((4, 4)))
+
+    assert len(atlas.pages) == 2
+    assert first._txid != second._txid
+
+
+def test_atlas_too_large(memory):
+    atlas = TextureAtlas(encode, size=16, padding=1)
+    with pytest.raises(ValueError):
+        atlas.add(np.zeros((15, 15)))
@@ -0,0 +1,95 @@
+import numpy as np
+
+from hrl.graphics.batch import INSTANCE_FLOATS, Batch
+
+
+class FakeTexture:
+    def __init__(self, txid, wdth=10, hght=20, shape="square"):
+        self._txid = txid
+        self.wdth = wdth
+        self.hght = hght
+        self.shape = shape
+        self.region = (0.0, 0.0, 1.0, 1.0)
+
+
+class FakeRenderer:
+    def render(self, groups, instances):
+        self.groups = [tuple(group) for group in groups]
+        self.instances = instances
+
+
+def test_batch_groups_consecutive_draws_by_texture_and_shape():
+    """One draw call per run of the same texture and shape."""
+    renderer = FakeRenderer()
+    batch = Batch(renderer)
+    a, b, c = FakeTexture(1), FakeTexture(2), FakeTexture(1, shape="circle")
+
+    for i, texture in enumerate([a, a, a, c, c, b, b]):
+        batch.add(texture, (i, 0))
+    batch.draw()
+
+    assert renderer.groups == [(1, "square", 0, 3), (1, "circle", 3, 2), (2, "square", 5, 2)]
+    np.testing.assert_array_equal(renderer.instances[:, 0], np.arange(7))
+
+
+def test_batch_keeps_order_of_overlapping_draws():
+    """Draws stack in the order they were added, as with Texture.draw()."""
+    renderer = FakeRenderer()
+    batch = Batch(renderer)
+    background, patch = FakeTexture(2), FakeTexture(1)
+
+    batch.add(background, (0, 0))
+    batch.add(patch, (5, 5))
+    batch.add(background, (10, 10))
+    batch.add(patch, (15, 15))
+    batch.draw()
+
+    assert renderer.groups == [(2, "square", 0, 1), (1, "square", 1, 1), (2, "square", 2, 1), (1, "square", 3, 1)]
+    np.testing.assert_array_equal(renderer.instances[:, 0], [0, 5, 10, 15])
+
+
+def test_batch_skips_deleted_textures():
+    renderer = FakeRenderer()
+    batch = Batch(renderer)
+    a, deleted = FakeTexture(1), FakeTexture(None)
+
+    batch.add(a, (0, 0))
+    batch.add(deleted, (1, 0))
+    batch.add(a, (2, 0))
+    batch.draw()
+
+    assert renderer.groups == [(1, "square", 0, 2)]
+    np.testing.assert_array_equal(renderer.instances[:, 0], [0, 2])
+
+    batch.clear()
+    batch.add(deleted, (0, 0))
+    renderer = batch.renderer = FakeRenderer()
+    batch.draw()
+    assert not hasattr(renderer, "groups")
+
+
+def test_batch_defaults_as_texture_draw():
+    """Size defaults to natural size, rotation centre to its centre."""
+    renderer = FakeRenderer()
+    batch = Batch(renderer)
+
+    batch.add(FakeTexture(1), (5, 6))
+    batch.add(FakeTexture(1), (5, 6), sz=(30, 40), rot=45, rotc=(1, 2))
+    batch.draw()
+
+    assert renderer.instances.shape == (2, INSTANCE_FLOATS)
+    assert renderer.instances.dtype == np.float32
+    np.testing.assert_array_equal(renderer.instances[0, :7], [5, 6, 10, 20, 0, 5, 10])
+    np.testing.assert_array_equal(renderer.instances[1, :7], [5, 6, 30, 40, 45, 1, 2])
+
+
+def test_batch_clear():
+    renderer = FakeRenderer()
+    batch = Batch(renderer)
+    batch.add(FakeTexture(1), (0, 0))
+
+    batch.clear()
+    batch.draw()
+
+    assert len(batch) == 0
+    assert not hasattr(renderer, "groups")
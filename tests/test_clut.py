@@ -0,0 +1,129 @@
+import sys
+import types
+
+import numpy as np
+import pytest
+
+from hrl.graphics.clut import DualCLUT, clut_from_lut
+from hrl.graphics.datapixx import DATAPixx_L48, DATAPixx_L48D
+from hrl.graphics.graphics import Graphics_grey
+from hrl.luts import create_clut, create_lut
+
+
+def test_identity_clut():
+    table = clut_from_lut()
+
+    assert table.shape == (256, 3) and table.dtype == np.uint16
+    assert table[0].tolist() == [0, 0, 0]
+    assert table[255].tolist() == [65535] * 3
+    assert table[128, 0] == int(128 / 255 * 65535)
+
+
+def test_clut_from_lut_and_clut():
+    lut = create_lut(gamma=2.2)
+    grey = clut_from_lut(lut)
+    assert np.all(grey[:, 0] == grey[:, 1]) and np.all(grey[:, 0] == grey[:, 2])
+    assert np.all(np.diff(grey[:, 0].astype(int)) >= 0)
+    assert grey[128, 0] > 128 / 255 * 65535  # inverse gamma brightens midtones
+
+    rgb = clut_from_lut(create_clut(gamma=[1.0, 2.2, 1.8]))
+    assert rgb[128, 0] == int(128 / 255 * 65535)
+    assert rgb[128, 1] > rgb[128, 2] > rgb[128, 0]
+
+
+def test_clut_from_lut_file(tmp_path):
+    path = tmp_path / "lut.csv"
+    lut = create_lut(gamma=2.2)
+    np.savetxt(path, lut, delimiter=",", header="IntensityIn,IntensityOut,Luminance")
+
+    np.testing.assert_array_equal(clut_from_lut(str(path)), clut_from_lut(lut))
+    np.testing.assert_array_equal(clut_from_lut(path), clut_from_lut(lut))
+
+
+def test_dual_clut_uploads_both_outputs_only_when_changed(fake_dpx):
+    dpx = fake_dpx()
+    cluts = DualCLUT((None, create_lut(gamma=2.2)), dpx=dpx)
+
+    assert cluts.pending()
+    assert cluts.apply()
+    assert not cluts.apply()
+    assert dpx.names() == ["DPxSetVidCluts"]
+
+    # One list per colour channel, as for DPxSetVidClut()
+    (data,) = dpx.args("DPxSetVidCluts")[0]
+    assert len(data) == 3 and all(len(channel) == 512 for channel in data)
+    data = np.array(data).T
+    np.testing.assert_array_equal(data[:256], clut_from_lut())
+    np.testing.assert_array_equal(data[256:], clut_from_lut(create_lut(gamma=2.2)))
+
+    cluts.load(0, create_lut(gamma=2.2))
+    assert cluts.apply()
+    cluts.load(0, create_lut(gamma=2.2))
+    assert not cluts.apply()
+    assert cluts.uploads == 2
+
+
+def test_dual_clut_needs_two_luts(fake_dpx):
+    with pytest.raises(ValueError):
+        DualCLUT((None,), dpx=fake_dpx())
+
+
+@pytest.fixture
+def l48(monkeypatch, fake_dpx):
+    """DATAPixx_L48 on a fake device, without a display."""
+    device = types.SimpleNamespace(getVideoMode=lambda: "L48")
+    pypixxlib = types.ModuleType("pypixxlib")
+    pypixxlib.datapixx = types.SimpleNamespace(DATAPixx=lambda: device)
+    pypixxlib._libdpx = fake_dpx()
+    monkeypatch.setitem(sys.modules, "pypixxlib", pypixxlib)
+    monkeypatch.setitem(sys.modules, "pypixxlib.datapixx", pypixxlib.datapixx)
+    monkeypatch.setattr(Graphics_grey, "__init__", lambda self, *args, **kwargs: None)
+    return DATAPixx_L48
+
+
+def test_l48_loads_one_lut_path_into_both_outputs(tmp_path, l48):
+    path = tmp_path / "lut.csv"
+    lut = create_lut(gamma=2.2)
+    np.savetxt(path, lut, delimiter=",", header="IntensityIn,IntensityOut,Luminance")
+
+    graphics = l48(lut=path)
+
+    for table in graphics.cluts.tables:
+        np.testing.assert_array_equal(table, clut_from_lut(lut))
+
+
+def test_l48_loads_nested_list_into_both_outputs(l48):
+    # Two rows of a LUT, not a pair of LUTs
+    lut = create_lut(gamma=2.2)[[0, -1]]
+
+    graphics = l48(lut=lut.tolist())
+
+    for table in graphics.cluts.tables:
+        np.testing.assert_array_equal(table, clut_from_lut(lut))
+
+
+def test_l48_loads_tuple_into_each_output(l48):
+    lut = create_lut(gamma=2.2)
+
+    graphics = l48(lut=(None, lut))
+
+    np.testing.assert_array_equal(graphics.cluts.tables[0], clut_from_lut())
+    np.testing.assert_array_equal(graphics.cluts.tables[1], clut_from_lut(lut))
+
+
+def test_l48_encodes_index_in_red():
+    img = np.array([[0.0, 0.5, 1.0, 1.5]])
+
+    r, g, b, a = DATAPixx_L48.channels_from_img(DATAPixx_L48, img)
+
+    assert r.tolist() == [[0, 127, 255, 255]]
+    assert not g.any() and not b.any() and a == 255
+
+
+def test_l48d_encodes_index_in_high_nibbles():
+    img = np.array([[0xA7 / 255, 1.0]])
+
+    r, g, b, a = DATAPixx_L48D.channels_from_img(DATAPixx_L48D, img)
+
+    assert r.tolist() == [[0xA0, 0xF0]] and g.tolist() == [[0x70, 0xF0]]
+    assert not b.any() and a == 255
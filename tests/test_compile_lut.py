@@ -0,0 +1,70 @@
+from pathlib import Path
+
+import numpy as np
+import pytest
+
+from hrl.luts import compile_lut, create_lut, gamma_correct_grey, gamma_correct_RGB
+
+CALIBRATION_DIR = Path(__file__).parent / "calibration"
+
+
+def edge_intensities(xp, rng):
+    """Random intensities, LUT rows and their neighbours, out of range and NaN."""
+    return np.concatenate(
+        [
+            rng.random(10000),
+            xp,
+            np.nextafter(xp, 2.0),
+            np.nextafter(xp, -1.0),
+            [-0.5, 0.0, 1.0, 1.5, np.nan],
+        ]
+    )
+
+
+@pytest.mark.parametrize("lut_file", ["lut_8bit", "lut_10bit", "lut_16bit", "lut_lumrange"])
+@pytest.mark.parametrize("n_levels", [2**8, 2**12, 2**16])
+def test_compiled_lut_matches_interp(lut_file, n_levels):
+    """Compiled LUT is bit-identical to np.interp on measured LUTs."""
+    lut = np.genfromtxt(CALIBRATION_DIR / f"{lut_file}.csv", skip_header=1, delimiter=",")
+    x = edge_intensities(lut[:, 0], np.random.default_rng(0))
+
+    result = gamma_correct_grey(x, compile_lut(lut, n_levels=n_levels))
+
+    np.testing.assert_array_equal(result, np.interp(x, lut[:, 0], lut[:, 1]))
+
+
+def test_compiled_lut_duplicate_rows():
+    """Repeated input intensities resolve to the same row as np.interp."""
+    lut = create_lut(n=64, gamma=2.2)
+    lut[10, 0] = lut[11, 0]
+    lut[20:23, 0] = lut[20, 0]
+    x = edge_intensities(lut[:, 0], np.random.default_rng(1))
+
+    result = gamma_correct_grey(x, compile_lut(lut, n_levels=2**8))
+
+    np.testing.assert_array_equal(result, np.interp(x, lut[:, 0], lut[:, 1]))
+
+
+def test_compiled_lut_scalar(nonlinear_lut):
+    """Scalar input gives scalar output."""
+    result = gamma_correct_grey(0.3, compile_lut(nonlinear_lut))
+
+    assert np.isscalar(result)
+    assert result == gamma_correct_grey(0.3, nonlinear_lut)
+
+
+@pytest.mark.parametrize("shape", [(1, 1, 3), (37, 53, 3)])
+def test_compiled_clut_matches_interp(shape, nonlinear_clut):
+    """Compiled CLUT is bit-identical to per-channel np.interp."""
+    img = np.random.default_rng(2).random(shape)
+
+    result = gamma_correct_RGB(img, compile_lut(nonlinear_clut, n_levels=2**8))
+
+    np.testing.assert_array_equal(result, gamma_correct_RGB(img, nonlinear_clut))
+
+
+def test_compile_lut_invalid():
+    with pytest.raises(ValueError):
+        compile_lut(np.array([[0.0, 0.0, 0.0]]))
+    with pytest.raises(ValueError):
+        compile_lut(np.array([[1.0, 1.0], [0.0, 0.0]]))
@@ -0,0 +1,191 @@
+from concurrent.futures import ThreadPoolExecutor
+from functools import partial
+
+import numpy as np
+import pytest
+
+from hrl.graphics.encoding import (
+    decode_dithered,
+    decode_pixel_pairs,
+    encode_dithered,
+    encode_m16,
+    encode_pixel_pairs,
+)
+from hrl.luts import gamma_correct_grey
+
+
+@pytest.mark.parametrize("bits", [16, 12])
+def test_pixel_pairs_roundtrip(bits):
+    """Decoding the packed pixel pairs gives the truncated input values."""
+    rng = np.random.default_rng(0)
+    img = rng.random((7, 5, 3))
+    img[0, 0] = [0.0, 1.0, 0.5]
+
+    packed = encode_pixel_pairs(img, bits=bits)
+
+    assert packed.shape == (7, 10, 4)
+    assert packed.dtype == np.uint8
+    assert np.all(packed[:, :, 3] == 255)
+    expected = np.asarray(img * (2**bits - 1), dtype=np.uint32)
+    np.testing.assert_array_equal(decode_pixel_pairs(packed, bits=bits), expected)
+
+
+def test_c48_layout():
+    """C48: even pixel holds the high bytes, odd pixel the low bytes."""
+    img = np.array([[[0x1234, 0xABCD, 0xFFFF]]]) / 65535
+
+    packed = encode_pixel_pairs(img, bits=16)
+
+    np.testing.assert_array_equal(packed[0, 0], [0x12, 0xAB, 0xFF, 255])
+    np.testing.assert_array_equal(packed[0, 1], [0x34, 0xCD, 0xFF, 255])
+
+
+def test_c36d_layout():
+    """C36D: 6 bits per byte in bits [7:2], bits [1:0] zero."""
+    img = np.array([[[0xFFF, 0x040, 0x03F]]]) / 4095
+
+    packed = encode_pixel_pairs(img, bits=12)
+
+    np.testing.assert_array_equal(packed[0, 0, :3], [0xFC, 0x04, 0x00])
+    np.testing.assert_array_equal(packed[0, 1, :3], [0xFC, 0x00, 0xFC])
+    assert np.all(packed[:, :, :3] & 0b11 == 0)
+
+
+def test_encode_into_preallocated():
+    """Encoder writes into a given output array."""
+    img = np.full((2, 3, 3), 0.5)
+    out = np.zeros((2, 6, 4), dtype=np.uint8)
+
+    result = encode_pixel_pairs(img, out=out)
+
+    assert result is out
+    np.testing.assert_array_equal(decode_pixel_pairs(out), np.full((2, 3, 3), 32767))
+
+
+@pytest.mark.parametrize("bits", [16, 12])
+def test_pixel_pairs_clip_out_of_range(bits):
+    """Out-of-range values saturate instead of wrapping around."""
+    img = np.array([[[-0.5, -1e-9, 1.5], [1.0 + 1e-9, 2.0, 0.0]]])
+
+    packed = encode_pixel_pairs(img, bits=bits)
+
+    maximum = 2**bits - 1
+    np.testing.assert_array_equal(decode_pixel_pairs(packed, bits=bits), [[[0, 0, maximum], [maximum, maximum, 0]]])
+
+
+@pytest.mark.parametrize(
+    "img,kwargs",
+    [
+        (np.zeros((2, 2)), {}),
+        (np.zeros((2, 2, 3)), {"bits": 10}),
+        (np.zeros((2, 2, 3)), {"out": np.zeros((2, 2, 4), dtype=np.uint8)}),
+    ],
+    ids=["grey_input", "bad_bits", "bad_out"],
+)
+def test_encode_invalid(img, kwargs):
+    with pytest.raises(ValueError):
+        encode_pixel_pairs(img, **kwargs)
+
+
+def m16_reference(img):
+    """M16 encoding via channels_from_img and bytestring_from_channels."""
+    arr = np.asarray(img * (2**16 - 1), dtype=np.uint32)
+    bitint = (arr % 256) * 2**8 + (arr // 256) + 255 * 2**24
+    return bitint.tobytes()
+
+
+@pytest.mark.parametrize("shape", [(1, 1), (37, 53), (600, 800)], ids=["pixel", "small", "large"])
+@pytest.mark.parametrize("threads", [1, 4])
+def test_m16_matches_reference(shape, threads):
+    """Fused M16 encoder gives the same bytes as the channel pipeline."""
+    rng = np.random.default_rng(1)
+    img = rng.random(shape)
+    img.flat[0] = 1.0
+
+    packed = encode_m16(img, threads=threads)
+
+    assert packed.tobytes() == m16_reference(img)
+
+
+def test_m16_from_concurrent_callers():
+    """Callers in several threads, asking for different numbers of bands."""
+    rng = np.random.default_rng(2)
+    img = rng.random((512, 512))
+    expected = m16_reference(img)
+
+    def encode(threads):
+        return encode_m16(img, threads=threads).tobytes()
+
+    with ThreadPoolExecutor(max_workers=16) as callers:
+        results = list(callers.map(encode, range(2, 66)))
+
+    assert all(result == expected for result in results)
+
+
+def test_m16_gamma_correct(nonlinear_lut):
+    """Gamma correction is applied per band, as on the whole image."""
+    rng = np.random.default_rng(2)
+    img = rng.random((600, 800))
+    gamma_correct = partial(gamma_correct_grey, LUT=nonlinear_lut)
+
+    packed = encode_m16(img, gamma_correct=gamma_correct, threads=4)
+
+    assert packed.tobytes() == m16_reference(gamma_correct(img))
+
+
+def test_m16_clips_out_of_range():
+    img = np.array([[-0.5, 1.5]])
+
+    packed = encode_m16(img)
+
+    np.testing.assert_array_equal(packed[0, :, :2], [[0, 0], [255, 255]])
+
+
+def test_m16d_layout():
+    """M16D: R[7:3], G[7:3], B[7:2] concatenate into the 16-bit value."""
+    img = np.array([[0b1010111001101101, 0xFFFF, 0]]) / 65535
+
+    packed = encode_dithered(img, "M16D")
+
+    np.testing.assert_array_equal(packed[0, 0], [0b10101000, 0b11001000, 0b10110100, 255])
+    np.testing.assert_array_equal(packed[0, 1], [0xF8, 0xF8, 0xFC, 255])
+    np.testing.assert_array_equal(packed[0, 2, :3], [0, 0, 0])
+
+
+def test_l48d_layout():
+    """L48D: R[7:4], G[7:4] concatenate into the 8-bit CLUT index."""
+    img = np.array([[0xA7, 0xFF]]) / 255
+
+    packed = encode_dithered(img, "L48D")
+
+    np.testing.assert_array_equal(packed[0, 0], [0xA0, 0x70, 0, 255])
+    np.testing.assert_array_equal(packed[0, 1], [0xF0, 0xF0, 0, 255])
+
+
+@pytest.mark.parametrize("mode, bits", [("M16D", 16), ("L48D", 8)])
+def test_dithered_roundtrip_ignores_low_bits(mode, bits):
+    """Decoding gives the truncated values, whatever dithering does to the low bits."""
+    rng = np.random.default_rng(3)
+    img = rng.random((600, 800))
+
+    packed = encode_dithered(img, mode, threads=4)
+    dithered = packed | rng.integers(0, 4, size=packed.shape, dtype=np.uint8)
+
+    expected = np.asarray(img * (2**bits - 1), dtype=np.uint16)
+    np.testing.assert_array_equal(decode_dithered(packed, mode), expected)
+    np.testing.assert_array_equal(decode_dithered(dithered, mode), expected)
+
+
+def test_m16d_gamma_correct_and_clip(nonlinear_lut):
+    gamma_correct = partial(gamma_correct_grey, LUT=nonlinear_lut)
+    img = np.array([[-0.5, 0.3, 1.5]])
+
+    packed = encode_dithered(img, "M16D", gamma_correct=gamma_correct)
+
+    expected = np.asarray(np.clip(gamma_correct(img), 0, 1) * 65535, dtype=np.uint16)
+    np.testing.assert_array_equal(decode_dithered(packed, "M16D"), expected)
+
+
+def test_dithered_invalid_mode():
+    with pytest.raises(ValueError):
+        encode_dithered(np.zeros((2, 2)), "M16")
@@ -0,0 +1,133 @@
+import ctypes
+
+import numpy as np
+import pytest
+
+from hrl.graphics.overlay import ALPHA_MAX, OverlayCompositor
+
+
+class Overlay:
+    """Device that dedups alpha tables as libdpx does."""
+
+    def __init__(self):
+        self.alpha_writes = 0
+        self._alpha = None
+
+    def DPxWriteVidHorizOverlayAfterVideoSync(self, alpha):
+        if alpha is None or list(alpha) == self._alpha:
+            return 0
+        self._alpha = list(alpha)
+        self.alpha_writes += 1
+        return 1
+
+
+@pytest.fixture
+def overlay():
+    return Overlay()
+
+
+@pytest.fixture
+def compositor(fake_dpx, fake_graphics, overlay):
+    return OverlayCompositor(fake_graphics(width=1024, height=600), dpx=fake_dpx(overlay))
+
+
+def test_enables_overlay(compositor):
+    assert compositor.half_width == 512
+    assert compositor.dpx.names()[0] == "DPxEnableVidHorizOverlay"
+
+    compositor.close()
+    assert compositor.dpx.names()[-2] == "DPxDisableVidHorizOverlay"
+
+
+def test_alpha_table_profiles_and_cache(compositor):
+    ramp = np.linspace(0.0, 1.0, 512)
+    table = compositor.alpha_table(x=ramp, y=1.0)
+
+    assert table.dtype == np.uint16 and table.shape == (1024,)
+    assert table[0] == 0 and table[511] == ALPHA_MAX
+    assert np.all(table[512:] == ALPHA_MAX)
+    assert compositor.alpha_table(x=ramp.copy(), y=1.0) is table
+
+    raw = compositor.alpha_table(x=np.arange(512), y=np.uint16(7))
+    assert raw[:512].tolist() == list(range(512))
+    assert np.all(raw[512:] == 7)
+
+
+def test_scheduled_changes_sent_together_on_apply(compositor):
+    dpx = compositor.dpx
+    table = compositor.alpha_table(x=0.5)
+
+    compositor.schedule(alpha=table, bounds=(10, 20, 110, 120))
+    dpx.calls.clear()
+    assert compositor.apply()
+
+    assert dpx.names() == [
+        "DPxSetVidHorizOverlayBounds",
+        "DPxWriteVidHorizOverlayAfterVideoSync",
+    ]
+    assert dpx.calls[0][1] == (10, 20, 110, 120)
+    assert list(dpx.calls[1][1][0]) == table.tolist()
+    assert not compositor.pending()
+    assert not compositor.apply()
+
+
+def test_identical_alpha_table_is_not_resent(compositor, overlay):
+    dpx = compositor.dpx
+    compositor.schedule(alpha=compositor.alpha_table(x=0.5))
+    compositor.apply()
+
+    compositor.schedule(alpha=compositor.alpha_table(x=0.5), bounds=(0, 0, 8, 8))
+    assert not compositor.apply()
+    assert dpx.calls[-1] == ("DPxWriteVidHorizOverlayAfterVideoSync", (None,))
+
+    compositor.schedule(alpha=compositor.alpha_table(x=0.25))
+    assert compositor.apply()
+    assert (compositor.sent, compositor.skipped, overlay.alpha_writes) == (2, 1, 2)
+
+
+def test_alpha_table_is_passed_as_uint16_array(compositor):
+    """The bindings take a POINTER(c_uint16), or None to keep the table."""
+    table = compositor.alpha_table(x=np.linspace(0.0, 1.0, 512))
+
+    compositor.schedule(alpha=table)
+    assert compositor.apply()
+    compositor.schedule(bounds=(0, 0, 8, 8))
+    compositor.apply()
+
+    written = compositor.dpx.args("DPxWriteVidHorizOverlayAfterVideoSync")
+    assert isinstance(written[0][0], ctypes.Array) and written[0][0]._type_ is ctypes.c_uint16
+    assert list(written[0][0]) == table.tolist()
+    assert written[1] == (None,)
+    with pytest.raises(ctypes.ArgumentError):
+        compositor.dpx.DPxWriteVidHorizOverlayAfterVideoSync(table.tolist())
+
+
+def test_legacy_bindings_write_registers_then_alpha(fake_dpx, fake_graphics):
+    dpx = fake_dpx(missing={"DPxWriteVidHorizOverlayAfterVideoSync"})
+    compositor = OverlayCompositor(fake_graphics(), dpx=dpx)
+    compositor.schedule(alpha=compositor.alpha_table(), bounds=(0, 0, 8, 8))
+    compositor.apply()
+
+    assert dpx.names()[-3:] == [
+        "DPxSetVidHorizOverlayBounds",
+        "DPxWriteRegCacheAfterVideoSync",
+        "DPxSetVidHorizOverlayAlpha",
+    ]
+
+
+def test_schedule_validates(compositor):
+    with pytest.raises(ValueError):
+        compositor.schedule(alpha=np.zeros(512))
+    with pytest.raises(ValueError):
+        compositor.schedule(bounds=(0, 0, 600, 10))
+    assert not compositor.pending()
+
+
+def test_draws_both_halves_in_one_batch(compositor):
+    batch = compositor.graphics.batch
+    compositor.add_main("stimulus", (100, 50))
+    compositor.add_overlay("fixation", (100, 50))
+
+    assert batch.added == [("stimulus", (100, 50)), ("fixation", (612, 50))]
+    compositor.draw()
+    assert batch.draws == 1 and batch.added == []
@@ -0,0 +1,74 @@
+import threading
+
+import numpy as np
+import pytest
+
+import hrl.graphics.pipeline
+from hrl.graphics.pipeline import StimulusPipeline
+
+
+class FakeTexture:
+    def __init__(self, byts, wdth, hght, shape, ring=None):
+        self.byts = byts
+        self.wdth = wdth
+        self.hght = hght
+        self.shape = shape
+        self.thread = threading.current_thread()
+
+
+class FakeGraphics:
+    upload_ring = None
+
+    def __init__(self):
+        self.encode_threads = []
+
+    def encode_image(self, img):
+        self.encode_threads.append(threading.current_thread())
+        value = np.asarray(img * 255, dtype=np.uint8)
+        return np.stack([value, value, value, np.full_like(value, 255)], axis=-1)
+
+
+@pytest.fixture
+def graphics(monkeypatch):
+    monkeypatch.setattr(hrl.graphics.pipeline, "Texture", FakeTexture)
+    return FakeGraphics()
+
+
+def test_pipeline_encodes_in_worker_uploads_on_caller(graphics):
+    pipeline = StimulusPipeline(graphics)
+
+    pending = pipeline.submit(np.full, (3, 5), 0.5, shape="circle")
+    texture = pending.textures()
+    pipeline.close()
+
+    assert graphics.encode_threads[0] is not threading.main_thread()
+    assert texture.thread is threading.main_thread()
+    assert (texture.wdth, texture.hght, texture.shape) == (5, 3, "circle")
+    assert texture.byts == graphics.encode_image(np.full((3, 5), 0.5)).tobytes()
+    assert pending.textures() is texture
+
+
+@pytest.mark.parametrize("container", [list, dict])
+def test_pipeline_multiple_images(graphics, container):
+    images = [np.zeros((2, 2)), np.ones((4, 3))]
+    if container is dict:
+        images = dict(enumerate(images))
+
+    pipeline = StimulusPipeline(graphics)
+    textures = pipeline.submit(lambda: images).textures()
+    pipeline.close()
+
+    assert isinstance(textures, container)
+    assert [(textures[i].wdth, textures[i].hght) for i in range(2)] == [(2, 2), (3, 4)]
+
+
+def test_pipeline_reraises_worker_error(graphics):
+    def fail():
+        raise RuntimeError("generation failed")
+
+    pipeline = StimulusPipeline(graphics)
+    pending = pipeline.submit(fail)
+
+    with pytest.raises(RuntimeError, match="generation failed"):
+        pending.textures()
+    pipeline.close()
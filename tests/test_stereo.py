@@ -0,0 +1,91 @@
+import numpy as np
+import pytest
+
+import hrl.graphics.stereo
+from hrl.graphics.stereo import FramePacker
+
+
+def added(batch):
+    """Regions and positions of the textures added to a batch."""
+    return [(texture.region, pos) for texture, pos in batch.added]
+
+
+def bluelines(gl):
+    """Window rows, and RGBA pixels, of the drawn bluelines."""
+    rows = [args[1] for args in gl.args("glWindowPos2i")]
+    pixels = [np.frombuffer(args[-1], dtype=np.uint8).reshape(args[0], 4) for args in gl.args("glDrawPixels")]
+    return list(zip(rows, pixels))
+
+
+@pytest.mark.parametrize(
+    "mode, calls, size",
+    [
+        ("stereo", ["DPxEnableVidVertStereo", "DPxEnableVidVesaBlueline"], (400, 300)),
+        ("split", ["DPxEnableVidHorizSplit"], (200, 600)),
+    ],
+)
+def test_configures_device(fake_dpx, fake_graphics, mode, calls, size):
+    packer = FramePacker(fake_graphics(width=400, height=600), mode, dpx=fake_dpx())
+
+    assert packer.dpx.names() == calls + ["DPxUpdateRegCache"]
+    assert packer.size == size
+
+
+def test_unknown_mode(fake_dpx, fake_graphics):
+    with pytest.raises(ValueError):
+        FramePacker(fake_graphics(), "anaglyph", dpx=fake_dpx())
+
+
+def test_stereo_pair_is_one_upload(fake_dpx, fake_graphics):
+    graphics = fake_graphics(width=400, height=600)
+    packer = FramePacker(graphics, "stereo", dpx=fake_dpx())
+    left, right = np.zeros((50, 80)), np.ones((50, 80))
+
+    pair = packer.newTexture(left, right)
+
+    assert len(graphics.uploads) == 1
+    assert np.array_equal(graphics.uploads[0], np.vstack([left, right]))
+    assert (pair.wdth, pair.hght) == (80, 50)
+
+    pair.add_to(graphics.batch, (10, 20))
+    assert added(graphics.batch) == [((0.0, 0.0, 1.0, 0.5), (10, 20)), ((0.0, 0.5, 1.0, 0.5), (10, 320))]
+
+
+def test_split_pair_packs_side_by_side(fake_dpx, fake_graphics):
+    graphics = fake_graphics(width=400, height=600)
+    packer = FramePacker(graphics, "split", dpx=fake_dpx())
+    left, right = np.zeros((50, 80, 3)), np.ones((50, 80, 3))
+
+    pair = packer.newTexture(left, right)
+
+    assert graphics.uploads[0].shape == (50, 160, 3)
+    pair.add_to(graphics.batch, (10, 20))
+    assert added(graphics.batch) == [((0.0, 0.0, 0.5, 1.0), (10, 20)), ((0.5, 0.0, 0.5, 1.0), (210, 20))]
+
+    with pytest.raises(ValueError):
+        packer.newTexture(left, right[:, :40])
+
+
+def test_bluelines_mark_last_line_of_each_eye(fake_gl, fake_dpx, fake_graphics):
+    gl = fake_gl(hrl.graphics.stereo)
+    packer = FramePacker(fake_graphics(width=400, height=600), "stereo", dpx=fake_dpx())
+
+    packer.before_swap()
+
+    (left_row, left), (right_row, right) = bluelines(gl)
+    assert (left_row, right_row) == (300, 0)
+    assert np.flatnonzero(left[:, 2]).tolist() == list(range(100))
+    assert np.flatnonzero(right[:, 2]).tolist() == list(range(300))
+    # Middle pixel: black for the left eye, blue for the right eye
+    assert left[200, 2] == 0 and right[200, 2] == 255
+
+
+def test_split_has_no_bluelines(fake_gl, fake_dpx, fake_graphics):
+    gl = fake_gl(hrl.graphics.stereo)
+    packer = FramePacker(fake_graphics(width=400, height=600), "split", dpx=fake_dpx())
+
+    packer.before_swap()
+    packer.close()
+
+    assert bluelines(gl) == []
+    assert packer.dpx.names()[-2:] == ["DPxAutoVidHorizSplit", "DPxUpdateRegCache"]
@@ -0,0 +1,166 @@
+import ctypes
+
+import pytest
+
+import hrl.graphics.texture
+from hrl.graphics.texture import PixelSlot, Texture, UploadRing
+
+
+class PixelBuffers:
+    """Pixel buffer objects in host memory, with fences that signal late."""
+
+    GL_ALREADY_SIGNALED, GL_TIMEOUT_EXPIRED = 0x911A, 0x911B
+    GL_CONDITION_SATISFIED = 0x911C
+
+    def __init__(self, persistent, latency=0):
+        if not persistent:
+            self.glBufferStorage = None
+        self.latency = latency
+        self.buffers = {}
+        self.generated = 0
+        self.bound = None
+        self.textures = {}
+        self.fences = {}
+        self.synced = 0
+        self.deleted = []
+
+    def glGenBuffers(self, n):
+        pbos = list(range(self.generated + 1, self.generated + n + 1))
+        self.generated += n
+        self.buffers.update({pbo: None for pbo in pbos})
+        return pbos if n > 1 else pbos[0]
+
+    def glBindBuffer(self, target, pbo):
+        self.bound = pbo or None
+
+    def glBufferStorage(self, target, size, data, flags):
+        self.buffers[self.bound] = (ctypes.c_ubyte * size)()
+
+    def glBufferData(self, target, size, data, usage):
+        self.buffers[self.bound] = (ctypes.c_ubyte * size)()
+
+    def glMapBufferRange(self, target, offset, size, flags):
+        return ctypes.addressof(self.buffers[self.bound]) + offset
+
+    def glDeleteBuffers(self, n, pbos):
+        for pbo in [pbos] if isinstance(pbos, int) else pbos:
+            del self.buffers[pbo]
+            self.deleted.append(pbo)
+
+    def glGenTextures(self, n):
+        return len(self.textures) + 1
+
+    def glTexImage2D(self, target, level, internal, wdth, hght, border, fmt, dtype, byts):
+        # With a PBO bound, the pixels come from the PBO
+        assert byts is None and self.bound is not None
+        self.textures[len(self.textures) + 1] = bytes(self.buffers[self.bound][: wdth * hght * 4])
+
+    def glFenceSync(self, condition, flags):
+        self.synced += 1
+        self.fences[self.synced] = self.latency
+        return self.synced
+
+    def glClientWaitSync(self, fence, flags, timeout):
+        """Signals after latency polls."""
+        if self.fences[fence] > 0:
+            self.fences[fence] -= 1
+            return self.GL_TIMEOUT_EXPIRED
+        return self.GL_ALREADY_SIGNALED
+
+    def glDeleteSync(self, fence):
+        del self.fences[fence]
+
+
+@pytest.fixture(params=[True, False], ids=["persistent", "orphaned"])
+def gpu(request, fake_gl):
+    gpu = PixelBuffers(persistent=request.param)
+    gpu.gl = fake_gl(hrl.graphics.texture, gpu)
+    return gpu
+
+
+def waits(gpu):
+    """Fence and timeout of each glClientWaitSync call."""
+    return [(fence, timeout) for fence, _, timeout in gpu.gl.args("glClientWaitSync")]
+
+
+def stream(ring, value, wdth=2, hght=2):
+    """Write a uniform image into the next slot, and upload it."""
+    slot = ring.stage(wdth * hght * 4)
+    slot.array[:] = value
+    return slot, Texture(slot, wdth, hght, "square")
+
+
+def test_ring_rotates_slots(gpu):
+    ring = UploadRing(n_buffers=3, size=64)
+
+    slots = [stream(ring, value)[0] for value in (1, 2, 3, 4)]
+
+    assert [slot.index for slot in slots] == [0, 1, 2, 0]
+    assert [slot.generation for slot in slots] == [1, 1, 1, 2]
+    assert [texture[0] for texture in gpu.textures.values()] == [1, 2, 3, 4]
+    assert all(len(texture) == 16 for texture in gpu.textures.values())
+
+
+def test_ring_waits_for_fence_before_reuse(gpu):
+    gpu.latency = 3
+    ring = UploadRing(n_buffers=2, size=64)
+    first, texture = stream(ring, 1)
+    stream(ring, 2)
+
+    # Polling the fence does not block
+    assert not first.done() and not texture.ready()
+    assert waits(gpu) == [(1, 0), (1, 0)]
+
+    # Reusing the first PBO blocks on its fence until signalled, then
+    # deletes it; the second upload is not waited for
+    gpu.gl.calls.clear()
+    again, _ = stream(ring, 3)
+    assert again.index == first.index
+    assert waits(gpu) == [(1, 10**9), (1, 10**9)]
+    assert sorted(gpu.fences) == [2, 3]
+
+    # The old slot is done: its PBO holds a newer upload
+    assert first.done() and not again.done()
+    assert [texture[0] for texture in gpu.textures.values()] == [1, 2, 3]
+
+
+def test_ring_grows_buffer_for_larger_image(gpu):
+    ring = UploadRing(n_buffers=2, size=16)
+    pbo = ring._pbos[0]
+
+    slot, texture = stream(ring, 7, wdth=4, hght=4)
+
+    assert slot.array.size == 64 and ring._sizes == [64, 16]
+    assert ctypes.sizeof(gpu.buffers[ring._pbos[0]]) == 64
+    assert gpu.textures[texture._txid] == bytes([7] * 64)
+    if ring.persistent:
+        # Immutable storage is replaced by a new buffer
+        assert ring._pbos[0] != pbo and gpu.deleted == [pbo]
+    else:
+        assert ring._pbos[0] == pbo and gpu.deleted == []
+
+    # Smaller images keep the grown buffer
+    stream(ring, 0)
+    slot, _ = stream(ring, 8)
+    assert slot.index == 0 and slot.array.size == 16 and ring._sizes == [64, 16]
+
+
+def test_ring_delete_waits_for_all_uploads(gpu):
+    gpu.latency = 1
+    ring = UploadRing(n_buffers=2, size=16)
+    stream(ring, 1)
+    stream(ring, 2)
+
+    ring.delete()
+
+    assert gpu.fences == {} and gpu.buffers == {}
+
+
+def test_slot_array_is_mapped_pbo_memory(gpu):
+    ring = UploadRing(n_buffers=1, size=16)
+
+    slot = ring.stage(8)
+    slot.array[:] = 5
+
+    assert isinstance(slot, PixelSlot)
+    assert bytes(gpu.buffers[ring._pbos[0]])[:8] == bytes([5] * 8)
@@ -0,0 +1,113 @@
+import numpy as np
+import pytest
+
+from hrl.graphics.cache import TextureCache, array_digest
+
+
+class FakeTexture:
+    def __init__(self, wdth, hght):
+        self._txid = 1
+        self.wdth = wdth
+        self.hght = hght
+
+    def delete(self):
+        self._txid = None
+
+
+def fake_create(arr):
+    return lambda: FakeTexture(arr.shape[1], arr.shape[0])
+
+
+def test_array_digest():
+    """Digest depends on content, shape and dtype."""
+    arr = np.linspace(0, 1, 12).reshape(3, 4)
+
+    assert array_digest(arr) == array_digest(arr.copy())
+    assert array_digest(arr) != array_digest(arr.reshape(4, 3))
+    assert array_digest(arr) != array_digest(arr.astype(np.float32))
+    assert array_digest(arr) == array_digest(np.asfortranarray(arr))
+
+
+def test_cache_hit_and_miss():
+    cache = TextureCache()
+    arr = np.full((4, 4), 0.5)
+
+    first = cache.get(cache.key(arr), fake_create(arr))
+    second = cache.get(cache.key(arr.copy()), fake_create(arr))
+
+    assert first is second
+    assert (cache.hits, cache.misses) == (1, 1)
+    assert cache.nbytes == 4 * 4 * 4
+
+
+@pytest.mark.parametrize(
+    "other_key",
+    [
+        {"shape": "circle"},
+        {"lut": np.eye(3)},
+    ],
+    ids=["shape", "lut"],
+)
+def test_cache_key_includes_shape_and_lut(other_key):
+    cache = TextureCache()
+    arr = np.full((4, 4), 0.5)
+
+    first = cache.get(cache.key(arr), fake_create(arr))
+    second = cache.get(cache.key(arr, **other_key), fake_create(arr))
+
+    assert first is not second
+
+
+def test_cache_evicts_least_recently_used():
+    """Exceeding the budget deletes the least recently used texture."""
+    cache = TextureCache(budget=2 * 10 * 10 * 4)
+    arrs = [np.full((10, 10), value) for value in (0.1, 0.2, 0.3)]
+
+    textures = [cache.get(cache.key(arr), fake_create(arr)) for arr in arrs[:2]]
+    cache.get(cache.key(arrs[0]), fake_create(arrs[0]))  # use first again
+    cache.get(cache.key(arrs[2]), fake_create(arrs[2]))
+
+    assert textures[1]._txid is None
+    assert textures[0]._txid is not None
+    assert cache.evictions == 1
+    assert len(cache) == 2
+    assert cache.nbytes <= cache.budget
+
+
+def test_cache_skips_oversized_texture():
+    cache = TextureCache(budget=10)
+    arr = np.zeros((4, 4))
+
+    texture = cache.get(cache.key(arr), fake_create(arr))
+
+    assert texture._txid is not None
+    assert len(cache) == 0
+
+
+def test_cache_recreates_deleted_texture():
+    """A texture deleted by hand is recreated on the next lookup."""
+    cache = TextureCache()
+    arr = np.zeros((4, 4))
+
+    first = cache.get(cache.key(arr), fake_create(arr))
+    first.delete()
+    second = cache.get(cache.key(arr), fake_create(arr))
+
+    assert second is not first
+    assert cache.misses == 2
+    assert cache.nbytes == 4 * 4 * 4
+
+
+def test_cache_clear_and_stats():
+    cache = TextureCache()
+    arr = np.zeros((4, 4))
+    texture = cache.get(cache.key(arr), fake_create(arr))
+    cache.get(cache.key(arr), fake_create(arr))
+
+    stats = cache.stats()
+    cache.clear()
+
+    assert stats["hit_rate"] == 0.5
+    assert stats["textures"] == 1
+    assert texture._txid is None
+    assert cache.nbytes == 0
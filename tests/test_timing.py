@@ -0,0 +1,284 @@
+import threading
+import time
+
+import numpy as np
+import pytest
+
+import hrl.graphics.timing
+from hrl.graphics.timing import (
+    PSYNC_MAGIC,
+    FifoLock,
+    OnsetService,
+    RasterModel,
+    VsyncLog,
+    dropped_frames,
+    psync_pattern,
+)
+
+
+class Display:
+    """Device that displays the given frames, marking their pixel syncs."""
+
+    def __init__(self, displayed, frame_time=0.01):
+        self.displayed = displayed
+        self.frame_time = frame_time
+        self.marker = None
+        self.timed_out = False
+        self.thread = None
+
+    def DPxSetMarker(self):
+        self.marker = "pending"
+
+    def DPxUpdateRegCacheAfterPixelSync(self, n_pixels, pixel_data, timeout):
+        self.thread = threading.current_thread()
+        assert n_pixels == 2
+        frame = int.from_bytes(bytes(pixel_data[3:]), "big")
+        self.timed_out = frame not in self.displayed
+        self.marker = frame * self.frame_time
+
+    def DPxIsPsyncTimeout(self):
+        return self.timed_out
+
+    def DPxGetMarker(self):
+        return self.marker
+
+
+class TriggerDisplay(Display):
+    """Records which DOUT changes went out with each pixel sync."""
+
+    def __init__(self, displayed):
+        super().__init__(displayed)
+        self.pending = []
+        self.messages = []
+
+    def DPxSetDoutValue(self, value, mask):
+        self.pending.append(("dout", value, mask))
+
+    def DPxStartDoutSched(self):
+        self.pending.append(("sched",))
+
+    def DPxUpdateRegCacheAfterPixelSync(self, n_pixels, pixel_data, timeout):
+        assert self.marker == "pending"
+        super().DPxUpdateRegCacheAfterPixelSync(n_pixels, pixel_data, timeout)
+        self.messages.append(self.pending)
+        self.pending = []
+
+
+class LaggingDisplay(TriggerDisplay):
+    """Pixel syncs that block until released, while the display moves on."""
+
+    def __init__(self):
+        super().__init__(displayed=set())
+        self.release = threading.Event()
+        self.waited = []
+
+    def DPxUpdateRegCacheAfterPixelSync(self, n_pixels, pixel_data, timeout):
+        self.release.wait()
+        self.waited.append(int.from_bytes(bytes(pixel_data[3:]), "big"))
+        super().DPxUpdateRegCacheAfterPixelSync(n_pixels, pixel_data, timeout)
+
+
+class VsyncClock:
+    """Device reporting the given vsync times."""
+
+    def __init__(self, times, period_ns=10_000_000):
+        self.times = list(times)
+        self.period_ns = period_ns
+        self.marker = None
+        self.exhausted = threading.Event()
+        self.release = threading.Event()
+
+    def DPxGetVidVPeriod(self):
+        return self.period_ns
+
+    def DPxUpdateRegCacheAfterVideoSync(self):
+        if self.times:
+            self.marker = self.times.pop(0)
+        else:
+            self.exhausted.set()
+            self.release.wait()
+
+    def DPxGetMarker(self):
+        return self.marker
+
+
+@pytest.fixture
+def gl(fake_gl):
+    return fake_gl(hrl.graphics.timing)
+
+
+def test_psync_pattern_unique():
+    patterns = {psync_pattern(frame) for frame in range(5000)}
+
+    assert len(patterns) == 5000
+    assert all(pattern[:3] == bytes(PSYNC_MAGIC) for pattern in patterns)
+
+
+def test_onset_service_collects_onsets(gl, fake_dpx, fake_graphics):
+    display = Display(displayed={0, 1, 3})
+    service = OnsetService(fake_graphics(), dpx=fake_dpx(display))
+
+    frames = [service.tag() for _ in range(4)]
+    service.close()
+
+    assert frames == [0, 1, 2, 3]
+    assert service.onsets() == {0: 0.0, 1: 0.01, 2: None, 3: 0.03}
+    assert display.thread is not threading.main_thread()
+    assert gl.args("glDrawPixels")[1][-1] == bytes(PSYNC_MAGIC) + b"\xff" + b"\x00\x00\x01" + b"\xff"
+
+
+def test_onset_wait(gl, fake_dpx, fake_graphics):
+    service = OnsetService(fake_graphics(), dpx=fake_dpx(Display(displayed={0})))
+
+    frame = service.tag()
+
+    assert service.onset(frame, wait=True, timeout=5) == 0.0
+    assert service.onset(frame + 1) is None
+    service.close()
+
+
+def test_triggers_ride_on_pixel_sync(gl, fake_dpx, fake_graphics):
+    display = TriggerDisplay(displayed={0, 1, 2})
+    service = OnsetService(fake_graphics(), dpx=fake_dpx(display))
+
+    code = service.trigger(42)
+    service.tag()
+    service.tag()
+    pulse = service.trigger(schedule=True)
+    service.tag()
+    service.trigger(7)  # never tagged
+    service.close()
+
+    assert display.messages == [[("dout", 42, 0xFFFFFF)], [], [("sched",)]]
+    assert (code.frame, code.time) == (0, 0.0)
+    assert (pulse.frame, pulse.time) == (2, 0.02)
+    assert service.triggers() == [code, pulse]
+
+
+def test_trigger_time_unknown_on_timeout(gl, fake_dpx, fake_graphics):
+    service = OnsetService(fake_graphics(), dpx=fake_dpx(TriggerDisplay(displayed=set())))
+
+    trigger = service.trigger(1, mask=0xFF)
+    service.tag()
+    service.close()
+
+    assert trigger.frame == 0 and trigger.time is None
+
+
+def test_onset_service_skips_frames_after_timeout(gl, fake_dpx, fake_graphics):
+    display = LaggingDisplay()
+    service = OnsetService(fake_graphics(), dpx=fake_dpx(display))
+
+    # The I/O thread blocks on frame 0 while frames 1-5 are queued, and
+    # the display has moved on to frame 5 by the time it is released
+    frames = [service.tag() for _ in range(3)]
+    trigger = service.trigger(9)
+    frames += [service.tag() for _ in range(3)]
+    display.displayed = {5}
+    display.release.set()
+    service.close()
+
+    assert frames == [0, 1, 2, 3, 4, 5]
+    assert display.waited == [0, 5]
+    assert service.onsets() == {0: None, 1: None, 2: None, 3: None, 4: None, 5: 0.05}
+    # The trigger of skipped frame 3 goes out with frame 5
+    assert display.messages == [[], [("dout", 9, 0xFFFFFF)]]
+    assert (trigger.frame, trigger.time) == (5, 0.05)
+
+
+def test_vsync_log_stats_and_gaps(fake_dpx):
+    times = [0.00, 0.01, 0.02, 0.05, 0.06]
+    clock = VsyncClock(times)
+    log = VsyncLog(capacity=4, dpx=fake_dpx(clock))
+    assert clock.exhausted.wait(timeout=5)
+
+    stats = log.stats()
+    gaps = log.gaps()
+    logged = log.times()
+    clock.release.set()
+    log.close()
+
+    assert stats["vsyncs"] >= 5
+    assert stats["period"] == pytest.approx(0.01)
+    assert stats["max_interval"] == pytest.approx(0.03)
+    assert stats["gaps"] == 1
+    assert stats["missed"] == 2
+    assert gaps == [(0.02, 2)]
+    # Ring keeps the latest `capacity` vsyncs, oldest first
+    np.testing.assert_allclose(logged[:4], times[-4:])
+
+
+def test_vsync_log_pauses_for_onset_service(gl, fake_dpx, fake_graphics):
+    clock = VsyncClock([0.00, 0.01])
+    service = OnsetService(fake_graphics(), dpx=fake_dpx(Display(displayed={0})))
+    log = VsyncLog(dpx=fake_dpx(clock))
+
+    service.tag()
+    assert service.onset(0, wait=True, timeout=5) == 0.0
+    assert log.stats()["vsyncs"] == 0
+
+    service.close()
+    assert clock.exhausted.wait(timeout=5)
+    stats = log.stats()
+    clock.release.set()
+    log.close()
+
+    assert stats["vsyncs"] == 2 and stats["pauses"] == 1
+
+
+def test_fifo_lock_grants_in_request_order():
+    lock = FifoLock()
+    order = []
+
+    def take(name):
+        with lock:
+            order.append(name)
+
+    lock.acquire()
+    waiters = [threading.Thread(target=take, args=(name,)) for name in ("b", "c")]
+    for waiter in waiters:
+        waiter.start()
+        while len(lock._waiters) < waiters.index(waiter) + 1:
+            time.sleep(0.001)
+
+    # Release and take again at once, as a polling loop does
+    lock.release()
+    take("a")
+    for waiter in waiters:
+        waiter.join()
+
+    assert order == ["b", "c", "a"]
+    assert not lock.locked()
+
+
+def test_dropped_frames():
+    onsets = {0: 0.0, 1: 0.01, 2: 0.03, 3: None, 4: 0.06, 5: 0.07}
+
+    # One frame late before frame 2 and before frame 4, one onset unknown
+    assert dropped_frames(onsets, 0.01) == 3
+    assert dropped_frames([0.0, 0.01, 0.02], 0.01) == 0
+    assert dropped_frames([None, None], 0.01) == 2
+
+
+def test_raster_model_fit_and_line_times():
+    # 1125 lines, 1080 visible, 4 front porch lines; true period slightly off
+    model = RasterModel(1125, 1080, 1 / 60, front_porch=4)
+    period = 1 / 60.002
+    times = 5.0 + period * np.array([0, 1, 2, 4, 5, 6, 9])  # vsyncs missing
+
+    model.fit(times)
+
+    assert model.period == pytest.approx(period)
+    assert model.frame(5.0 + 3.5 * period) == 3
+    # Line 0 follows sync and back porch: 1125 - 1080 - 4 = 41 lines
+    assert model.line_time(0, 3) == pytest.approx(5.0 + (3 + 41 / 1125) * period)
+    top, bottom = model.line_time(np.array([0, 1079]), 0)
+    assert bottom - top == pytest.approx(1079 * period / 1125)
+    assert model.next_line_time(0, 5.0 + 0.5 * period) == pytest.approx(model.line_time(0, 1))
+
+
+def test_raster_model_stimulus_onset():
+    model = RasterModel(800, 768, 0.01)
+
+    assert model.row_onset(2.0, 400) == pytest.approx(2.0 + 400 * 0.01 / 800)
+    assert model.centre_onset(2.0, (10, 100), (50, 200)) == model.row_onset(2.0, 200)
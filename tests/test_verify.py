@@ -0,0 +1,132 @@
+import threading
+import types
+
+import numpy as np
+import pytest
+
+import hrl.graphics.verify
+from hrl.graphics.timing import OnsetService
+from hrl.graphics.verify import LineVerifier, compare_line
+
+
+class Framebuffer:
+    """Back buffer whose rows all hold the given pixels."""
+
+    def __init__(self, row):
+        self.row = row
+
+    def glReadPixels(self, x, y, wdth, hght, fmt, dtype):
+        return self.row[:wdth].tobytes()
+
+
+class LineBuffer:
+    """Device whose line buffer holds the given RGB pixels."""
+
+    def __init__(self, rgb):
+        self.rgb = rgb
+        self.thread = None
+
+    def DPxUpdateRegCacheAfterVideoSync(self):
+        self.thread = threading.current_thread()
+
+    def DPxGetVidLine(self):
+        line = np.zeros((2048, 4), dtype=np.uint16)
+        line[: len(self.rgb), :3] = self.rgb.astype(np.uint16) << 8
+        return list(line.ravel())
+
+
+@pytest.fixture
+def row():
+    rng = np.random.default_rng(0)
+    return rng.integers(0, 256, size=(64, 4), dtype=np.uint8)
+
+
+@pytest.fixture
+def graphics(fake_graphics):
+    return fake_graphics(width=64, height=48)
+
+
+def test_compare_line(row):
+    line = np.zeros((2048, 4), dtype=np.uint16)
+    line[:64, :3] = row[:, :3].astype(np.uint16) << 8
+    line[10, 1] ^= 1 << 8  # dithered low bit of green
+
+    columns, expected, actual = compare_line(row, line)
+
+    assert columns.tolist() == [10]
+    assert expected[0, 1] ^ actual[0, 1] == 1
+
+
+def test_line_verifier_samples_every_nth_flip(fake_gl, fake_dpx, graphics, row):
+    fake_gl(hrl.graphics.verify, Framebuffer(row))
+    received = row[:, :3].copy()
+    received[5] = (1, 2, 3)
+    device = LineBuffer(received)
+    dpx = fake_dpx(device)
+    verifier = LineVerifier(graphics, every=2, dpx=dpx)
+
+    sampled = []
+    for _ in range(4):
+        verifier.before_swap()
+        sampled.append(verifier.after_swap())
+    verifier.close()
+
+    assert sampled == [0, None, 2, None]
+    assert [check.flip for check in verifier.checks] == [0, 2]
+    assert dpx.names().count("DPxUpdateRegCacheAfterVideoSync") == 4
+    assert device.thread is not threading.main_thread()
+    check = verifier.failures()[0]
+    assert check.columns.tolist() == [5]
+    assert check.actual16.tolist() == [(1 << 8) | 2]
+    assert check.expected16.tolist() == [int(row[5, 0]) << 8 | int(row[5, 1])]
+
+
+def test_line_verifier_copies_row_to_top_line(fake_gl, fake_dpx, graphics, row):
+    gl = fake_gl(hrl.graphics.verify, Framebuffer(row))
+    verifier = LineVerifier(graphics, row=20, dpx=fake_dpx(LineBuffer(row[:, :3])))
+
+    verifier.before_swap()
+    verifier.after_swap()
+    verifier.wait()
+
+    assert verifier.checks[0]
+    assert [args[1] for args in gl.args("glReadPixels")] == [graphics.height - 1 - 20]
+    assert [args[-1] for args in gl.args("glDrawPixels")] == [row.tobytes()]
+    verifier.close()
+
+
+@pytest.mark.parametrize("raster_line, mismatches", [(0, []), (20, [0, 1])])
+def test_line_verifier_skips_pattern_on_top_line(fake_gl, fake_dpx, graphics, row, raster_line, mismatches):
+    fake_gl(hrl.graphics.verify, Framebuffer(row))
+    # The onset pattern is drawn after the row is copied to the top line,
+    # so only a pattern on the top line itself is captured and skipped
+    received = row[:, :3].copy()
+    received[:2] = (0xF0, 0x0F, 0xA5)
+    graphics.onset_service = types.SimpleNamespace(raster_line=raster_line)
+    verifier = LineVerifier(graphics, row=20, dpx=fake_dpx(LineBuffer(received)))
+
+    verifier.before_swap()
+    verifier.after_swap()
+    verifier.close()
+
+    assert verifier.checks[0].columns.tolist() == mismatches
+
+
+def test_line_verifier_pauses_for_onset_service(fake_gl, fake_dpx, graphics, row, monkeypatch):
+    fake_gl(hrl.graphics.verify, Framebuffer(row))
+    dpx = fake_dpx(LineBuffer(row[:, :3]))
+    verifier = LineVerifier(graphics, dpx=dpx)
+
+    monkeypatch.setattr(OnsetService, "running", 1)
+    verifier.before_swap()
+    verifier.after_swap()
+    verifier.wait()
+    monkeypatch.setattr(OnsetService, "running", 0)
+    verifier.before_swap()
+    verifier.after_swap()
+    verifier.close()
+
+    # No vsync waits while the service runs
+    assert verifier.skipped == [0]
+    assert [check.flip for check in verifier.checks] == [1]
+    assert dpx.names().count("DPxUpdateRegCacheAfterVideoSync") == 2